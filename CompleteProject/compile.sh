@@ -5,6 +5,17 @@ gcc -g tcp_client.o -o tcp_client.exe
 gcc -g -c gluethread/glthread.c -o gluethread/glthread.o
 gcc -g -c rt.c -o rt.o
 gcc -g -c notif.c -o notif.o
+gcc -g -c notif_hash.c -o notif_hash.o
+gcc -g -c notif_trie.c -o notif_trie.o
+gcc -g -c notif_slab.c -o notif_slab.o
+gcc -g -c notif_rcu.c -o notif_rcu.o
+gcc -g -c notif_async.c -o notif_async.o
+gcc -g -c notif_mailbox.c -o notif_mailbox.o
+gcc -g -c notif_conflate.c -o notif_conflate.o
+gcc -g -c notif_outq.c -o notif_outq.o
+gcc -g -c notif_shard.c -o notif_shard.o
+gcc -g -c notif_fanout.c -o notif_fanout.o
+gcc -g -c notif_post.c -o notif_post.o
 gcc -g -c publisher.c -o publisher.o
 gcc -g -c utils.c -o utils.o
 gcc -g -c threaded_subsciber.c -o threaded_subsciber.o
@@ -12,10 +23,11 @@ gcc -g -c msgq_subs.c -o msgq_subs.o
 gcc -g -c skt_subscriber.c -o skt_subscriber.o
 gcc -g -c tcp_skt_subscriber.c -o tcp_skt_subscriber.o
 gcc -g -c network_utils.c -o network_utils.o
-gcc -g rt.o publisher.o notif.o utils.o threaded_subsciber.o gluethread/glthread.o network_utils.o -o exe -lpthread
-gcc -g msgq_subs.o notif.o utils.o gluethread/glthread.o network_utils.o -o msgq_subs.exe -lpthread
-gcc -g skt_subscriber.o notif.o utils.o  gluethread/glthread.o network_utils.o -o skt_subscriber.exe -lpthread
-gcc -g tcp_skt_subscriber.o notif.o utils.o  gluethread/glthread.o network_utils.o -o tcp_skt_subscriber.exe -lpthread
+gcc -g rt.o publisher.o notif.o notif_hash.o notif_trie.o notif_slab.o notif_rcu.o notif_async.o notif_mailbox.o notif_conflate.o notif_outq.o notif_shard.o notif_fanout.o notif_post.o utils.o threaded_subsciber.o gluethread/glthread.o network_utils.o -o exe -lpthread
+gcc -g msgq_subs.o notif.o notif_hash.o notif_trie.o notif_slab.o notif_rcu.o notif_async.o notif_mailbox.o notif_conflate.o notif_outq.o notif_shard.o notif_fanout.o notif_post.o utils.o gluethread/glthread.o network_utils.o -o msgq_subs.exe -lpthread
+gcc -g skt_subscriber.o notif.o notif_hash.o notif_trie.o notif_slab.o notif_rcu.o notif_async.o notif_mailbox.o notif_conflate.o notif_outq.o notif_shard.o notif_fanout.o notif_post.o utils.o  gluethread/glthread.o network_utils.o -o skt_subscriber.exe -lpthread
+gcc -g tcp_skt_subscriber.o notif.o notif_hash.o notif_trie.o notif_slab.o notif_rcu.o notif_async.o notif_mailbox.o notif_conflate.o notif_outq.o notif_shard.o notif_fanout.o notif_post.o utils.o  gluethread/glthread.o network_utils.o -o tcp_skt_subscriber.exe -lpthread
 gcc -g -c tcp_server.c -o tcp_server.o
-gcc -g tcp_server.o notif.o utils.o network_utils.o gluethread/glthread.o -o tcp_server.exe -lpthread
-
+gcc -g tcp_server.o notif.o notif_hash.o notif_trie.o notif_slab.o notif_rcu.o notif_async.o notif_mailbox.o notif_conflate.o notif_outq.o notif_shard.o notif_fanout.o notif_post.o utils.o network_utils.o gluethread/glthread.o -o tcp_server.exe -lpthread
+gcc -g -c notif_test.c -o notif_test.o
+gcc -g notif_test.o notif.o notif_hash.o notif_trie.o notif_slab.o notif_rcu.o notif_async.o notif_mailbox.o notif_conflate.o notif_outq.o notif_shard.o notif_fanout.o notif_post.o utils.o network_utils.o gluethread/glthread.o -o notif_test.exe -lpthread
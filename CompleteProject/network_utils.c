@@ -64,7 +64,7 @@ typedef struct thread_arg_pkg_{
 	tcp_connect_cb tcp_connect_fn;
 	tcp_disconnect_cb tcp_disconnect_fn;
 	pthread_t *thread;
-	char *recv_buffer;
+	tcp_reassembly_buffer_t reassembly_buffer;
 } thread_arg_pkg_t;
 
 
@@ -132,7 +132,6 @@ _udp_server_create_and_start(void *arg){
 
         if(FD_ISSET(udp_sock_fd, &active_sock_fd_set)){
 
-            memset(recv_buffer, 0, MAX_PACKET_BUFFER_SIZE);
             bytes_recvd = recvfrom(udp_sock_fd, recv_buffer,
                     MAX_PACKET_BUFFER_SIZE, 0, 
 					(struct sockaddr *)&client_addr, &addr_len);
@@ -178,14 +177,29 @@ send_udp_msg(char *dest_ip_addr,
              char *msg,
              uint32_t msg_size,
 			 int sock_fd) {
+
+	struct iovec iov;
+
+	iov.iov_base = msg;
+	iov.iov_len = msg_size;
+
+	return send_udp_msgv(dest_ip_addr, dest_port_no, &iov, 1, sock_fd);
+}
+
+int
+send_udp_msgv(char *dest_ip_addr,
+             uint32_t dest_port_no,
+             struct iovec *iov,
+             int iov_count,
+			 int sock_fd) {
     
 	struct sockaddr_in dest;
+	struct msghdr msg_hdr;
 
     dest.sin_family = AF_INET;
     dest.sin_port = dest_port_no;
     struct hostent *host = (struct hostent *)gethostbyname(dest_ip_addr);
     dest.sin_addr = *((struct in_addr *)host->h_addr);
-    int addr_len = sizeof(struct sockaddr);
 
 	if(sock_fd < 0){
 		
@@ -196,9 +210,15 @@ send_udp_msg(char *dest_ip_addr,
 			return -1;
 		}
 	}
-    sendto(sock_fd, msg, msg_size,
-            0, (struct sockaddr *)&dest,
-            sizeof(struct sockaddr));
+
+	/* One datagram, gathered from all of iov */
+	memset(&msg_hdr, 0, sizeof(msg_hdr));
+	msg_hdr.msg_name = &dest;
+	msg_hdr.msg_namelen = sizeof(struct sockaddr);
+	msg_hdr.msg_iov = iov;
+	msg_hdr.msg_iovlen = iov_count;
+
+    sendmsg(sock_fd, &msg_hdr, 0);
     return sock_fd;
 }
 
@@ -333,9 +353,6 @@ tcp_server_cleanup_handler(void *arg){
 	free(tcp_server->tcp_server_thread);
 	tcp_server->tcp_server_thread = NULL;
 
-	free(tcp_server->recv_buffer);
-	tcp_server->recv_buffer = NULL;
-
 	tcp_remove_tcp_server_entry(tcp_server, true);
 	tcp_db_unlock();
 }
@@ -428,7 +445,6 @@ _tcp_server_create_and_start(void *arg){
 		goto CLEANUP;
 	}
 	
-	char *recv_buffer = calloc(1, MAX_PACKET_BUFFER_SIZE);
 	tcp_server_t *tcp_server = calloc(1, sizeof(tcp_server_t));
 	tcp_server->master_sock_fd = tcp_master_sock_fd;
 	tcp_server->dummy_master_sock_fd = tcp_dummy_master_sock_fd;
@@ -439,7 +455,6 @@ _tcp_server_create_and_start(void *arg){
 	tcp_server->tcp_connect_fn = tcp_connect_fn;
 	monitored_tcp_fd_set_array = tcp_server->monitored_tcp_fd_set_array;
 	tcp_server->tcp_server_thread = thread;
-	tcp_server->recv_buffer = recv_buffer;
 	init_glthread(&tcp_server->clients_list_head);
 	init_glthread(&tcp_server->glue);
 	pthread_mutex_init(&tcp_server->tcp_server_pause_mutex, NULL);
@@ -568,27 +583,23 @@ _tcp_server_create_and_start(void *arg){
 					/* Data Request from existing connection */
 					int comm_socket_fd = monitored_tcp_fd_set_array[i];
 
-					bytes_recvd = recvfrom(comm_socket_fd, recv_buffer,
-								  MAX_PACKET_BUFFER_SIZE, 0,
-								  (struct sockaddr *)&client_addr, &addr_len);
-					
-					if(bytes_recvd){
-
-						tcp_connected_client_t *tcp_connected_client = 
-							tcp_lookup_tcp_server_client_entry_by_comm_fd(
-									comm_socket_fd, false);
+					tcp_connected_client_t *tcp_connected_client = 
+						tcp_lookup_tcp_server_client_entry_by_comm_fd(
+								comm_socket_fd, false);
 
-						if(!tcp_connected_client) continue;
+					if(!tcp_connected_client) continue;
 
-						recv_fn(recv_buffer, bytes_recvd,
+					/* Pipelined messages are all handed over, a partial
+					 * one waits in the client's reassembly buffer */
+					bytes_recvd = tcp_reassembly_recv(comm_socket_fd,
+								&tcp_connected_client->reassembly_buffer,
+								recv_fn,
 								tcp_connected_client->client_ip_addr,
-								tcp_connected_client->client_tcp_port_no,
-								comm_socket_fd);	
-					}
+								tcp_connected_client->client_tcp_port_no);
 					
 					/* The connected client has Cored/Crashed/Seg fault or
  					 * or abruptly terminated for other reasons such as Ctrl-C */			
-					else {
+					if(bytes_recvd <= 0) {
 						
 						remove_from_monitored_tcp_fd_set(comm_socket_fd,
 											monitored_tcp_fd_set_array,
@@ -598,14 +609,6 @@ _tcp_server_create_and_start(void *arg){
 								monitored_tcp_fd_set_array,
 								MAX_CLIENT_TCP_CONNECTION_SUPPORTED);
 						
-						tcp_connected_client_t *tcp_connected_client = 
-							tcp_lookup_tcp_server_client_entry_by_comm_fd(
-									comm_socket_fd, false);
-						//assert(tcp_connected_client);
-						if(!tcp_connected_client) {
-							continue;
-						}
-						
 						if(tcp_disconnect_fn) {
 							tcp_disconnect_fn(
 								tcp_connected_client->client_ip_addr,
@@ -663,8 +666,7 @@ tcp_client_listener_thread_cleaner(void *arg){
 
 	int comm_fd;
 	thread_arg_pkg_t *thread_arg_pkg = (thread_arg_pkg_t *)arg;
-	assert(thread_arg_pkg->recv_buffer);
-	free(thread_arg_pkg->recv_buffer);
+	tcp_reassembly_buffer_free(&thread_arg_pkg->reassembly_buffer);
 	close(thread_arg_pkg->comm_fd);
 	comm_fd = thread_arg_pkg->comm_fd;
 	free(thread_arg_pkg->thread);
@@ -682,24 +684,20 @@ _tcp_client_listen_after_connect(void *arg){
 
 	recv_fn_cb recv_fn = thread_arg_pkg->recv_fn;
 
-	char *recv_buffer = calloc(1, MAX_PACKET_BUFFER_SIZE);
-
-	thread_arg_pkg->recv_buffer = recv_buffer;
- 
 	pthread_cleanup_push(tcp_client_listener_thread_cleaner,
 		(void *)thread_arg_pkg);
 
 	int bytes_recvd = 0;
 
 	while(1){
-		memset(recv_buffer, 0, MAX_PACKET_BUFFER_SIZE);
 		printf("blocking on read\n");
-		bytes_recvd = read(comm_fd, recv_buffer, MAX_PACKET_BUFFER_SIZE);
+		bytes_recvd = tcp_reassembly_recv(comm_fd,
+							&thread_arg_pkg->reassembly_buffer,
+							recv_fn, 0, 0);
 		if(bytes_recvd <= 0) {
 			printf("Error on Read, exiting ...\n");
 			break;
 		}
-		recv_fn(recv_buffer, bytes_recvd, 0, 0, comm_fd);	
 	}
 	/* invoke cleanup routine*/
 	pthread_cleanup_pop(0);
@@ -738,7 +736,31 @@ tcp_send_msg(char *dest_ip_addr,
              char *msg,
              uint32_t msg_size) {
 
-	int rc = 0;
+	struct iovec iov;
+
+	iov.iov_base = msg;
+	iov.iov_len = msg_size;
+
+	return tcp_send_msgv(dest_ip_addr, dest_port_no, tcp_comm_fd, &iov, 1);
+}
+
+int
+tcp_send_msgv(char *dest_ip_addr,
+			 uint32_t dest_port_no,
+			 int tcp_comm_fd,
+             struct iovec *iov,
+             int iov_count) {
+
+	int i, rc = 0;
+	uint32_t msg_size = 0, msg_len_prefix;
+	struct iovec iov_prefixed[MAX_MSGV_IOV_COUNT + 1];
+	struct msghdr msg_hdr;
+
+	if(iov_count > MAX_MSGV_IOV_COUNT) {
+		printf("%s() : Error : %d iovecs, at most %d supported\n",
+				__FUNCTION__, iov_count, MAX_MSGV_IOV_COUNT);
+		return -1;
+	}
 
 	if(tcp_comm_fd < 0) {
 		
@@ -750,12 +772,107 @@ tcp_send_msg(char *dest_ip_addr,
 		return -1;
 		}
 	}
-	
-	rc = sendto(tcp_comm_fd, msg, msg_size, 0, NULL , 0 );    
+
+	for(i = 0; i < iov_count; i++) {
+		msg_size += iov[i].iov_len;
+		iov_prefixed[i + 1] = iov[i];
+	}
+
+	msg_len_prefix = htonl(msg_size);
+
+	iov_prefixed[0].iov_base = &msg_len_prefix;
+	iov_prefixed[0].iov_len = TCP_MSG_LEN_PREFIX_SIZE;
+
+	memset(&msg_hdr, 0, sizeof(msg_hdr));
+	msg_hdr.msg_iov = iov_prefixed;
+	msg_hdr.msg_iovlen = iov_count + 1;
+
+	rc = sendmsg(tcp_comm_fd, &msg_hdr, 0);
 	printf("bytes sent = %d\n", rc);
 	return tcp_comm_fd;
 }
 
+int
+tcp_reassembly_recv(int comm_fd,
+		tcp_reassembly_buffer_t *reassembly_buffer,
+		recv_fn_cb recv_fn,
+		char *sender_ip_addr,
+		uint32_t sender_port_no){
+
+	int bytes_recvd;
+	uint32_t offset, size, msg_size = 0;
+
+	/* Room for at least a minimal read */
+	if(reassembly_buffer->size - reassembly_buffer->len <
+			TCP_REASSEMBLY_BUFFER_MIN_SIZE / 2){
+
+		size = reassembly_buffer->size ?
+			reassembly_buffer->size * 2 : TCP_REASSEMBLY_BUFFER_MIN_SIZE;
+		reassembly_buffer->buffer = realloc(reassembly_buffer->buffer, size);
+		reassembly_buffer->size = size;
+	}
+
+	bytes_recvd = recv(comm_fd,
+			reassembly_buffer->buffer + reassembly_buffer->len,
+			reassembly_buffer->size - reassembly_buffer->len, 0);
+
+	if(bytes_recvd <= 0) return bytes_recvd;
+
+	reassembly_buffer->len += bytes_recvd;
+
+	for(offset = 0;
+		reassembly_buffer->len - offset >= TCP_MSG_LEN_PREFIX_SIZE;
+		offset += TCP_MSG_LEN_PREFIX_SIZE + msg_size){
+
+		memcpy(&msg_size, reassembly_buffer->buffer + offset,
+				TCP_MSG_LEN_PREFIX_SIZE);
+		msg_size = ntohl(msg_size);
+
+		if(msg_size > TCP_MSG_MAX_SIZE){
+			printf("%s() : Error : fd %d sent a message of %u bytes, "
+					"disconnecting\n", __FUNCTION__, comm_fd, msg_size);
+			reassembly_buffer->len = 0;
+			shutdown(comm_fd, SHUT_RDWR);
+			return -1;
+		}
+
+		if(reassembly_buffer->len - offset - TCP_MSG_LEN_PREFIX_SIZE <
+				msg_size){
+			break;
+		}
+
+		recv_fn(reassembly_buffer->buffer + offset + TCP_MSG_LEN_PREFIX_SIZE,
+				msg_size, sender_ip_addr, sender_port_no, comm_fd);
+	}
+
+	/* Partial message moves to the front, grown to fit if need be */
+	reassembly_buffer->len -= offset;
+	if(offset && reassembly_buffer->len){
+		memmove(reassembly_buffer->buffer,
+				reassembly_buffer->buffer + offset,
+				reassembly_buffer->len);
+	}
+
+	if(reassembly_buffer->len >= TCP_MSG_LEN_PREFIX_SIZE){
+
+		size = TCP_MSG_LEN_PREFIX_SIZE + msg_size;
+		if(size > reassembly_buffer->size){
+			reassembly_buffer->buffer = realloc(reassembly_buffer->buffer, size);
+			reassembly_buffer->size = size;
+		}
+	}
+	return bytes_recvd;
+}
+
+void
+tcp_reassembly_buffer_free(tcp_reassembly_buffer_t *reassembly_buffer){
+
+	free(reassembly_buffer->buffer);
+	reassembly_buffer->buffer = NULL;
+	reassembly_buffer->size = 0;
+	reassembly_buffer->len = 0;
+}
+
 /* Return +ve sock fd on successfull connection
  * else return -1 */
 int
@@ -912,6 +1029,7 @@ tcp_delete_tcp_server_client_entry(
 	INSERT_UNLOCK_MGMT_CODE;
 
 	tcp_connected_client->tcp_server = NULL;
+	tcp_reassembly_buffer_free(&tcp_connected_client->reassembly_buffer);
 	free(tcp_connected_client);
 }
 
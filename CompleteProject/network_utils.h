@@ -32,11 +32,32 @@
 #include <netinet/in.h>
 #include <unistd.h>
 #include <assert.h>
+#include <sys/uio.h>
 #include "gluethread/glthread.h"
 
-#define MAX_PACKET_BUFFER_SIZE				1024
+/* Large enough for any UDP datagram, notifications carrying wide
+ * TLVs may exceed a single MTU */
+#define MAX_PACKET_BUFFER_SIZE				65535
 #define MAX_CLIENT_TCP_CONNECTION_SUPPORTED	256
 
+/* Every message on a TCP connection is preceded by its length, in
+ * network byte order, the receiver splits the stream back into
+ * messages along it */
+#define TCP_MSG_LEN_PREFIX_SIZE				4
+#define TCP_MSG_MAX_SIZE					(16 * 1024 * 1024)
+#define TCP_REASSEMBLY_BUFFER_MIN_SIZE		16384
+
+/* Most pieces a message can be gathered from by the *_msgv() APIs */
+#define MAX_MSGV_IOV_COUNT					16
+
+/* Bytes received on a TCP connection, not handed to recv_fn yet */
+typedef struct tcp_reassembly_buffer_{
+
+	char *buffer;
+	uint32_t size;
+	uint32_t len;
+} tcp_reassembly_buffer_t;
+
 
 typedef void (*recv_fn_cb)(char *,		/* msg recvd */
 						   uint32_t,	/* recvd msg size */
@@ -71,7 +92,6 @@ typedef struct tcp_server_{
     int monitored_tcp_fd_set_array
 		[MAX_CLIENT_TCP_CONNECTION_SUPPORTED];
 	pthread_t *tcp_server_thread;
-	char *recv_buffer;
 	pthread_mutex_t tcp_server_pause_mutex;
 	/* 	Other properties below
 		< other tcp server properties >
@@ -91,6 +111,7 @@ typedef struct tcp_connected_client_{
 	char client_ip_addr[16];
 	uint32_t client_tcp_port_no;
 	tcp_server_t *tcp_server; /* back pointer */
+	tcp_reassembly_buffer_t reassembly_buffer;
 	glthread_t glue;
 } tcp_connected_client_t;
 GLTHREAD_TO_STRUCT(glue_to_tcp_connected_client,
@@ -229,6 +250,15 @@ send_udp_msg(char *dest_ip_addr,
 			 uint32_t msg_size,
 			 int sock_fd);
 
+/* As send_udp_msg(), the datagram gathered from iov_count pieces */
+int
+send_udp_msgv(char *dest_ip_addr,
+			 uint32_t udp_port_no,
+			 struct iovec *iov,
+			 int iov_count,
+			 int sock_fd);
+
+/* msg goes out behind its TCP_MSG_LEN_PREFIX_SIZE length */
 int
 tcp_send_msg(char *dest_ip_addr,
 			 uint32_t dst_port_no,
@@ -236,6 +266,28 @@ tcp_send_msg(char *dest_ip_addr,
 			 char *msg,
 			 uint32_t msg_size);
 
+/* As tcp_send_msg(), the message gathered from at most
+ * MAX_MSGV_IOV_COUNT pieces, sent with a single sendmsg() */
+int
+tcp_send_msgv(char *dest_ip_addr,
+			 uint32_t dst_port_no,
+			 int tcp_comm_fd,
+			 struct iovec *iov,
+			 int iov_count);
+
+/* Reads what comm_fd has into reassembly_buffer, and hands recv_fn
+ * every message completed, in place. Returns the no of bytes read,
+ * <= 0 once the connection is gone or broke the framing */
+int
+tcp_reassembly_recv(int comm_fd,
+			 tcp_reassembly_buffer_t *reassembly_buffer,
+			 recv_fn_cb recv_fn,
+			 char *sender_ip_addr,
+			 uint32_t sender_port_no);
+
+void
+tcp_reassembly_buffer_free(tcp_reassembly_buffer_t *reassembly_buffer);
+
 void
 tcp_force_disconnect_client_by_ip_addr_port(
 		char *ip_addr,
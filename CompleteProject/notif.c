@@ -39,55 +39,277 @@
 #include <unistd.h> // for close
 #include <netdb.h>  /*for struct hostent*/
 #include "notif.h"
+#include "notif_slab.h"
+#include "notif_rcu.h"
+#include "notif_mailbox.h"
+#include "notif_conflate.h"
+#include "notif_shard.h"
+#include "notif_fanout.h"
+#include "notif_post.h"
 #include "utils.h"
 #include "network_utils.h"
 
-static notif_chain_db_t notif_chain_db = {{0,0}, {0,0}};
+#define NOTIF_CHAIN_WILDCARD_SUBS_INIT_SIZE	8
+
+static notif_chain_db_t notif_chain_db = {
+	.mutex = PTHREAD_MUTEX_INITIALIZER
+};
+
+static notif_slab_t notif_chain_elem_slab = 
+	NOTIF_SLAB_INITIALIZER("notif_chain_elem_t",
+		sizeof(notif_chain_elem_t));
+static notif_slab_t notif_chain_comm_channel_slab = 
+	NOTIF_SLAB_INITIALIZER("notif_chain_comm_channel_t",
+		sizeof(notif_chain_comm_channel_t));
+static notif_slab_t comm_channel_per_client_db_slab = 
+	NOTIF_SLAB_INITIALIZER("comm_channel_per_client_db_t",
+		sizeof(comm_channel_per_client_db_t));
+static notif_slab_t notif_chain_client_subs_slab = 
+	NOTIF_SLAB_INITIALIZER("notif_chain_client_subs_t",
+		sizeof(notif_chain_client_subs_t));
+static notif_slab_t notif_chain_key_bucket_slab = 
+	NOTIF_SLAB_INITIALIZER("notif_chain_key_bucket_t",
+		sizeof(notif_chain_key_bucket_t));
+
+static uint32_t
+notif_chain_compute_name_hash(char *notif_chain_name){
+
+	return notif_hash_bytes(notif_chain_name,
+			strnlen(notif_chain_name, NOTIF_NAME_SIZE),
+			NOTIF_HASH_SEED);
+}
+
+static uint32_t
+notif_chain_compute_client_hash(uint32_t client_id){
+
+	return notif_hash_bytes(&client_id, sizeof(client_id), NOTIF_HASH_SEED);
+}
 
 static void 
 notif_chain_register_notif_chain(notif_chain_t *notif_chain){
 
+	pthread_mutex_lock(&notif_chain_db.mutex);
+
 	glthread_add_next(&notif_chain_db.notif_chain_head,
 					  &notif_chain->glue);
+
+	notif_hash_table_insert(&notif_chain_db.notif_chain_name_index,
+							notif_chain->name_hash,
+							(void *)notif_chain);
+
+	pthread_mutex_unlock(&notif_chain_db.mutex);
+	notif_rcu_reclaim();
+}
+
+/* Once this returns, no lookup by name is on notif_chain anymore */
+static void
+notif_chain_deregister_notif_chain(notif_chain_t *notif_chain){
+
+	bool registered;
+
+	pthread_mutex_lock(&notif_chain_db.mutex);
+
+	/* Shards are never registered */
+	registered = notif_hash_table_remove(
+			&notif_chain_db.notif_chain_name_index,
+			notif_chain->name_hash,
+			(void *)notif_chain);
+	remove_glthread(&notif_chain->glue);
+
+	pthread_mutex_unlock(&notif_chain_db.mutex);
+
+	if(registered){
+		notif_rcu_synchronize();
+		notif_rcu_reclaim();
+	}
 }
 
 static notif_chain_t *
 notif_chain_lookup_notif_chain_by_name(char *notif_chain_name){
 
-	glthread_t *curr;
-	notif_chain_t *notif_chain;
+	uint32_t name_hash;
+	notif_hash_entry_t *entry;
+	notif_chain_t *notif_chain, *found = NULL;
+
+	name_hash = notif_chain_compute_name_hash(notif_chain_name);
 
-	ITERATE_GLTHREAD_BEGIN(&notif_chain_db.notif_chain_head, curr){
+	/* A chain stays valid until notif_chain_delete(), which waits
+	 * for the lookups in progress to be done with it */
+	notif_rcu_read_lock();
 
-		notif_chain = glthread_glue_to_notif_chain(curr);
+	ITERATE_NOTIF_HASH_BUCKET_BEGIN(&notif_chain_db.notif_chain_name_index,
+			name_hash, entry){
+
+		notif_chain = (notif_chain_t *)entry->data;
 
 		if(strncmp(notif_chain->name,
 		   notif_chain_name, NOTIF_NAME_SIZE) == 0){
-		   return notif_chain;
+		   found = notif_chain;
+		   break;
 		}
 
-	} ITERATE_GLTHREAD_END(&notif_chain_db.notif_chain_head, curr)
+	} ITERATE_NOTIF_HASH_BUCKET_END(&notif_chain_db.notif_chain_name_index,
+			name_hash, entry);
 
-	return NULL;
+	notif_rcu_read_unlock();
+	return found;
 }
 
 
 void
-notif_chain_init(notif_chain_t *notif_chain,
+notif_chain_init_internals(notif_chain_t *notif_chain,
 		char *chain_name,
 		notif_chain_comp_cb comp_cb,
-		app_key_data_print_cb print_cb){
+		app_key_data_print_cb print_cb,
+		notif_chain_key_hash_cb key_hash_cb){
 
 	memset(notif_chain, 0, sizeof(notif_chain_t));
 	strncpy(notif_chain->name, chain_name, sizeof(notif_chain->name));
 	notif_chain->name[sizeof(notif_chain->name) -1] = '\0';
+	notif_chain->name_hash = notif_chain_compute_name_hash(notif_chain->name);
 	notif_chain->comp_cb = comp_cb;
 	notif_chain->print_cb = print_cb;
+	notif_chain->key_hash_cb = key_hash_cb;
+	pthread_mutex_init(&notif_chain->mutex, NULL);
 	init_glthread(&notif_chain->notif_chain_elem_head);
 	init_glthread(&notif_chain->glue);
+}
+
+void
+notif_chain_init(notif_chain_t *notif_chain,
+		char *chain_name,
+		notif_chain_comp_cb comp_cb,
+		app_key_data_print_cb print_cb,
+		notif_chain_key_hash_cb key_hash_cb){
+
+	notif_chain_init_internals(notif_chain, chain_name,
+			comp_cb, print_cb, key_hash_cb);
 	notif_chain_register_notif_chain(notif_chain);
 }
 
+bool
+notif_chain_enable_prefix_match(notif_chain_t *notif_chain,
+		notif_chain_key_prefix_cb key_prefix_cb){
+
+	pthread_mutex_lock(&notif_chain->mutex);
+
+	if(!IS_GLTHREAD_LIST_EMPTY(&notif_chain->notif_chain_elem_head)){
+		pthread_mutex_unlock(&notif_chain->mutex);
+		printf("%s() : Error : Notif Chain %s already has subscribers\n",
+				__FUNCTION__, notif_chain->name);
+		return false;
+	}
+
+	if(notif_chain->shards){
+		pthread_mutex_unlock(&notif_chain->mutex);
+		printf("%s() : Error : Notif Chain %s is sharded\n",
+				__FUNCTION__, notif_chain->name);
+		return false;
+	}
+	notif_chain->key_prefix_cb = key_prefix_cb;
+
+	pthread_mutex_unlock(&notif_chain->mutex);
+	return true;
+}
+
+/* Hash of the fields notif_chain_communication_channel_match()
+ * compares, so that matching channels share a bucket */
+static uint32_t
+notif_chain_compute_comm_channel_hash(uint32_t client_id,
+		notif_chain_comm_channel_t *channel){
+
+	uint32_t hash;
+
+	hash = notif_hash_bytes(&channel->notif_ch_type,
+				sizeof(channel->notif_ch_type),
+				notif_chain_compute_client_hash(client_id));
+
+	switch(channel->notif_ch_type){
+
+		case NOTIF_C_CALLBACKS:
+			hash = notif_hash_bytes(&NOTIF_CHAIN_ELEM_APP_CB(channel),
+						sizeof(NOTIF_CHAIN_ELEM_APP_CB(channel)), hash);
+			return notif_hash_bytes(&NOTIF_CHAIN_ELEM_MAILBOX(channel),
+						sizeof(NOTIF_CHAIN_ELEM_MAILBOX(channel)), hash);
+		case NOTIF_C_MSG_Q:
+			return notif_hash_bytes(NOTIF_CHAIN_ELEM_MSGQ_NAME(channel),
+						strnlen(NOTIF_CHAIN_ELEM_MSGQ_NAME(channel),
+							NOTIF_C_COMM_CHANNEL_MSGQ_NAME_VALUE_LEN), hash);
+		case NOTIF_C_AF_UNIX:
+			return notif_hash_bytes(NOTIF_CHAIN_ELEM_SKT_NAME(channel),
+						strnlen(NOTIF_CHAIN_ELEM_SKT_NAME(channel),
+							NOTIF_C_COMM_CHANNEL_UNIX_SKT_NAME_VALUE_LEN), hash);
+		case NOTIF_C_INET_SOCKETS:
+			hash = notif_hash_bytes(&NOTIF_CHAIN_ELEM_IP_ADDR(channel),
+						sizeof(NOTIF_CHAIN_ELEM_IP_ADDR(channel)), hash);
+			hash = notif_hash_bytes(&NOTIF_CHAIN_ELEM_PORT_NO(channel),
+						sizeof(NOTIF_CHAIN_ELEM_PORT_NO(channel)), hash);
+			return notif_hash_bytes(&NOTIF_CHAIN_ELEM_PROTO(channel),
+						sizeof(NOTIF_CHAIN_ELEM_PROTO(channel)), hash);
+		case NOTIF_C_NOT_KNOWN:
+		default:
+			return hash;
+	}
+}
+
+static comm_channel_per_client_db_t *
+notif_chain_lookup_comm_channel_per_client_db(uint32_t client_id){
+
+	uint32_t client_hash;
+	notif_hash_entry_t *entry;
+	comm_channel_per_client_db_t *comm_channel_per_client_db;
+
+	client_hash = notif_chain_compute_client_hash(client_id);
+
+	ITERATE_NOTIF_HASH_BUCKET_BEGIN(
+		&notif_chain_db.comm_channel_per_client_db_index,
+		client_hash, entry){
+
+		comm_channel_per_client_db = 
+			(comm_channel_per_client_db_t *)entry->data;
+
+		if(comm_channel_per_client_db->client_id == client_id){
+			return comm_channel_per_client_db;
+		}
+	} ITERATE_NOTIF_HASH_BUCKET_END(
+		&notif_chain_db.comm_channel_per_client_db_index,
+		client_hash, entry);
+
+	return NULL;
+}
+
+/* Undo notif_chain_record_comm_channel_per_client() for a channel
+ * no longer in use, dropping the client db once it is empty.
+ * Called with notif_chain_db.mutex held */
+static void
+notif_chain_unrecord_comm_channel_per_client(
+		notif_chain_comm_channel_t *channel){
+
+	comm_channel_per_client_db_t *comm_channel_per_client_db;
+
+	if(!notif_hash_table_remove(&notif_chain_db.comm_channel_index,
+				channel->channel_hash, (void *)channel)){
+		return;
+	}
+
+	remove_glthread(&channel->glue);
+
+	comm_channel_per_client_db = 
+		notif_chain_lookup_comm_channel_per_client_db(channel->client_id);
+
+	if(!comm_channel_per_client_db ||
+		!IS_GLTHREAD_LIST_EMPTY(&comm_channel_per_client_db->comm_channel_head)){
+		return;
+	}
+
+	remove_glthread(&comm_channel_per_client_db->glue);
+	notif_hash_table_remove(&notif_chain_db.comm_channel_per_client_db_index,
+			notif_chain_compute_client_hash(channel->client_id),
+			(void *)comm_channel_per_client_db);
+	notif_slab_free(&comm_channel_per_client_db_slab,
+			comm_channel_per_client_db);
+}
+
 static void
 notif_chain_release_inet_skt_comm_channel_resource(
 		notif_chain_comm_channel_t *channel){
@@ -108,20 +330,45 @@ notif_chain_release_inet_skt_comm_channel_resource(
 #endif
 }
 
+/* Takes one more reference on a channel already recorded */
+static void
+notif_chain_hold_comm_channel(notif_chain_comm_channel_t *channel){
+
+	pthread_mutex_lock(&notif_chain_db.mutex);
+	channel->ref_count++;
+	pthread_mutex_unlock(&notif_chain_db.mutex);
+}
+
+static void
+notif_chain_free_retired_comm_channel(void *channel){
+
+	notif_outq_destroy(((notif_chain_comm_channel_t *)channel)->outq);
+	notif_slab_free(&notif_chain_comm_channel_slab, channel);
+}
+
+/* Channel memory is retired rather than freed, notif_chain_invoke()
+ * may still be delivering through it */
 void
 notif_chain_release_communication_channel_resources(
 		notif_chain_comm_channel_t *channel){
 
 	notif_ch_type_t notif_ch_type;
 
+	pthread_mutex_lock(&notif_chain_db.mutex);
+
 	channel->ref_count--;
 	
 	if(channel->ref_count) {
+		pthread_mutex_unlock(&notif_chain_db.mutex);
 		return;
 	}
 
 	notif_ch_type = channel->notif_ch_type;
 
+	notif_chain_unrecord_comm_channel_per_client(channel);
+
+	pthread_mutex_unlock(&notif_chain_db.mutex);
+
 	switch(notif_ch_type){
 
 		case NOTIF_C_CALLBACKS:
@@ -140,361 +387,1740 @@ notif_chain_release_communication_channel_resources(
 		case NOTIF_C_NOT_KNOWN:
 		default:    ;
 	}
-	remove_glthread(&channel->glue);
-	free(channel);
+	notif_rcu_retire(channel, notif_chain_free_retired_comm_channel);
 }
 
-void
-notif_chain_free_notif_chain_elem_internals(
+/* Subscriber lists hanging off the matching indexes are singly
+ * linked through index_next, index_pprev points to whichever
+ * pointer points to the element so that removal is O(1).
+ * notif_chain_invoke() walks index_next without lock, so the
+ * element is published only once fully linked */
+static void
+notif_chain_subs_list_add(notif_chain_elem_t **subs_head,
 		notif_chain_elem_t *notif_chain_elem){
 
-	if(notif_chain_elem->data.app_key_data){
-		free(notif_chain_elem->data.app_key_data);
+	notif_chain_elem->index_next = *subs_head;
+	if(*subs_head){
+		(*subs_head)->index_pprev = &notif_chain_elem->index_next;
 	}
-	notif_chain_elem->data.app_key_data = 0;
-	notif_chain_elem->data.app_key_data_size = 0;
+	notif_chain_elem->index_pprev = subs_head;
+	NOTIF_RCU_ASSIGN_POINTER(*subs_head, notif_chain_elem);
+}
 
-	if(notif_chain_elem->data.is_alloc_app_data_to_notify){
-		free(notif_chain_elem->data.app_data_to_notify);
+/* index_next of the removed element is left intact, readers
+ * standing on it still get to the rest of the list */
+static void
+notif_chain_subs_list_remove(notif_chain_elem_t *notif_chain_elem){
+
+	if(!notif_chain_elem->index_pprev) return;
+
+	NOTIF_RCU_ASSIGN_POINTER(*notif_chain_elem->index_pprev,
+			notif_chain_elem->index_next);
+	if(notif_chain_elem->index_next){
+		notif_chain_elem->index_next->index_pprev = 
+			notif_chain_elem->index_pprev;
 	}
-	notif_chain_elem->data.app_data_to_notify = 0;
-	notif_chain_elem->data.app_data_to_notify_size = 0;
-	
-	notif_chain_release_communication_channel_resources(
-			notif_chain_elem->notif_chain_comm_channel);
+	notif_chain_elem->index_pprev = NULL;
+}
 
-	notif_chain_elem->notif_chain_comm_channel = 0;
+static notif_chain_wildcard_subs_t *
+notif_chain_wildcard_subs_alloc(uint32_t size){
+
+	notif_chain_wildcard_subs_t *wildcard_subs;
+
+	wildcard_subs = calloc(1, sizeof(notif_chain_wildcard_subs_t) +
+				size * sizeof(notif_chain_elem_t *));
+	wildcard_subs->size = size;
+	return wildcard_subs;
 }
 
-void
-notif_chain_free_notif_chain_elem(
+/* Appends in place while there is room, readers pick the new slot
+ * up with count. Else the set is copied into a bigger one */
+static void
+notif_chain_wildcard_subs_add(notif_chain_t *notif_chain,
 		notif_chain_elem_t *notif_chain_elem){
 
-	notif_chain_free_notif_chain_elem_internals(
-			notif_chain_elem);
+	notif_chain_wildcard_subs_t *wildcard_subs = notif_chain->wildcard_subs;
+	notif_chain_wildcard_subs_t *new_wildcard_subs;
 
-	free(notif_chain_elem); 
-}
+	if(wildcard_subs && wildcard_subs->count < wildcard_subs->size){
 
-void
-notif_chain_delete(notif_chain_t *notif_chain){
+		wildcard_subs->elems[wildcard_subs->count] = notif_chain_elem;
+		__atomic_store_n(&wildcard_subs->count,
+				wildcard_subs->count + 1, __ATOMIC_RELEASE);
+		return;
+	}
 
-	glthread_t *curr;
-	notif_chain_elem_t *notif_chain_elem;
+	new_wildcard_subs = notif_chain_wildcard_subs_alloc(wildcard_subs ?
+			wildcard_subs->size << 1 : NOTIF_CHAIN_WILDCARD_SUBS_INIT_SIZE);
 
-	ITERATE_GLTHREAD_BEGIN(&notif_chain->notif_chain_elem_head, curr){
+	if(wildcard_subs){
+		memcpy(new_wildcard_subs->elems, wildcard_subs->elems,
+				wildcard_subs->count * sizeof(notif_chain_elem_t *));
+		new_wildcard_subs->count = wildcard_subs->count;
+	}
+	new_wildcard_subs->elems[new_wildcard_subs->count++] = notif_chain_elem;
 
-		remove_glthread(&notif_chain_elem->glue);
-		notif_chain_free_notif_chain_elem(notif_chain_elem);
-	} ITERATE_GLTHREAD_END(&notif_chain->notif_chain_elem_head, curr);
+	NOTIF_RCU_ASSIGN_POINTER(notif_chain->wildcard_subs, new_wildcard_subs);
+	notif_rcu_retire(wildcard_subs, free);
 }
 
-static int
-notif_chain_elem_cmp_fn(void *elem1, void *elem2){
+/* Readers may be walking the set, so a copy without the element
+ * replaces it. O(n) in the no of wildcard subscribers */
+static void
+notif_chain_wildcard_subs_remove(notif_chain_t *notif_chain,
+		notif_chain_elem_t *notif_chain_elem){
 
-	notif_chain_elem_t *notif_chain_elem1 = 
-			(notif_chain_elem_t *)elem1;
+	uint32_t i;
+	notif_chain_wildcard_subs_t *wildcard_subs = notif_chain->wildcard_subs;
+	notif_chain_wildcard_subs_t *new_wildcard_subs = NULL;
 
-	notif_chain_elem_t *notif_chain_elem2 = 
-			(notif_chain_elem_t *)elem2;
+	assert(wildcard_subs && wildcard_subs->count);
 
-	if(notif_chain_elem1->client_id < notif_chain_elem2->client_id)
-		return -1;
-	else if(notif_chain_elem1->client_id > notif_chain_elem2->client_id)
-		return 1;
-	return 0;
-}
+	if(wildcard_subs->count > 1){
 
-notif_chain_elem_t *
-notif_chain_notif_chain_elem_clone(
-	notif_chain_elem_t *notif_chain_elem){
+		new_wildcard_subs = notif_chain_wildcard_subs_alloc(wildcard_subs->size);
 
-	notif_chain_elem_t *new_notif_chain_elem = 
-		calloc(1, sizeof(notif_chain_elem_t));
+		for(i = 0; i < wildcard_subs->count; i++){
+			if(wildcard_subs->elems[i] == notif_chain_elem) continue;
+			new_wildcard_subs->elems[new_wildcard_subs->count++] = 
+				wildcard_subs->elems[i];
+		}
+		assert(new_wildcard_subs->count == wildcard_subs->count - 1);
+	}
 
-	memcpy(new_notif_chain_elem, notif_chain_elem,
-		sizeof(notif_chain_elem_t));
+	NOTIF_RCU_ASSIGN_POINTER(notif_chain->wildcard_subs, new_wildcard_subs);
+	notif_rcu_retire(wildcard_subs, free);
+}
 
-	if(notif_chain_elem->data.app_key_data && 
-		notif_chain_elem->data.app_key_data_size){
+static uint32_t
+notif_chain_compute_subs_hash(uint32_t client_id,
+		void *app_key_data,
+		uint32_t app_key_data_size){
 
-		new_notif_chain_elem->data.app_key_data = 
-			calloc(1, notif_chain_elem->data.app_key_data_size);
-		memcpy(new_notif_chain_elem->data.app_key_data,
-			   notif_chain_elem->data.app_key_data,
-			   notif_chain_elem->data.app_key_data_size);
-		new_notif_chain_elem->data.app_key_data_size = 
-			  notif_chain_elem->data.app_key_data_size;
-	}
+	return notif_hash_bytes(app_key_data, app_key_data_size,
+			notif_chain_compute_client_hash(client_id));
+}
 
-	if(notif_chain_elem->data.app_data_to_notify &&
-		notif_chain_elem->data.app_data_to_notify_size){
+static notif_chain_client_subs_t *
+notif_chain_lookup_client_subs(notif_chain_t *notif_chain,
+		uint32_t client_id){
 
-		new_notif_chain_elem->data.app_data_to_notify = 
-			calloc(1, notif_chain_elem->data.app_data_to_notify_size);
-		memcpy(new_notif_chain_elem->data.app_data_to_notify,
-				notif_chain_elem->data.app_data_to_notify,
-				notif_chain_elem->data.app_data_to_notify_size);
-		new_notif_chain_elem->data.app_data_to_notify_size = 
-				notif_chain_elem->data.app_data_to_notify_size;
-		new_notif_chain_elem->data.is_alloc_app_data_to_notify = true;
-	}
+	uint32_t client_hash;
+	notif_hash_entry_t *entry;
+	notif_chain_client_subs_t *client_subs;
 
-	init_glthread(&new_notif_chain_elem->glue);
+	client_hash = notif_chain_compute_client_hash(client_id);
 
-	new_notif_chain_elem->notif_chain_comm_channel = 
-		calloc(1, sizeof(notif_chain_comm_channel_t));
+	ITERATE_NOTIF_HASH_BUCKET_BEGIN(&notif_chain->client_index,
+			client_hash, entry){
 
-	memcpy(new_notif_chain_elem->notif_chain_comm_channel,
-		   notif_chain_elem->notif_chain_comm_channel,
-		   sizeof(notif_chain_comm_channel_t));
-		
-	init_glthread(&new_notif_chain_elem->notif_chain_comm_channel->glue);
-	new_notif_chain_elem->notif_chain_comm_channel->ref_count = 0;
-	
-	return new_notif_chain_elem;
+		client_subs = (notif_chain_client_subs_t *)entry->data;
+		if(client_subs->client_id == client_id) return client_subs;
+	} ITERATE_NOTIF_HASH_BUCKET_END(&notif_chain->client_index,
+			client_hash, entry);
+
+	return NULL;
 }
 
-bool
-notif_chain_register_chain_element(
-		notif_chain_t *notif_chain,
+static void
+notif_chain_client_index_add(notif_chain_t *notif_chain,
 		notif_chain_elem_t *notif_chain_elem){
 
-	notif_chain_elem_t *new_notif_chain_elem;
-	notif_chain_comm_channel_t *notif_chain_comm_channel,
-							   *registered_notif_chain_comm_channel;
+	notif_chain_client_subs_t *client_subs;
 
-    if (notif_chain_lookup_notif_chain_element(
-						notif_chain,
-						notif_chain_elem->client_id,
-						notif_chain_elem->data.app_key_data,
-						notif_chain_elem->data.app_key_data_size)) {
+	client_subs = notif_chain_lookup_client_subs(notif_chain,
+			notif_chain_elem->client_id);
 
-		return false;
+	if(!client_subs){
+		client_subs = notif_slab_alloc(&notif_chain_client_subs_slab);
+		client_subs->client_id = notif_chain_elem->client_id;
+		init_glthread(&client_subs->subs_head);
+		notif_hash_table_insert(&notif_chain->client_index,
+				notif_chain_compute_client_hash(client_subs->client_id),
+				(void *)client_subs);
 	}
+	glthread_add_next(&client_subs->subs_head,
+			&notif_chain_elem->client_glue);
+}
 
-	new_notif_chain_elem = notif_chain_notif_chain_elem_clone(
-							notif_chain_elem);
-
-	glthread_priority_insert(&notif_chain->notif_chain_elem_head,
-							 &new_notif_chain_elem->glue,
-							 notif_chain_elem_cmp_fn,
-							 (int)(&((notif_chain_elem_t *)0)->glue));
-	
-	/* Now handle communication channel */
-	notif_chain_comm_channel = new_notif_chain_elem->notif_chain_comm_channel;
-	assert(notif_chain_comm_channel);
+static void
+notif_chain_client_index_remove(notif_chain_t *notif_chain,
+		notif_chain_elem_t *notif_chain_elem){
 
-	registered_notif_chain_comm_channel = 
-			notif_chain_record_comm_channel_per_client(
-			    new_notif_chain_elem->client_id,
-				notif_chain_comm_channel);
+	notif_chain_client_subs_t *client_subs;
 
-	if (registered_notif_chain_comm_channel !=
-			notif_chain_comm_channel) {
-		/* It means, existing communication channel is 
- 		 * there in db */
-		new_notif_chain_elem->notif_chain_comm_channel = 
-				registered_notif_chain_comm_channel;
-		free(notif_chain_comm_channel);
-	}			
-	return true;
-}
+	remove_glthread(&notif_chain_elem->client_glue);
 
-bool
-notif_chain_communication_channel_match(
-		notif_chain_comm_channel_t *channel1,
-		notif_chain_comm_channel_t *channel2){
+	client_subs = notif_chain_lookup_client_subs(notif_chain,
+			notif_chain_elem->client_id);
 
-	if(channel1->notif_ch_type != channel2->notif_ch_type)
-		return false;
+	if(!client_subs ||
+		!IS_GLTHREAD_LIST_EMPTY(&client_subs->subs_head)) return;
 
-	notif_ch_type_t notif_ch_type = channel1->notif_ch_type;
+	notif_hash_table_remove(&notif_chain->client_index,
+			notif_chain_compute_client_hash(client_subs->client_id),
+			(void *)client_subs);
+	notif_slab_free(&notif_chain_client_subs_slab, client_subs);
+}
 
-	switch(notif_ch_type){
+static bool
+notif_chain_key_match(notif_chain_t *notif_chain,
+		void *app_key_data1, uint32_t app_key_data_size1,
+		void *app_key_data2, uint32_t app_key_data_size2){
 
-		case NOTIF_C_CALLBACKS:
-			if(NOTIF_CHAIN_ELEM_APP_CB(channel1) != 
-					NOTIF_CHAIN_ELEM_APP_CB(channel2))
-				return false;
-			return true;
-		case NOTIF_C_MSG_Q:
-			if(strncmp(NOTIF_CHAIN_ELEM_MSGQ_NAME(channel1),
-						NOTIF_CHAIN_ELEM_MSGQ_NAME(channel2),
-						NOTIF_C_COMM_CHANNEL_MSGQ_NAME_VALUE_LEN))
-				return false;
-			return true;
-		case NOTIF_C_AF_UNIX:
-			if(strncmp(NOTIF_CHAIN_ELEM_SKT_NAME(channel1),
-						NOTIF_CHAIN_ELEM_SKT_NAME(channel2),
-						NOTIF_C_COMM_CHANNEL_UNIX_SKT_NAME_VALUE_LEN))
-				return false;
-			return true;
-		case NOTIF_C_INET_SOCKETS:
-			if((NOTIF_CHAIN_ELEM_IP_ADDR(channel1) == 
-						NOTIF_CHAIN_ELEM_IP_ADDR(channel2)) 
-					&&
-					(NOTIF_CHAIN_ELEM_PORT_NO(channel1) ==
-					 NOTIF_CHAIN_ELEM_PORT_NO(channel2))
-					&&
-					(NOTIF_CHAIN_ELEM_PROTO(channel1) == 
-					 NOTIF_CHAIN_ELEM_PROTO(channel2)))
-				return true;
-			return false;
-		case NOTIF_C_NOT_KNOWN:
-			return true;
-		default:
-			return true;
+	if(notif_chain->comp_cb){
+		return notif_chain->comp_cb(app_key_data1, app_key_data_size1,
+					app_key_data2, app_key_data_size2) == 0;
 	}
-	return true;
+	return (app_key_data_size1 == app_key_data_size2 &&
+			memcmp(app_key_data1, app_key_data2, app_key_data_size1) == 0);
 }
 
-bool
-notif_chain_deregister_chain_element(notif_chain_t *notif_chain,
-		notif_chain_elem_t *notif_chain_elem){
-
-	glthread_t *curr;
-	bool is_removed = false;
-	notif_chain_elem_t *notif_chain_elem_curr;
-	notif_chain_comm_channel_t *notif_chain_comm_channel;
+static notif_chain_key_bucket_t *
+notif_chain_lookup_key_bucket(notif_chain_t *notif_chain,
+		uint32_t key_hash,
+		void *app_key_data,
+		uint32_t app_key_data_size){
 
-	notif_chain_comm_channel = notif_chain_elem->notif_chain_comm_channel;
+	notif_hash_entry_t *entry;
+	notif_chain_key_bucket_t *key_bucket;
 
-	ITERATE_GLTHREAD_BEGIN(&notif_chain->notif_chain_elem_head, curr){
+	ITERATE_NOTIF_HASH_BUCKET_BEGIN(&notif_chain->key_index,
+			key_hash, entry){
 
-		notif_chain_elem_curr = glthread_glue_to_notif_chain_elem(curr);
-	
-		if(notif_chain_elem_curr->client_id != 
-				notif_chain_elem->client_id){
+		key_bucket = (notif_chain_key_bucket_t *)entry->data;
 
-			continue;
+		if(notif_chain_key_match(notif_chain,
+				key_bucket->app_key_data,
+				key_bucket->app_key_data_size,
+				app_key_data, app_key_data_size)){
+			return key_bucket;
 		}
+	} ITERATE_NOTIF_HASH_BUCKET_END(&notif_chain->key_index,
+			key_hash, entry);
 
-		if(notif_chain->comp_cb &&
-				notif_chain->comp_cb(
+	return NULL;
+}
+
+static notif_chain_key_bucket_t *
+notif_chain_key_bucket_create(
+		notif_chain_elem_t *notif_chain_elem,
+		uint32_t key_hash){
+
+	notif_chain_key_bucket_t *key_bucket;
+
+	key_bucket = notif_slab_alloc(&notif_chain_key_bucket_slab);
+	key_bucket->app_key_data = 
+		calloc(1, notif_chain_elem->data.app_key_data_size);
+	memcpy(key_bucket->app_key_data,
+			notif_chain_elem->data.app_key_data,
+			notif_chain_elem->data.app_key_data_size);
+	key_bucket->app_key_data_size = 
+		notif_chain_elem->data.app_key_data_size;
+	key_bucket->key_hash = key_hash;
+	return key_bucket;
+}
+
+static void
+notif_chain_key_bucket_free(void *arg){
+
+	notif_chain_key_bucket_t *key_bucket = (notif_chain_key_bucket_t *)arg;
+
+	free(key_bucket->app_key_data);
+	notif_slab_free(&notif_chain_key_bucket_slab, key_bucket);
+}
+
+/* Make the element reachable through the matching index
+ * of the chain. Wildcard elements go to the wildcard array, keyed
+ * elements of chains which are not indexed to keyed_subs_head.
+ * For prefix chains, the key must have been validated by caller */
+static void
+notif_chain_index_chain_element(notif_chain_t *notif_chain,
+		notif_chain_elem_t *notif_chain_elem){
+
+	bool is_prefix;
+	uint32_t key_hash = 0;
+	uint32_t prefix;
+	uint8_t prefix_len;
+	notif_trie_node_t *trie_node;
+	notif_chain_key_bucket_t *key_bucket;
+
+	if(NOTIF_CHAIN_ELEM_IS_WILDCARD(notif_chain_elem)){
+
+		notif_chain_wildcard_subs_add(notif_chain, notif_chain_elem);
+		return;
+	}
+
+	if(!NOTIF_CHAIN_IS_INDEXED(notif_chain)){
+
+		notif_chain_subs_list_add(&notif_chain->keyed_subs_head,
+				notif_chain_elem);
+		return;
+	}
+
+	if(notif_chain->key_prefix_cb){
+
+		is_prefix = notif_chain->key_prefix_cb(
+				notif_chain_elem->data.app_key_data,
+				notif_chain_elem->data.app_key_data_size,
+				&prefix, &prefix_len);
+		assert(is_prefix);
+
+		trie_node = notif_trie_insert(&notif_chain->prefix_trie,
+				prefix, prefix_len);
+
+		key_bucket = (notif_chain_key_bucket_t *)trie_node->data;
+
+		if(!key_bucket){
+			key_bucket = notif_chain_key_bucket_create(notif_chain_elem, 0);
+			NOTIF_RCU_ASSIGN_POINTER(trie_node->data, (void *)key_bucket);
+		}
+	}
+	else {
+		key_hash = notif_chain->key_hash_cb(
+				notif_chain_elem->data.app_key_data,
+				notif_chain_elem->data.app_key_data_size);
+
+		key_bucket = notif_chain_lookup_key_bucket(notif_chain,
+				key_hash,
+				notif_chain_elem->data.app_key_data,
+				notif_chain_elem->data.app_key_data_size);
+
+		if(!key_bucket){
+			key_bucket = notif_chain_key_bucket_create(notif_chain_elem,
+					key_hash);
+			notif_hash_table_insert(&notif_chain->key_index,
+					key_hash, (void *)key_bucket);
+		}
+	}
+
+	notif_chain_elem->key_hash = key_hash;
+	notif_chain_elem->key_bucket = key_bucket;
+	notif_chain_subs_list_add(&key_bucket->subs_head, notif_chain_elem);
+}
+
+static void
+notif_chain_unindex_chain_element(notif_chain_t *notif_chain,
+		notif_chain_elem_t *notif_chain_elem){
+
+	uint32_t prefix;
+	uint8_t prefix_len;
+	notif_trie_node_t *trie_node;
+	notif_chain_key_bucket_t *key_bucket;
+
+	if(NOTIF_CHAIN_ELEM_IS_WILDCARD(notif_chain_elem)){
+
+		notif_chain_wildcard_subs_remove(notif_chain, notif_chain_elem);
+		return;
+	}
+
+	notif_chain_subs_list_remove(notif_chain_elem);
+
+	key_bucket = notif_chain_elem->key_bucket;
+	notif_chain_elem->key_bucket = NULL;
+
+	if(!key_bucket || key_bucket->subs_head) return;
+
+	if(notif_chain->key_prefix_cb){
+
+		notif_chain->key_prefix_cb(key_bucket->app_key_data,
+				key_bucket->app_key_data_size,
+				&prefix, &prefix_len);
+
+		trie_node = notif_trie_lookup(&notif_chain->prefix_trie,
+				prefix, prefix_len);
+		assert(trie_node && trie_node->data == (void *)key_bucket);
+		NOTIF_RCU_ASSIGN_POINTER(trie_node->data, NULL);
+		notif_trie_prune(&notif_chain->prefix_trie, prefix, prefix_len);
+	}
+	else {
+		notif_hash_table_remove(&notif_chain->key_index,
+				key_bucket->key_hash, (void *)key_bucket);
+	}
+	notif_rcu_retire(key_bucket, notif_chain_key_bucket_free);
+}
+
+void
+notif_chain_elem_set_app_key_data(
+		notif_chain_elem_t *notif_chain_elem,
+		void *app_key_data,
+		uint32_t app_key_data_size){
+
+	if(app_key_data_size <= sizeof(notif_chain_elem->data.app_key_data_inline)){
+		notif_chain_elem->data.app_key_data = 
+			notif_chain_elem->data.app_key_data_inline;
+	}
+	else {
+		notif_chain_elem->data.app_key_data = malloc(app_key_data_size);
+	}
+	memcpy(notif_chain_elem->data.app_key_data,
+			app_key_data, app_key_data_size);
+	notif_chain_elem->data.app_key_data_size = app_key_data_size;
+}
+
+void
+notif_chain_elem_free_app_key_data(
+		notif_chain_elem_t *notif_chain_elem){
+
+	if(notif_chain_elem->data.app_key_data &&
+		!NOTIF_CHAIN_ELEM_KEY_IS_INLINE(notif_chain_elem)){
+		free(notif_chain_elem->data.app_key_data);
+	}
+	notif_chain_elem->data.app_key_data = 0;
+	notif_chain_elem->data.app_key_data_size = 0;
+}
+
+void
+notif_chain_elem_copy_publish(
+		notif_chain_elem_t *dst_notif_chain_elem,
+		notif_chain_elem_t *src_notif_chain_elem){
+
+	dst_notif_chain_elem->client_id = src_notif_chain_elem->client_id;
+	dst_notif_chain_elem->notif_code = src_notif_chain_elem->notif_code;
+	dst_notif_chain_elem->prio = src_notif_chain_elem->prio;
+
+	if(src_notif_chain_elem->data.app_key_data &&
+		src_notif_chain_elem->data.app_key_data_size){
+
+		notif_chain_elem_set_app_key_data(dst_notif_chain_elem,
+				src_notif_chain_elem->data.app_key_data,
+				src_notif_chain_elem->data.app_key_data_size);
+	}
+
+	if(src_notif_chain_elem->data.app_data_to_notify &&
+		src_notif_chain_elem->data.app_data_to_notify_size){
+
+		dst_notif_chain_elem->data.app_data_to_notify = 
+			malloc(src_notif_chain_elem->data.app_data_to_notify_size);
+		memcpy(dst_notif_chain_elem->data.app_data_to_notify,
+				src_notif_chain_elem->data.app_data_to_notify,
+				src_notif_chain_elem->data.app_data_to_notify_size);
+		dst_notif_chain_elem->data.app_data_to_notify_size = 
+			src_notif_chain_elem->data.app_data_to_notify_size;
+		dst_notif_chain_elem->data.is_alloc_app_data_to_notify = true;
+	}
+}
+
+void
+notif_chain_elem_free_publish(
+		notif_chain_elem_t *notif_chain_elem){
+
+	notif_chain_elem_free_app_key_data(notif_chain_elem);
+
+	if(notif_chain_elem->data.is_alloc_app_data_to_notify){
+		free(notif_chain_elem->data.app_data_to_notify);
+	}
+	notif_chain_elem->data.app_data_to_notify = 0;
+	notif_chain_elem->data.app_data_to_notify_size = 0;
+	notif_chain_elem->data.is_alloc_app_data_to_notify = false;
+}
+
+void
+notif_chain_free_notif_chain_elem_internals(
+		notif_chain_elem_t *notif_chain_elem){
+
+	notif_chain_elem_free_app_key_data(notif_chain_elem);
+
+	if(notif_chain_elem->data.is_alloc_app_data_to_notify){
+		free(notif_chain_elem->data.app_data_to_notify);
+	}
+	notif_chain_elem->data.app_data_to_notify = 0;
+	notif_chain_elem->data.app_data_to_notify_size = 0;
+	
+	notif_chain_release_communication_channel_resources(
+			notif_chain_elem->notif_chain_comm_channel);
+
+	notif_chain_elem->notif_chain_comm_channel = 0;
+}
+
+void
+notif_chain_free_notif_chain_elem(
+		notif_chain_elem_t *notif_chain_elem){
+
+	notif_chain_free_notif_chain_elem_internals(
+			notif_chain_elem);
+
+	notif_slab_free(&notif_chain_elem_slab, notif_chain_elem);
+}
+
+/* Frees an element unlinked from its chain, once readers are done */
+static void
+notif_chain_free_retired_notif_chain_elem(void *arg){
+
+	notif_chain_elem_t *notif_chain_elem = (notif_chain_elem_t *)arg;
+
+	notif_chain_elem_free_app_key_data(notif_chain_elem);
+
+	if(notif_chain_elem->data.is_alloc_app_data_to_notify){
+		free(notif_chain_elem->data.app_data_to_notify);
+	}
+	notif_slab_free(&notif_chain_elem_slab, notif_chain_elem);
+}
+
+/* Unlink the element from the chain and all its indexes, and retire
+ * it. Fields readers may look at are left untouched. Called with
+ * notif_chain->mutex held */
+static void
+notif_chain_remove_chain_element(notif_chain_t *notif_chain,
+		notif_chain_elem_t *notif_chain_elem){
+
+	notif_chain_unindex_chain_element(notif_chain, notif_chain_elem);
+	notif_chain_client_index_remove(notif_chain, notif_chain_elem);
+	notif_hash_table_remove(&notif_chain->subs_index,
+			notif_chain_elem->subs_hash, (void *)notif_chain_elem);
+	remove_glthread(&notif_chain_elem->glue);
+	notif_chain_release_communication_channel_resources(
+			notif_chain_elem->notif_chain_comm_channel);
+	notif_rcu_retire(notif_chain_elem,
+			notif_chain_free_retired_notif_chain_elem);
+}
+
+void
+notif_chain_delete(notif_chain_t *notif_chain){
+
+	glthread_t *curr;
+	notif_chain_elem_t *notif_chain_elem;
+
+	/* Posted and held publishes go out to the subscribers
+	 * before they do */
+	notif_chain_disable_post_queue(notif_chain);
+	notif_chain_disable_conflation(notif_chain);
+	notif_shard_destroy(notif_chain);
+
+	/* Not to be found by name anymore, the caller may free it */
+	notif_chain_deregister_notif_chain(notif_chain);
+
+	pthread_mutex_lock(&notif_chain->mutex);
+
+	ITERATE_GLTHREAD_BEGIN(&notif_chain->notif_chain_elem_head, curr){
+
+		notif_chain_elem = glthread_glue_to_notif_chain_elem(curr);
+		notif_chain_remove_chain_element(notif_chain, notif_chain_elem);
+	} ITERATE_GLTHREAD_END(&notif_chain->notif_chain_elem_head, curr);
+
+	notif_hash_table_destroy(&notif_chain->client_index);
+	notif_hash_table_destroy(&notif_chain->subs_index);
+	notif_hash_table_destroy(&notif_chain->key_index);
+
+	pthread_mutex_unlock(&notif_chain->mutex);
+	notif_rcu_reclaim();
+}
+
+/* Clone everything but the communication channel, which is
+ * left for the caller to bind */
+static notif_chain_elem_t *
+notif_chain_notif_chain_elem_clone_data(
+	notif_chain_elem_t *notif_chain_elem){
+
+	notif_chain_elem_t *new_notif_chain_elem = 
+		notif_slab_alloc(&notif_chain_elem_slab);
+
+	memcpy(new_notif_chain_elem, notif_chain_elem,
+		sizeof(notif_chain_elem_t));
+
+	/* Never share the key, inline or not, with the original */
+	new_notif_chain_elem->data.app_key_data = 0;
+	new_notif_chain_elem->data.app_key_data_size = 0;
+
+	if(notif_chain_elem->data.app_key_data && 
+		notif_chain_elem->data.app_key_data_size){
+
+		notif_chain_elem_set_app_key_data(new_notif_chain_elem,
+			   notif_chain_elem->data.app_key_data,
+			   notif_chain_elem->data.app_key_data_size);
+	}
+
+	if(notif_chain_elem->data.app_data_to_notify &&
+		notif_chain_elem->data.app_data_to_notify_size){
+
+		new_notif_chain_elem->data.app_data_to_notify = 
+			calloc(1, notif_chain_elem->data.app_data_to_notify_size);
+		memcpy(new_notif_chain_elem->data.app_data_to_notify,
+				notif_chain_elem->data.app_data_to_notify,
+				notif_chain_elem->data.app_data_to_notify_size);
+		new_notif_chain_elem->data.app_data_to_notify_size = 
+				notif_chain_elem->data.app_data_to_notify_size;
+		new_notif_chain_elem->data.is_alloc_app_data_to_notify = true;
+	}
+
+	init_glthread(&new_notif_chain_elem->glue);
+	init_glthread(&new_notif_chain_elem->client_glue);
+	new_notif_chain_elem->subs_hash = 0;
+	new_notif_chain_elem->key_hash = 0;
+	new_notif_chain_elem->key_bucket = NULL;
+	new_notif_chain_elem->index_next = NULL;
+	new_notif_chain_elem->index_pprev = NULL;
+	new_notif_chain_elem->notif_chain_comm_channel = NULL;
+
+	return new_notif_chain_elem;
+}
+
+notif_chain_elem_t *
+notif_chain_notif_chain_elem_clone(
+	notif_chain_elem_t *notif_chain_elem){
+
+	notif_chain_elem_t *new_notif_chain_elem = 
+		notif_chain_notif_chain_elem_clone_data(notif_chain_elem);
+
+	new_notif_chain_elem->notif_chain_comm_channel = 
+		notif_slab_alloc(&notif_chain_comm_channel_slab);
+
+	memcpy(new_notif_chain_elem->notif_chain_comm_channel,
+		   notif_chain_elem->notif_chain_comm_channel,
+		   sizeof(notif_chain_comm_channel_t));
+		
+	init_glthread(&new_notif_chain_elem->notif_chain_comm_channel->glue);
+	new_notif_chain_elem->notif_chain_comm_channel->ref_count = 0;
+	
+	return new_notif_chain_elem;
+}
+
+/* Keys of prefix matching chains must map to a prefix, and
+ * (client id, key) must not be registered already */
+static bool
+notif_chain_is_registrable_chain_element(
+		notif_chain_t *notif_chain,
+		notif_chain_elem_t *notif_chain_elem){
+
+	uint32_t prefix;
+	uint8_t prefix_len;
+
+	if(notif_chain->key_prefix_cb &&
+			notif_chain_elem->data.app_key_data &&
+			notif_chain_elem->data.app_key_data_size &&
+			!notif_chain->key_prefix_cb(
+				notif_chain_elem->data.app_key_data,
+				notif_chain_elem->data.app_key_data_size,
+				&prefix, &prefix_len)){
+
+		return false;
+	}
+
+    if (notif_chain_lookup_notif_chain_element(
+						notif_chain,
+						notif_chain_elem->client_id,
+						notif_chain_elem->data.app_key_data,
+						notif_chain_elem->data.app_key_data_size)) {
+
+		return false;
+	}
+	return true;
+}
+
+/* Where a new element of client_id goes in the chain's list. Elements
+ * of a client are kept adjacent, a new client goes to the front. No
+ * list walk in either case */
+static glthread_t *
+notif_chain_client_insert_point(notif_chain_t *notif_chain,
+		uint32_t client_id){
+
+	notif_chain_client_subs_t *client_subs;
+
+	client_subs = notif_chain_lookup_client_subs(notif_chain, client_id);
+
+	if(client_subs){
+		return &glthread_client_glue_to_notif_chain_elem(
+					BASE(&client_subs->subs_head))->glue;
+	}
+	return &notif_chain->notif_chain_elem_head;
+}
+
+/* Link the newly cloned element into the chain, after insert_point,
+ * and into all its indexes */
+static void
+notif_chain_link_chain_element(
+		notif_chain_t *notif_chain,
+		notif_chain_elem_t *new_notif_chain_elem,
+		glthread_t *insert_point){
+
+	new_notif_chain_elem->notif_chain = notif_chain;
+
+	glthread_add_next(insert_point, &new_notif_chain_elem->glue);
+
+	new_notif_chain_elem->subs_hash = notif_chain_compute_subs_hash(
+					new_notif_chain_elem->client_id,
+					new_notif_chain_elem->data.app_key_data,
+					new_notif_chain_elem->data.app_key_data_size);
+
+	notif_hash_table_insert(&notif_chain->subs_index,
+			new_notif_chain_elem->subs_hash,
+			(void *)new_notif_chain_elem);
+
+	notif_chain_index_chain_element(notif_chain, new_notif_chain_elem);
+	notif_chain_client_index_add(notif_chain, new_notif_chain_elem);
+}
+
+bool
+notif_chain_register_chain_element(
+		notif_chain_t *notif_chain,
+		notif_chain_elem_t *notif_chain_elem){
+
+	notif_chain_elem_t *new_notif_chain_elem;
+
+	assert(notif_chain_elem->notif_chain_comm_channel);
+
+	if(notif_chain->shards &&
+			!NOTIF_CHAIN_ELEM_IS_WILDCARD(notif_chain_elem)){
+		return notif_chain_register_chain_element(
+				notif_shard_lookup(notif_chain,
+					notif_chain_elem->data.app_key_data,
+					notif_chain_elem->data.app_key_data_size),
+				notif_chain_elem);
+	}
+
+	pthread_mutex_lock(&notif_chain->mutex);
+
+	if(!notif_chain_is_registrable_chain_element(notif_chain,
+				notif_chain_elem)){
+		pthread_mutex_unlock(&notif_chain->mutex);
+		return false;
+	}
+
+	new_notif_chain_elem = notif_chain_notif_chain_elem_clone_data(
+							notif_chain_elem);
+
+	/* Now handle communication channel, existing communication
+	 * channel in db is shared, else a copy of caller's is recorded.
+	 * Bound before the element becomes visible to notif_chain_invoke() */
+	new_notif_chain_elem->notif_chain_comm_channel = 
+			notif_chain_record_comm_channel_per_client(
+			    new_notif_chain_elem->client_id,
+				notif_chain_elem->notif_chain_comm_channel);
+
+	notif_chain_link_chain_element(notif_chain, new_notif_chain_elem,
+			notif_chain_client_insert_point(notif_chain,
+				new_notif_chain_elem->client_id));
+
+	pthread_mutex_unlock(&notif_chain->mutex);
+	notif_rcu_reclaim();
+	return true;
+}
+
+typedef struct notif_chain_bulk_entry_{
+
+	uint32_t client_id;
+	uint32_t channel_hash;
+	/* Into the caller's array */
+	uint32_t index;
+} notif_chain_bulk_entry_t;
+
+static int
+notif_chain_bulk_entry_cmp_fn(const void *entry1, const void *entry2){
+
+	const notif_chain_bulk_entry_t *bulk_entry1 = 
+			(const notif_chain_bulk_entry_t *)entry1;
+
+	const notif_chain_bulk_entry_t *bulk_entry2 = 
+			(const notif_chain_bulk_entry_t *)entry2;
+
+	if(bulk_entry1->client_id != bulk_entry2->client_id)
+		return bulk_entry1->client_id < bulk_entry2->client_id ? -1 : 1;
+	if(bulk_entry1->channel_hash != bulk_entry2->channel_hash)
+		return bulk_entry1->channel_hash < bulk_entry2->channel_hash ? -1 : 1;
+	return 0;
+}
+
+uint32_t
+notif_chain_register_chain_elements(
+		notif_chain_t *notif_chain,
+		notif_chain_elem_t *notif_chain_elems,
+		uint32_t n_elems,
+		bool *registered){
+
+	uint32_t i, n_entries;
+	uint32_t n_registered = 0;
+	glthread_t *insert_point = NULL;
+	notif_chain_elem_t *notif_chain_elem;
+	notif_chain_elem_t *new_notif_chain_elem;
+	notif_chain_bulk_entry_t *bulk_entries;
+	notif_chain_comm_channel_t *notif_chain_comm_channel = NULL;
+
+	if(!n_elems) return 0;
+
+	if(registered){
+		memset(registered, 0, n_elems * sizeof(bool));
+	}
+
+	/* Elements go to different shards, one by one */
+	if(notif_chain->shards){
+
+		for(i = 0; i < n_elems; i++){
+			if(notif_chain_register_chain_element(notif_chain,
+						&notif_chain_elems[i])){
+				if(registered) registered[i] = true;
+				n_registered++;
+			}
+		}
+		return n_registered;
+	}
+
+	bulk_entries = calloc(n_elems, sizeof(notif_chain_bulk_entry_t));
+
+	for(i = 0, n_entries = 0; i < n_elems; i++){
+
+		notif_chain_elem = &notif_chain_elems[i];
+		assert(notif_chain_elem->notif_chain_comm_channel);
+
+		/* Rejected, as notif_chain_subscribe() would */
+		switch(NOTIF_CHAIN_COMM_CH_TYPE(notif_chain_elem)){
+
+			case NOTIF_C_CALLBACKS:
+			case NOTIF_C_MSG_Q:
+			case NOTIF_C_AF_UNIX:
+			case NOTIF_C_INET_SOCKETS:
+				break;
+			default:
+				continue;
+		}
+
+		bulk_entries[n_entries].client_id = notif_chain_elem->client_id;
+		bulk_entries[n_entries].channel_hash = 
+			notif_chain_compute_comm_channel_hash(
+				notif_chain_elem->client_id,
+				notif_chain_elem->notif_chain_comm_channel);
+		bulk_entries[n_entries].index = i;
+		n_entries++;
+	}
+
+	/* Subscriptions sharing a client and channel become adjacent,
+	 * the channel is then resolved once per run */
+	qsort(bulk_entries, n_entries, sizeof(notif_chain_bulk_entry_t),
+			notif_chain_bulk_entry_cmp_fn);
+
+	pthread_mutex_lock(&notif_chain->mutex);
+
+	/* The chain's list is grouped by client rather than sorted, see
+	 * notif_chain_client_insert_point(). The batch is merged into it
+	 * one client run at a time : the run's place is found once, and
+	 * each element goes right after the one before it */
+	for(i = 0; i < n_entries; i++){
+
+		notif_chain_elem = &notif_chain_elems[bulk_entries[i].index];
+
+		if(!notif_chain_is_registrable_chain_element(notif_chain,
+					notif_chain_elem)){
+			continue;
+		}
+
+		new_notif_chain_elem = notif_chain_notif_chain_elem_clone_data(
+								notif_chain_elem);
+
+		if(notif_chain_comm_channel &&
+			notif_chain_comm_channel->client_id == notif_chain_elem->client_id &&
+			notif_chain_communication_channel_match(notif_chain_comm_channel,
+				notif_chain_elem->notif_chain_comm_channel)){
+
+			notif_chain_hold_comm_channel(notif_chain_comm_channel);
+		}
+		else {
+			notif_chain_comm_channel = 
+				notif_chain_record_comm_channel_per_client(
+					notif_chain_elem->client_id,
+					notif_chain_elem->notif_chain_comm_channel);
+		}
+
+		new_notif_chain_elem->notif_chain_comm_channel = 
+			notif_chain_comm_channel;
+
+		if(!insert_point ||
+			glthread_glue_to_notif_chain_elem(insert_point)->client_id !=
+				notif_chain_elem->client_id){
+
+			insert_point = notif_chain_client_insert_point(notif_chain,
+					notif_chain_elem->client_id);
+		}
+
+		notif_chain_link_chain_element(notif_chain, new_notif_chain_elem,
+				insert_point);
+		insert_point = &new_notif_chain_elem->glue;
+
+		if(registered) registered[bulk_entries[i].index] = true;
+		n_registered++;
+	}
+
+	pthread_mutex_unlock(&notif_chain->mutex);
+	notif_rcu_reclaim();
+
+	free(bulk_entries);
+	return n_registered;
+}
+
+bool
+notif_chain_communication_channel_match(
+		notif_chain_comm_channel_t *channel1,
+		notif_chain_comm_channel_t *channel2){
+
+	if(channel1->notif_ch_type != channel2->notif_ch_type)
+		return false;
+
+	notif_ch_type_t notif_ch_type = channel1->notif_ch_type;
+
+	switch(notif_ch_type){
+
+		case NOTIF_C_CALLBACKS:
+			if(NOTIF_CHAIN_ELEM_APP_CB(channel1) != 
+					NOTIF_CHAIN_ELEM_APP_CB(channel2))
+				return false;
+			if(NOTIF_CHAIN_ELEM_MAILBOX(channel1) != 
+					NOTIF_CHAIN_ELEM_MAILBOX(channel2))
+				return false;
+			return true;
+		case NOTIF_C_MSG_Q:
+			if(strncmp(NOTIF_CHAIN_ELEM_MSGQ_NAME(channel1),
+						NOTIF_CHAIN_ELEM_MSGQ_NAME(channel2),
+						NOTIF_C_COMM_CHANNEL_MSGQ_NAME_VALUE_LEN))
+				return false;
+			return true;
+		case NOTIF_C_AF_UNIX:
+			if(strncmp(NOTIF_CHAIN_ELEM_SKT_NAME(channel1),
+						NOTIF_CHAIN_ELEM_SKT_NAME(channel2),
+						NOTIF_C_COMM_CHANNEL_UNIX_SKT_NAME_VALUE_LEN))
+				return false;
+			return true;
+		case NOTIF_C_INET_SOCKETS:
+			if((NOTIF_CHAIN_ELEM_IP_ADDR(channel1) == 
+						NOTIF_CHAIN_ELEM_IP_ADDR(channel2)) 
+					&&
+					(NOTIF_CHAIN_ELEM_PORT_NO(channel1) ==
+					 NOTIF_CHAIN_ELEM_PORT_NO(channel2))
+					&&
+					(NOTIF_CHAIN_ELEM_PROTO(channel1) == 
+					 NOTIF_CHAIN_ELEM_PROTO(channel2)))
+				return true;
+			return false;
+		case NOTIF_C_NOT_KNOWN:
+			return true;
+		default:
+			return true;
+	}
+	return true;
+}
+
+bool
+notif_chain_deregister_chain_element(notif_chain_t *notif_chain,
+		notif_chain_elem_t *notif_chain_elem){
+
+	uint32_t i;
+	glthread_t *curr;
+	bool is_removed = false;
+	notif_chain_elem_t *notif_chain_elem_curr;
+	notif_chain_client_subs_t *client_subs;
+	notif_chain_comm_channel_t *notif_chain_comm_channel;
+
+	notif_chain_comm_channel = notif_chain_elem->notif_chain_comm_channel;
+
+	/* Keyed subscriptions matching the element are in the key's
+	 * shard, but a keyless element may match any. The sharded chain
+	 * itself holds only the wildcard subscriptions, which the
+	 * keyless element removes below */
+	if(notif_chain->shards){
+
+		if(!NOTIF_CHAIN_ELEM_IS_WILDCARD(notif_chain_elem)){
+			return notif_chain_deregister_chain_element(
+					notif_shard_lookup(notif_chain,
+						notif_chain_elem->data.app_key_data,
+						notif_chain_elem->data.app_key_data_size),
+					notif_chain_elem);
+		}
+
+		for(i = 0; i < notif_chain->shards->n_shards; i++){
+			if(notif_chain_deregister_chain_element(
+						&notif_chain->shards->shards[i],
+						notif_chain_elem)){
+				is_removed = true;
+			}
+		}
+	}
+
+	pthread_mutex_lock(&notif_chain->mutex);
+
+	client_subs = notif_chain_lookup_client_subs(notif_chain,
+			notif_chain_elem->client_id);
+
+	if(!client_subs){
+		pthread_mutex_unlock(&notif_chain->mutex);
+		return is_removed;
+	}
+
+	/* client_subs is freed along with the last subscription of
+	 * the client, iteration ends there as no next element exists */
+	ITERATE_GLTHREAD_BEGIN(&client_subs->subs_head, curr){
+
+		notif_chain_elem_curr = glthread_client_glue_to_notif_chain_elem(curr);
+
+		if(!notif_chain->shards &&
+				notif_chain->comp_cb &&
+				notif_chain->comp_cb(
 					notif_chain_elem_curr->data.app_key_data,
 					notif_chain_elem_curr->data.app_key_data_size,
-					notif_chain_elem->data.app_key_data, 
+					notif_chain_elem->data.app_key_data, 
+					notif_chain_elem->data.app_key_data_size) != 0){
+
+			continue;
+		}
+
+		/*Compare connunication channel also*/
+#if 0
+		if(notif_chain_comm_channel->notif_ch_type != 
+				notif_chain_elem_curr->notif_chain_comm_channel->notif_ch_type){
+			continue;
+		}
+
+		/*Now match Notification channel exactness*/
+		if(!notif_chain_communication_channel_match(
+					notif_chain_comm_channel,
+					notif_chain_elem_curr->notif_chain_comm_channel)){
+
+			continue;
+		}
+#endif
+		notif_chain_remove_chain_element(notif_chain, notif_chain_elem_curr);
+		is_removed = true;
+
+	} ITERATE_GLTHREAD_END(&client_subs->subs_head, curr);
+
+	pthread_mutex_unlock(&notif_chain->mutex);
+	notif_rcu_reclaim();
+	return is_removed;
+}
+
+uint32_t
+notif_chain_deregister_client(notif_chain_t *notif_chain,
+		uint32_t client_id){
+
+	uint32_t i;
+	glthread_t *curr;
+	uint32_t n_removed = 0;
+	notif_chain_elem_t *notif_chain_elem_curr;
+	notif_chain_client_subs_t *client_subs;
+
+	if(notif_chain->shards){
+		for(i = 0; i < notif_chain->shards->n_shards; i++){
+			n_removed += notif_chain_deregister_client(
+					&notif_chain->shards->shards[i], client_id);
+		}
+	}
+
+	pthread_mutex_lock(&notif_chain->mutex);
+
+	client_subs = notif_chain_lookup_client_subs(notif_chain, client_id);
+
+	if(!client_subs){
+		pthread_mutex_unlock(&notif_chain->mutex);
+		return n_removed;
+	}
+
+	ITERATE_GLTHREAD_BEGIN(&client_subs->subs_head, curr){
+
+		notif_chain_elem_curr = glthread_client_glue_to_notif_chain_elem(curr);
+		notif_chain_remove_chain_element(notif_chain, notif_chain_elem_curr);
+		n_removed++;
+	} ITERATE_GLTHREAD_END(&client_subs->subs_head, curr);
+
+	pthread_mutex_unlock(&notif_chain->mutex);
+	notif_rcu_reclaim();
+	return n_removed;
+}
+
+/* TLVs proper to the subscriber : client id, channel and key */
+static uint32_t
+notif_chain_compute_subscriber_tlv_size(
+		notif_chain_elem_t *notif_chain_elem){
+
+	uint32_t size = 0;
+
+	/* client id*/
+	size += TLV_OVERHEAD_SIZE + NOTIF_C_CLIENT_ID_VALUE_LEN;
+
+	/* Non-Mandatory TLVs */
+	switch(NOTIF_CHAIN_COMM_CH_TYPE(notif_chain_elem)){
+
+		case NOTIF_C_CALLBACKS:
+			break;
+		case NOTIF_C_MSG_Q:
+			size += TLV_OVERHEAD_SIZE + NOTIF_C_COMM_CHANNEL_TYPE_VALUE_LEN;
+			size += TLV_OVERHEAD_SIZE + NOTIF_C_COMM_CHANNEL_MSGQ_NAME_VALUE_LEN;
+			break;
+		case NOTIF_C_AF_UNIX:
+			size += TLV_OVERHEAD_SIZE + NOTIF_C_COMM_CHANNEL_TYPE_VALUE_LEN;
+			size += TLV_OVERHEAD_SIZE + NOTIF_C_COMM_CHANNEL_UNIX_SKT_NAME_VALUE_LEN;
+			break;
+		case NOTIF_C_INET_SOCKETS:
+			size += TLV_OVERHEAD_SIZE + NOTIF_C_COMM_CHANNEL_TYPE_VALUE_LEN;
+			size += TLV_OVERHEAD_SIZE + NOTIF_C_IP_ADDR_VALUE_LEN;
+			size += TLV_OVERHEAD_SIZE + NOTIF_C_PORT_NO_VALUE_LEN;
+			size += TLV_OVERHEAD_SIZE + NOTIF_C_PROTOCOL_NO_VALUE_LEN;
+			break;
+		case NOTIF_C_NOT_KNOWN:
+			break;
+		default:
+			;
+	}
+
+	/* The subscriber's key, what it registered for */
+	if(notif_chain_elem->data.app_key_data && 
+			notif_chain_elem->data.app_key_data_size){
+
+		size += TLV_ENCODED_SIZE(notif_chain_elem->data.app_key_data_size);
+	}
+	return size;
+}
+
+static char *
+notif_chain_serialize_subscriber_tlvs(
+		char *output_buff,
+		notif_chain_elem_t *notif_chain_elem){
+
+	notif_chain_comm_channel_t *
+		notif_chain_comm_channel = notif_chain_elem->notif_chain_comm_channel;
+
+	output_buff = tlv_buffer_insert_tlv(output_buff,
+			NOTIF_C_CLIENT_ID_TLV,
+			NOTIF_C_CLIENT_ID_VALUE_LEN,
+			(char *)&(notif_chain_elem->client_id));
+
+	/* Non-Mandatory TLVs */
+	switch(NOTIF_CHAIN_COMM_CH_TYPE(notif_chain_elem)){
+		case NOTIF_C_CALLBACKS:
+			break;
+		case NOTIF_C_MSG_Q:
+		case NOTIF_C_AF_UNIX:
+			output_buff = tlv_buffer_insert_tlv(output_buff,
+					NOTIF_C_COMM_CHANNEL_TYPE_TLV,
+					NOTIF_C_COMM_CHANNEL_TYPE_VALUE_LEN,
+					(char *)&(NOTIF_CHAIN_COMM_CH_TYPE(notif_chain_elem)));
+			output_buff = tlv_buffer_insert_tlv(output_buff,
+					NOTIF_C_COMM_CHANNEL_NAME_TLV,
+
+					NOTIF_CHAIN_COMM_CH_TYPE(notif_chain_elem) == NOTIF_C_MSG_Q ?
+					NOTIF_C_COMM_CHANNEL_MSGQ_NAME_VALUE_LEN :
+					NOTIF_C_COMM_CHANNEL_UNIX_SKT_NAME_VALUE_LEN,
+
+					NOTIF_CHAIN_COMM_CH_TYPE(notif_chain_elem) == NOTIF_C_MSG_Q ?
+					NOTIF_CHAIN_ELEM_MSGQ_NAME(notif_chain_comm_channel) :
+					NOTIF_CHAIN_ELEM_SKT_NAME(notif_chain_comm_channel));
+			break;
+		case NOTIF_C_INET_SOCKETS:
+			output_buff = tlv_buffer_insert_tlv(output_buff,
+					NOTIF_C_COMM_CHANNEL_TYPE_TLV,
+					NOTIF_C_COMM_CHANNEL_TYPE_VALUE_LEN,
+					(char *)&(NOTIF_CHAIN_COMM_CH_TYPE(notif_chain_elem)));
+
+			output_buff = tlv_buffer_insert_tlv(output_buff,
+					NOTIF_C_IP_ADDR_TLV,
+					NOTIF_C_IP_ADDR_VALUE_LEN,
+					(char *)&(NOTIF_CHAIN_ELEM_IP_ADDR(notif_chain_comm_channel)));
+
+			output_buff = tlv_buffer_insert_tlv(output_buff,
+					NOTIF_C_PORT_NO_TLV,
+					NOTIF_C_PORT_NO_VALUE_LEN,
+					(char *)&(NOTIF_CHAIN_ELEM_PORT_NO(notif_chain_comm_channel)));
+
+			output_buff = tlv_buffer_insert_tlv(output_buff,
+					NOTIF_C_PROTOCOL_NO_TLV,
+					NOTIF_C_PROTOCOL_NO_VALUE_LEN,
+					(char *)&(NOTIF_CHAIN_ELEM_PROTO(notif_chain_comm_channel)));
+			break;
+		case NOTIF_C_NOT_KNOWN:
+			break;
+		default:
+			;
+	}
+
+	if(notif_chain_elem->data.app_key_data &&
+			notif_chain_elem->data.app_key_data_size){
+
+		output_buff = tlv_buffer_insert_tlv(output_buff,
+				NOTIF_C_APP_KEY_DATA_TLV,
+				notif_chain_elem->data.app_key_data_size,
+				(char *)notif_chain_elem->data.app_key_data);
+	}
+	return output_buff;
+}
+
+/* TLVs which are the same for every subscriber of a publish :
+ * chain name, notif code and data to notify */
+static uint32_t
+notif_chain_compute_publish_tlv_size(
+		notif_chain_elem_t *notif_chain_elem){
+
+	uint32_t size = 0;
+
+	/* Notif chain name*/
+	size += TLV_OVERHEAD_SIZE + NOTIF_C_NOTIF_CHAIN_NAME_VALUE_LEN;
+
+	/*notif code*/
+	size += TLV_OVERHEAD_SIZE + NOTIF_C_NOTIF_CODE_VALUE_LEN;
+
+	if(notif_chain_elem->data.app_data_to_notify &&
+			notif_chain_elem->data.app_data_to_notify_size){
+
+		size += TLV_ENCODED_SIZE(notif_chain_elem->data.app_data_to_notify_size);
+	}
+
+	return size;
+}
+
+static char *
+notif_chain_serialize_publish_tlvs(
+		char *output_buff,
+		char *notif_chain_name,
+		notif_chain_elem_t *notif_chain_elem){
+
+	output_buff = tlv_buffer_insert_tlv(output_buff,
+			NOTIF_C_NOTIF_CHAIN_NAME_TLV,
+			NOTIF_C_NOTIF_CHAIN_NAME_VALUE_LEN,
+			notif_chain_name);
+
+	output_buff = tlv_buffer_insert_tlv(output_buff,
+			NOTIF_C_NOTIF_CODE_TLV,
+			NOTIF_C_NOTIF_CODE_VALUE_LEN,
+			(char *)&(notif_chain_elem->notif_code));
+
+	if(notif_chain_elem->data.app_data_to_notify &&
+			notif_chain_elem->data.app_data_to_notify_size){
+
+		output_buff = tlv_buffer_insert_tlv(output_buff,
+				NOTIF_C_APP_DATA_TO_NOTIFY_TLV,
+				notif_chain_elem->data.app_data_to_notify_size,
+				(char *)notif_chain_elem->data.app_data_to_notify);
+	}
+
+	return output_buff;
+}
+
+#define NOTIF_CHAIN_MATCHED_INLINE	64
+
+/* One publish being delivered. With n_partitions > 1, only the
+ * subscribers whose channel maps to partition are delivered to */
+typedef struct notif_chain_invoke_arg_{
+
+	notif_chain_t *notif_chain;
+	notif_chain_elem_t *notif_chain_elem;
+	uint32_t partition;
+	uint32_t n_partitions;
+	/* Set while the fan-out pool runs : the matching subscribers
+	 * are gathered in matched, then delivered by notif_fanout_run() */
+	bool gather;
+	notif_chain_elem_t **matched;
+	uint32_t n_matched;
+	uint32_t matched_size;
+	notif_chain_elem_t *matched_inline[NOTIF_CHAIN_MATCHED_INLINE];
+	/* Publish TLVs shared by the socket subscribers, encoded by
+	 * the first one delivered to */
+	notif_outq_body_t *publish_body;
+	/* Batch of the publishing thread, fan-out workers send in it */
+	notif_outq_batch_t *batch;
+} notif_chain_invoke_arg_t;
+
+/* Encodes the TLVs common to all subscribers once per publish,
+ * every socket subscriber's message refers to the one body */
+static notif_outq_body_t *
+notif_chain_encode_publish(notif_chain_invoke_arg_t *invoke_arg,
+		notif_chain_elem_t *notif_chain_elem){
+
+	notif_outq_body_t *body, *expected = NULL;
+
+	body = __atomic_load_n(&invoke_arg->publish_body, __ATOMIC_ACQUIRE);
+	if(body) return body;
+
+	body = notif_outq_body_alloc(
+			notif_chain_compute_publish_tlv_size(notif_chain_elem));
+	notif_chain_serialize_publish_tlvs(body->data,
+			invoke_arg->notif_chain->name, notif_chain_elem);
+
+	/* Fan-out chunks may race to it */
+	if(!__atomic_compare_exchange_n(&invoke_arg->publish_body, &expected,
+				body, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)){
+		notif_outq_body_release(body);
+		body = expected;
+	}
+	return body;
+}
+
+/* invoke_arg->notif_chain_elem is what the publisher passed, NULL
+ * for a keyless publish. Socket subscribers conflate by its key */
+static void
+notif_chain_invoke_communication_channel(
+		notif_chain_invoke_arg_t *invoke_arg,
+		notif_chain_elem_t *notif_chain_elem){
+
+	char *tlv_buff;
+	uint32_t tlv_buff_size;
+	notif_outq_body_t *body;
+	notif_chain_elem_t *publish_elem = invoke_arg->notif_chain_elem;
+
+	notif_chain_comm_channel_t *
+		notif_chain_comm_channel = notif_chain_elem->notif_chain_comm_channel;
+
+	switch(notif_chain_comm_channel->notif_ch_type){
+
+		case NOTIF_C_CALLBACKS:
+			if(NOTIF_CHAIN_ELEM_MAILBOX(notif_chain_comm_channel)){
+				notif_mailbox_post(
+					NOTIF_CHAIN_ELEM_MAILBOX(notif_chain_comm_channel),
+					notif_chain_elem);
+				break;
+			}
+			assert(NOTIF_CHAIN_ELEM_APP_CB(notif_chain_comm_channel));
+			NOTIF_CHAIN_ELEM_APP_CB(notif_chain_comm_channel)(
+					notif_chain_elem);
+			break;
+		case NOTIF_C_MSG_Q:
+			break;
+		case NOTIF_C_AF_UNIX:
+			break;
+		case NOTIF_C_INET_SOCKETS:
+			/* Would be misread by a subscriber knowing only
+			 * the short TLV form. Counted as dropped by its outq,
+			 * reported once per channel */
+			if(!(__atomic_load_n(&notif_chain_comm_channel->peer_caps,
+						__ATOMIC_RELAXED) & NOTIF_C_CAP_WIDE_TLV) &&
+				(TLV_IS_WIDE(notif_chain_elem->data.app_key_data_size) ||
+				 TLV_IS_WIDE(notif_chain_elem->data.app_data_to_notify_size))){
+
+				if(notif_outq_drop_too_wide(notif_chain_comm_channel->outq)){
+					printf("%s() : Error : Client %u does not take wide TLVs, "
+							"notifications not sent\n", __FUNCTION__,
+							notif_chain_elem->client_id);
+				}
+				break;
+			}
+
+			body = notif_chain_encode_publish(invoke_arg, notif_chain_elem);
+
+			/* Only the subscriber's own TLVs are written per
+			 * subscriber, they go out ahead of the body */
+			tlv_buff_size = notif_chain_compute_subscriber_tlv_size(
+								notif_chain_elem);
+			tlv_buff = malloc(tlv_buff_size);
+			notif_chain_serialize_subscriber_tlvs(tlv_buff, notif_chain_elem);
+
+			/* Queue owns tlv_buff and a reference on body from here */
+			notif_outq_body_hold(body);
+			notif_outq_send(notif_chain_comm_channel->outq,
+				tlv_buff, tlv_buff_size, body,
+				publish_elem ? publish_elem->data.app_key_data : NULL,
+				publish_elem ? publish_elem->data.app_key_data_size : 0,
+				NOTIF_CHAIN_ELEM_LANE(notif_chain_elem) == NOTIF_C_LANE_HIGH,
+				invoke_arg->batch);
+			break;
+		case NOTIF_C_NOT_KNOWN:
+			break;
+		default:
+			assert(0);
+	}
+}
+
+
+
+/* The subscriber's element may be delivered to by several publishers
+ * at once, the notification is composed on a private copy of it */
+static void
+notif_chain_deliver(notif_chain_invoke_arg_t *invoke_arg,
+		notif_chain_elem_t *notif_chain_elem_curr){
+
+	notif_chain_elem_t notif_chain_elem_copy;
+	notif_chain_elem_t *notif_chain_elem = invoke_arg->notif_chain_elem;
+
+	if(invoke_arg->n_partitions > 1 &&
+		notif_chain_elem_curr->notif_chain_comm_channel->channel_hash %
+			invoke_arg->n_partitions != invoke_arg->partition){
+		return;
+	}
+
+	memcpy(&notif_chain_elem_copy, notif_chain_elem_curr,
+			sizeof(notif_chain_elem_t));
+
+	notif_chain_elem_copy.notif_code = NOTIF_C_UNKNOWN;
+	notif_chain_elem_copy.prio = NOTIF_C_PRIO_DEFAULT;
+
+	if(notif_chain_elem){
+		notif_chain_elem_copy.notif_code = 
+			notif_chain_elem->notif_code;
+		notif_chain_elem_copy.prio = notif_chain_elem->prio;
+		notif_chain_elem_copy.data.is_alloc_app_data_to_notify = 
+			notif_chain_elem->data.is_alloc_app_data_to_notify;
+		notif_chain_elem_copy.data.app_data_to_notify = 
+			notif_chain_elem->data.app_data_to_notify;
+		notif_chain_elem_copy.data.app_data_to_notify_size =
+			notif_chain_elem->data.app_data_to_notify_size;
+	}
+	notif_chain_invoke_communication_channel(invoke_arg,
+			&notif_chain_elem_copy);
+}
+
+static void
+notif_chain_match(notif_chain_invoke_arg_t *invoke_arg,
+		notif_chain_elem_t *notif_chain_elem_curr){
+
+	if(!invoke_arg->gather){
+		notif_chain_deliver(invoke_arg, notif_chain_elem_curr);
+		return;
+	}
+
+	if(invoke_arg->n_matched == invoke_arg->matched_size){
+
+		invoke_arg->matched_size <<= 1;
+
+		if(invoke_arg->matched == invoke_arg->matched_inline){
+			invoke_arg->matched = malloc(invoke_arg->matched_size *
+						sizeof(notif_chain_elem_t *));
+			memcpy(invoke_arg->matched, invoke_arg->matched_inline,
+					sizeof(invoke_arg->matched_inline));
+		}
+		else {
+			invoke_arg->matched = realloc(invoke_arg->matched,
+						invoke_arg->matched_size *
+						sizeof(notif_chain_elem_t *));
+		}
+	}
+	invoke_arg->matched[invoke_arg->n_matched++] = notif_chain_elem_curr;
+}
+
+/* notif_fanout_fn over invoke_arg->matched. The publisher's read
+ * side critical section covers the pool threads too. They enter
+ * one of their own all the same, else a callback reclaiming there
+ * would wait on the publisher, which waits on them */
+static void
+notif_chain_deliver_matched(void *arg, uint32_t begin, uint32_t end){
+
+	uint32_t i;
+	notif_chain_invoke_arg_t *invoke_arg = (notif_chain_invoke_arg_t *)arg;
+
+	notif_rcu_read_lock();
+
+	for(i = begin; i < end; i++){
+		notif_chain_deliver(invoke_arg, invoke_arg->matched[i]);
+	}
+
+	notif_rcu_read_unlock();
+}
+
+static void
+notif_chain_deliver_subs_list(notif_chain_invoke_arg_t *invoke_arg,
+		notif_chain_elem_t *subs_head){
+
+	notif_chain_elem_t *notif_chain_elem_curr,
+					   *notif_chain_elem_next;
+
+	for(notif_chain_elem_curr = subs_head;
+			notif_chain_elem_curr;
+			notif_chain_elem_curr = notif_chain_elem_next){
+
+		notif_chain_elem_next = 
+			NOTIF_RCU_DEREFERENCE(notif_chain_elem_curr->index_next);
+		notif_chain_match(invoke_arg, notif_chain_elem_curr);
+	}
+}
+
+/* Hash indexed dispatch : only the subscribers of the published
+ * key are visited */
+static void
+notif_chain_invoke_by_key_index(notif_chain_invoke_arg_t *invoke_arg){
+
+	uint32_t key_hash;
+	notif_chain_key_bucket_t *key_bucket;
+	notif_chain_t *notif_chain = invoke_arg->notif_chain;
+	notif_chain_elem_t *notif_chain_elem = invoke_arg->notif_chain_elem;
+
+	key_hash = notif_chain->key_hash_cb(
+			notif_chain_elem->data.app_key_data,
+			notif_chain_elem->data.app_key_data_size);
+
+	key_bucket = notif_chain_lookup_key_bucket(notif_chain,
+			key_hash,
+			notif_chain_elem->data.app_key_data,
+			notif_chain_elem->data.app_key_data_size);
+
+	if(key_bucket){
+		notif_chain_deliver_subs_list(invoke_arg,
+				NOTIF_RCU_DEREFERENCE(key_bucket->subs_head));
+	}
+}
+
+static void
+notif_chain_deliver_trie_node(notif_trie_node_t *trie_node, void *arg){
+
+	notif_chain_invoke_arg_t *invoke_arg = (notif_chain_invoke_arg_t *)arg;
+	notif_chain_key_bucket_t *key_bucket = 
+		(notif_chain_key_bucket_t *)NOTIF_RCU_DEREFERENCE(trie_node->data);
+
+	/* Bucket may have been unhooked since the walk saw it */
+	if(!key_bucket) return;
+
+	notif_chain_deliver_subs_list(invoke_arg,
+			NOTIF_RCU_DEREFERENCE(key_bucket->subs_head));
+}
+
+/* Prefix trie dispatch : every subscriber whose prefix covers the
+ * published key is visited */
+static void
+notif_chain_invoke_by_prefix_trie(notif_chain_invoke_arg_t *invoke_arg){
+
+	uint32_t prefix;
+	uint8_t prefix_len;
+	notif_chain_t *notif_chain = invoke_arg->notif_chain;
+	notif_chain_elem_t *notif_chain_elem = invoke_arg->notif_chain_elem;
+
+	if(notif_chain->key_prefix_cb(
+				notif_chain_elem->data.app_key_data,
+				notif_chain_elem->data.app_key_data_size,
+				&prefix, &prefix_len)){
+
+		notif_trie_walk_covering(&notif_chain->prefix_trie,
+				prefix, prefix_len,
+				notif_chain_deliver_trie_node,
+				(void *)invoke_arg);
+	}
+}
+
+/* Chains which are not indexed : keyed subscribers are compared
+ * one by one against the published key */
+static void
+notif_chain_invoke_by_keyed_subs_list(notif_chain_invoke_arg_t *invoke_arg){
+
+	notif_chain_elem_t *notif_chain_elem_curr,
+					   *notif_chain_elem_next;
+	notif_chain_t *notif_chain = invoke_arg->notif_chain;
+	notif_chain_elem_t *notif_chain_elem = invoke_arg->notif_chain_elem;
+
+	for(notif_chain_elem_curr = 
+			NOTIF_RCU_DEREFERENCE(notif_chain->keyed_subs_head);
+			notif_chain_elem_curr;
+			notif_chain_elem_curr = notif_chain_elem_next){
+
+		notif_chain_elem_next = 
+			NOTIF_RCU_DEREFERENCE(notif_chain_elem_curr->index_next);
+
+		if(notif_chain->comp_cb &&
+				notif_chain->comp_cb(notif_chain_elem_curr->data.app_key_data,
+					notif_chain_elem_curr->data.app_key_data_size,
+					notif_chain_elem->data.app_key_data,
 					notif_chain_elem->data.app_key_data_size) != 0){
 
 			continue;
 		}
 
-		/*Compare connunication channel also*/
-#if 0
-		if(notif_chain_comm_channel->notif_ch_type != 
-				notif_chain_elem_curr->notif_chain_comm_channel->notif_ch_type){
-			continue;
+		notif_chain_match(invoke_arg, notif_chain_elem_curr);
+	}
+}
+
+/* Publish without key : every keyed subscriber is notified. The
+ * matching index is walked rather than notif_chain_elem_head,
+ * which belongs to writers */
+static void
+notif_chain_invoke_all_keyed_subs(notif_chain_invoke_arg_t *invoke_arg){
+
+	notif_hash_entry_t *entry;
+	notif_chain_key_bucket_t *key_bucket;
+	notif_chain_t *notif_chain = invoke_arg->notif_chain;
+
+	if(!NOTIF_CHAIN_IS_INDEXED(notif_chain)){
+		notif_chain_deliver_subs_list(invoke_arg,
+				NOTIF_RCU_DEREFERENCE(notif_chain->keyed_subs_head));
+		return;
+	}
+
+	if(notif_chain->key_prefix_cb){
+
+		notif_trie_walk_all(&notif_chain->prefix_trie,
+				notif_chain_deliver_trie_node,
+				(void *)invoke_arg);
+		return;
+	}
+
+	ITERATE_NOTIF_HASH_TABLE_BEGIN(&notif_chain->key_index, entry){
+
+		key_bucket = (notif_chain_key_bucket_t *)entry->data;
+
+		notif_chain_deliver_subs_list(invoke_arg,
+				NOTIF_RCU_DEREFERENCE(key_bucket->subs_head));
+
+	} ITERATE_NOTIF_HASH_TABLE_END(&notif_chain->key_index, entry);
+}
+
+/* Visits every subscriber of invoke_arg->notif_chain_elem. Called
+ * within a read side critical section */
+static void
+notif_chain_walk_matching(notif_chain_invoke_arg_t *invoke_arg){
+
+	uint32_t i, n_wildcard_subs;
+	notif_chain_wildcard_subs_t *wildcard_subs;
+	notif_chain_t *notif_chain = invoke_arg->notif_chain;
+	notif_chain_elem_t *notif_chain_elem = invoke_arg->notif_chain_elem;
+
+	if(!notif_chain_elem || NOTIF_CHAIN_ELEM_IS_WILDCARD(notif_chain_elem)){
+		notif_chain_invoke_all_keyed_subs(invoke_arg);
+	}
+	else if(notif_chain->key_prefix_cb){
+		notif_chain_invoke_by_prefix_trie(invoke_arg);
+	}
+	else if(notif_chain->key_hash_cb && notif_chain->comp_cb){
+		notif_chain_invoke_by_key_index(invoke_arg);
+	}
+	else if(notif_chain->key_hash_cb){
+		/* Keys are not compared without comp_cb, every keyed
+		 * subscriber is notified as on a chain not indexed */
+		notif_chain_invoke_all_keyed_subs(invoke_arg);
+	}
+	else {
+		notif_chain_invoke_by_keyed_subs_list(invoke_arg);
+	}
+
+	/* Wildcard subscribers : no key to compare */
+	wildcard_subs = NOTIF_RCU_DEREFERENCE(notif_chain->wildcard_subs);
+
+	if(wildcard_subs){
+
+		n_wildcard_subs = __atomic_load_n(&wildcard_subs->count,
+							__ATOMIC_ACQUIRE);
+
+		for(i = 0; i < n_wildcard_subs; i++){
+			notif_chain_match(invoke_arg, wildcard_subs->elems[i]);
+		}
+	}
+}
+
+static void
+notif_chain_invoke_arg_init(notif_chain_invoke_arg_t *invoke_arg,
+		notif_chain_t *notif_chain,
+		notif_chain_elem_t *notif_chain_elem,
+		uint32_t partition,
+		uint32_t n_partitions){
+
+	invoke_arg->notif_chain = notif_chain;
+	invoke_arg->notif_chain_elem = notif_chain_elem;
+	invoke_arg->partition = partition;
+	invoke_arg->n_partitions = n_partitions;
+	invoke_arg->gather = notif_fanout_is_active();
+	invoke_arg->matched = invoke_arg->matched_inline;
+	invoke_arg->n_matched = 0;
+	invoke_arg->matched_size = NOTIF_CHAIN_MATCHED_INLINE;
+	invoke_arg->publish_body = NULL;
+	invoke_arg->batch = notif_outq_batch_current();
+}
+
+/* Lock free : runs as an RCU read side critical section, so
+ * subscriptions and unsubscriptions never hold up a publish */
+void
+notif_chain_invoke_partition(notif_chain_t *notif_chain,
+		notif_chain_elem_t *notif_chain_elem,
+		uint32_t partition,
+		uint32_t n_partitions){
+
+	notif_chain_invoke_arg_t invoke_arg;
+
+	notif_chain_invoke_arg_init(&invoke_arg, notif_chain,
+			notif_chain_elem, partition, n_partitions);
+
+	notif_rcu_read_lock();
+
+	notif_chain_walk_matching(&invoke_arg);
+
+	/* Large sets are split over the pool, tail latency of the
+	 * publish then drops as workers are added */
+	if(invoke_arg.gather){
+
+		notif_fanout_run(notif_chain_deliver_matched,
+				(void *)&invoke_arg, invoke_arg.n_matched);
+
+		if(invoke_arg.matched != invoke_arg.matched_inline){
+			free(invoke_arg.matched);
 		}
+	}
+
+	if(invoke_arg.publish_body) notif_outq_body_release(invoke_arg.publish_body);
+
+	notif_rcu_read_unlock();
+}
+
+uint32_t
+notif_chain_match_subscribers(notif_chain_t *notif_chain,
+		notif_chain_elem_t *notif_chain_elem,
+		notif_chain_elem_t ***matched){
+
+	notif_chain_invoke_arg_t invoke_arg;
+
+	assert(notif_rcu_is_reader());
 
-		/*Now match Notification channel exactness*/
-		if(!notif_chain_communication_channel_match(
-					notif_chain_comm_channel,
-					notif_chain_elem_curr->notif_chain_comm_channel)){
+	notif_chain_invoke_arg_init(&invoke_arg, notif_chain,
+			notif_chain_elem, 0, 1);
+	invoke_arg.gather = true;
 
-			continue;
-		}
-#endif
-		remove_glthread(&notif_chain_elem_curr->glue);
-		notif_chain_elem_curr->notif_chain = 0;
-		notif_chain_free_notif_chain_elem(notif_chain_elem_curr);
-		is_removed = true;
+	notif_chain_walk_matching(&invoke_arg);
 
-	} ITERATE_GLTHREAD_END(&notif_chain->notif_chain_elem_head, curr);
-	return is_removed;
+	*matched = NULL;
+	if(!invoke_arg.n_matched) return 0;
+
+	if(invoke_arg.matched == invoke_arg.matched_inline){
+		*matched = malloc(invoke_arg.n_matched * sizeof(notif_chain_elem_t *));
+		memcpy(*matched, invoke_arg.matched_inline,
+				invoke_arg.n_matched * sizeof(notif_chain_elem_t *));
+	}
+	else {
+		*matched = invoke_arg.matched;
+	}
+	return invoke_arg.n_matched;
 }
 
-static void
-notif_chain_invoke_communication_channel(
-		notif_chain_t *notif_chain,
-		notif_chain_elem_t *notif_chain_elem){
+void
+notif_chain_deliver_to_subscribers(notif_chain_t *notif_chain,
+		notif_chain_elem_t *notif_chain_elem,
+		notif_chain_elem_t **matched,
+		uint32_t n_matched){
 
-	char *tlv_buff;
-	uint32_t tlv_buff_size;
+	notif_chain_invoke_arg_t invoke_arg;
 
-	tlv_buff = NULL;
-	notif_chain_comm_channel_t *
-		notif_chain_comm_channel = notif_chain_elem->notif_chain_comm_channel;
+	notif_chain_invoke_arg_init(&invoke_arg, notif_chain,
+			notif_chain_elem, 0, 1);
+	invoke_arg.matched = matched;
+	invoke_arg.n_matched = n_matched;
 
-	switch(notif_chain_comm_channel->notif_ch_type){
+	notif_rcu_read_lock();
 
-		case NOTIF_C_CALLBACKS:
-			assert(NOTIF_CHAIN_ELEM_APP_CB(notif_chain_comm_channel));
-			NOTIF_CHAIN_ELEM_APP_CB(notif_chain_comm_channel)(
-					notif_chain_elem);
-			break;
-		case NOTIF_C_MSG_Q:
-			break;
-		case NOTIF_C_AF_UNIX:
-			break;
-		case NOTIF_C_INET_SOCKETS:
-			tlv_buff_size = notif_chain_serialize_notif_chain_elem(
-								notif_chain->name,
-								notif_chain_elem,
-								0, 0,
-								&tlv_buff); 
-			if(!tlv_buff || !tlv_buff_size) return;
-			
-			notif_chain_send_msg_to_subscriber(
-				network_covert_ip_n_to_p(
-					NOTIF_CHAIN_ELEM_IP_ADDR(notif_chain_comm_channel), 0), /* Not used for TCP */
-				NOTIF_CHAIN_ELEM_PORT_NO(notif_chain_comm_channel), 		/* Not used for TCP */
-				tlv_buff, tlv_buff_size,
-				NOTIF_CHAIN_ELEM_SKT_FD(notif_chain_comm_channel),
-				NOTIF_CHAIN_ELEM_PROTO(notif_chain_comm_channel));
-			
-			free(tlv_buff);
-			break;
-		case NOTIF_C_NOT_KNOWN:
-			break;
-		default:
-			assert(0);
+	if(invoke_arg.gather){
+		notif_fanout_run(notif_chain_deliver_matched,
+				(void *)&invoke_arg, n_matched);
 	}
-}
+	else {
+		notif_chain_deliver_matched((void *)&invoke_arg, 0, n_matched);
+	}
+
+	if(invoke_arg.publish_body) notif_outq_body_release(invoke_arg.publish_body);
 
+	notif_rcu_read_unlock();
+}
 
 void
 notif_chain_invoke(notif_chain_t *notif_chain,
 		notif_chain_elem_t *notif_chain_elem){
 
-	glthread_t *curr;
-	notif_chain_elem_t *notif_chain_elem_curr;
-
-	ITERATE_GLTHREAD_BEGIN(&notif_chain->notif_chain_elem_head, curr){
+	if(notif_conflate_publish(notif_chain, notif_chain_elem)) return;
 
-		notif_chain_elem_curr = glthread_glue_to_notif_chain_elem(curr);
+	if(notif_chain->shards){
+		notif_shard_dispatch(notif_chain, notif_chain_elem);
+		return;
+	}
 
-		if(notif_chain->comp_cb &&
-				notif_chain_elem &&
-				notif_chain_elem->data.app_key_data &&
-				notif_chain_elem->data.app_key_data_size &&
-				notif_chain_elem_curr->data.app_key_data &&
-				notif_chain_elem_curr->data.app_key_data_size &&
-				notif_chain->comp_cb(notif_chain_elem_curr->data.app_key_data,
-					notif_chain_elem_curr->data.app_key_data_size,
-					notif_chain_elem->data.app_key_data,
-					notif_chain_elem->data.app_key_data_size) != 0){
+	notif_chain_invoke_partition(notif_chain, notif_chain_elem, 0, 1);
+}
 
-			continue;
-		}
+/* The read side critical section keeps the held queues, whose
+ * channels are retired through RCU, until the batch ends */
+void
+notif_chain_batch_begin(void){
 
-		notif_chain_elem_curr->notif_code = NOTIF_C_UNKNOWN;
+	notif_rcu_read_lock();
+	notif_outq_batch_begin();
+}
 
-		if(notif_chain_elem){
-			notif_chain_elem_curr->notif_code = 
-				notif_chain_elem->notif_code;
-			notif_chain_elem_curr->data.is_alloc_app_data_to_notify = 
-				notif_chain_elem->data.is_alloc_app_data_to_notify;
-			notif_chain_elem_curr->data.app_data_to_notify = 
-				notif_chain_elem->data.app_data_to_notify;
-			notif_chain_elem_curr->data.app_data_to_notify_size =
-				notif_chain_elem->data.app_data_to_notify_size;
-		}
-		notif_chain_invoke_communication_channel(
-				notif_chain,
-				notif_chain_elem_curr);
+void
+notif_chain_batch_end(void){
 
-	} ITERATE_GLTHREAD_END(&notif_chain->notif_chain_elem_head, curr);
+	notif_outq_batch_end();
+	notif_rcu_read_unlock();
 }
 
 static char *
@@ -503,7 +2129,7 @@ notif_chain_dump_comm_channel(
 			*notif_chain_comm_channel){
 
 	int rc = 0;
-	static char buffer[128];
+	static char buffer[256];
 	
 	memset(buffer, 0 , sizeof(buffer));
 
@@ -517,6 +2143,12 @@ notif_chain_dump_comm_channel(
 					notif_chain_get_str_notif_ch_type(
 						notif_chain_comm_channel->notif_ch_type),
 					NOTIF_CHAIN_ELEM_APP_CB(notif_chain_comm_channel));
+			if(NOTIF_CHAIN_ELEM_MAILBOX(notif_chain_comm_channel)){
+				rc += sprintf(buffer + rc, " mailbox : %p dropped : %llu",
+						NOTIF_CHAIN_ELEM_MAILBOX(notif_chain_comm_channel),
+						(unsigned long long)NOTIF_CHAIN_ELEM_MAILBOX(
+							notif_chain_comm_channel)->n_dropped);
+			}
 			break;
 		case NOTIF_C_MSG_Q:
 			rc += sprintf(buffer + rc, "%s : %s",
@@ -539,6 +2171,11 @@ notif_chain_dump_comm_channel(
 					NOTIF_CHAIN_ELEM_PORT_NO(notif_chain_comm_channel),
 					NOTIF_CHAIN_ELEM_PROTO(notif_chain_comm_channel),
 					NOTIF_CHAIN_ELEM_SKT_FD(notif_chain_comm_channel));
+			if(notif_chain_comm_channel->outq){
+				rc += sprintf(buffer + rc, "\n\t");
+				rc += notif_outq_dump(notif_chain_comm_channel->outq,
+						buffer + rc, sizeof(buffer) - rc);
+			}
 			break;
 		case NOTIF_C_NOT_KNOWN:
 			rc += sprintf(buffer + rc, "NOTIF_C_NOT_KNOWN");
@@ -548,8 +2185,8 @@ notif_chain_dump_comm_channel(
 	return buffer;
 }
 
-void
-notif_chain_dump(notif_chain_t *notif_chain){
+static void
+notif_chain_dump_subscribers(notif_chain_t *notif_chain){
 
 	char buffer[256];
 	glthread_t *curr;
@@ -558,8 +2195,7 @@ notif_chain_dump(notif_chain_t *notif_chain){
 	notif_chain_comm_channel_t *
 		notif_chain_comm_channel;
 
-	printf("notif chain Name : %s\n", notif_chain->name);
-
+	pthread_mutex_lock(&notif_chain->mutex);
 	ITERATE_GLTHREAD_BEGIN(&notif_chain->notif_chain_elem_head, curr){
 
 		notif_chain_elem_curr = glthread_glue_to_notif_chain_elem(curr);
@@ -587,6 +2223,36 @@ notif_chain_dump(notif_chain_t *notif_chain){
 
 		printf("\n\n");
 	} ITERATE_GLTHREAD_END(&notif_chain->notif_chain_elem_head, curr);	
+
+	pthread_mutex_unlock(&notif_chain->mutex);
+}
+
+void
+notif_chain_dump(notif_chain_t *notif_chain){
+
+	uint32_t i;
+
+	printf("notif chain Name : %s\n", notif_chain->name);
+	notif_post_dump(notif_chain);
+	notif_conflate_dump(notif_chain);
+
+	notif_chain_dump_subscribers(notif_chain);
+
+	if(notif_chain->shards){
+		for(i = 0; i < notif_chain->shards->n_shards; i++){
+			printf("shard %s :\n", notif_chain->shards->shards[i].name);
+			notif_chain_dump_subscribers(&notif_chain->shards->shards[i]);
+		}
+	}
+
+	/* Allocators are shared by all chains */
+	printf("Allocator Occupancy :\n");
+	notif_slab_dump(&notif_chain_elem_slab);
+	notif_slab_dump(&notif_chain_comm_channel_slab);
+	notif_slab_dump(&comm_channel_per_client_db_slab);
+	notif_slab_dump(&notif_chain_client_subs_slab);
+	notif_slab_dump(&notif_chain_key_bucket_slab);
+	notif_hash_dump_allocator();
 }
 
 bool
@@ -630,6 +2296,29 @@ notif_chain_subscribe(char *notif_chain_name,
 }
 
 
+uint32_t
+notif_chain_subscribe_bulk(char *notif_chain_name,
+		notif_chain_elem_t *notif_chain_elems,
+		uint32_t n_elems,
+		bool *subscribed){
+
+	notif_chain_t *notif_chain;
+
+	notif_chain = notif_chain_lookup_notif_chain_by_name(notif_chain_name);
+
+	if(!notif_chain){
+		printf("Appln dont have Notif Chain with name %s\n", 
+				notif_chain_name);
+		if(subscribed){
+			memset(subscribed, 0, n_elems * sizeof(bool));
+		}
+		return 0;
+	}
+
+	return notif_chain_register_chain_elements(notif_chain,
+			notif_chain_elems, n_elems, subscribed);
+}
+
 bool
 notif_chain_unsubscribe(char *notif_chain_name,
 		notif_chain_elem_t *notif_chain_elem){
@@ -664,6 +2353,24 @@ notif_chain_unsubscribe(char *notif_chain_name,
 	return true;
 }
 
+bool
+notif_chain_unsubscribe_all(char *notif_chain_name,
+		uint32_t client_id){
+
+	notif_chain_t *notif_chain;
+
+	notif_chain = notif_chain_lookup_notif_chain_by_name(notif_chain_name);
+
+	if(!notif_chain){
+		printf("Appln dont have Notif Chain with name %s\n", 
+				notif_chain_name);
+		return false;
+	}
+
+	notif_chain_deregister_client(notif_chain, client_id);
+	return true;
+}
+
 /* Two notif_chain_elem_t objects are said to be equal if :
  * 1. client ID is same and
  * 2. key is same
@@ -697,24 +2404,45 @@ notif_chain_lookup_notif_chain_element(
                 void *app_key_data,
                 uint32_t app_key_data_size){
 
-	glthread_t *curr;
-	notif_chain_elem_t *notif_chain_elem;
-	
-	ITERATE_GLTHREAD_BEGIN(&notif_chain->notif_chain_elem_head, curr){
+	uint32_t subs_hash;
+	notif_hash_entry_t *entry;
+	notif_chain_elem_t *notif_chain_elem, *found = NULL;
 
-		notif_chain_elem = glthread_glue_to_notif_chain_elem(curr);
+	if(notif_chain->shards && app_key_data && app_key_data_size){
+		notif_chain = notif_shard_lookup(notif_chain,
+				app_key_data, app_key_data_size);
+	}
+
+	subs_hash = notif_chain_compute_subs_hash(client_id,
+					app_key_data, app_key_data_size);
+
+	/* subs_index is resized and unlinked from under RCU only */
+	notif_rcu_read_lock();
+
+	ITERATE_NOTIF_HASH_BUCKET_BEGIN(&notif_chain->subs_index,
+			subs_hash, entry){
+
+		notif_chain_elem = (notif_chain_elem_t *)entry->data;
 
 		if (notif_chain_is_matching_notif_chain_element(
 										notif_chain_elem,
 										client_id,
 										app_key_data,
 										app_key_data_size)) {
-			return notif_chain_elem;
+			found = notif_chain_elem;
+			break;
 		}
-	} ITERATE_GLTHREAD_END(&notif_chain->notif_chain_elem_head, curr);
-	return NULL;
+	} ITERATE_NOTIF_HASH_BUCKET_END(&notif_chain->subs_index,
+			subs_hash, entry);
+
+	notif_rcu_read_unlock();
+	return found;
 }
 
+static void
+notif_chain_refresh_comm_channel_caps(uint32_t client_id,
+		notif_chain_comm_channel_t *notif_chain_comm_channel_template);
+
 void
 notif_chain_process_remote_subscriber_request(
 		char *subs_tlv_buffer, 
@@ -725,24 +2453,31 @@ notif_chain_process_remote_subscriber_request(
 
 	notif_ch_type_t notif_ch_type;
 	notif_ch_notify_opcode_t notif_code;
-	notif_chain_elem_t *notif_chain_elem;
+	notif_chain_elem_t notif_chain_elem;
+	notif_chain_comm_channel_t notif_chain_comm_channel;
 	char notif_chain_name[NOTIF_C_NOTIF_CHAIN_NAME_VALUE_LEN];
-	bool should_free;
 
-	should_free = false;
-	notif_chain_elem = notif_chain_deserialize_notif_chain_elem(
-			subs_tlv_buffer,
-			subs_tlv_buffer_size,
-			notif_chain_name);
+	/* Key and data stay in subs_tlv_buffer, the chain copies
+	 * them if it retains the element */
+	if(!notif_chain_deserialize_notif_chain_elem_view(
+				subs_tlv_buffer,
+				subs_tlv_buffer_size,
+				notif_chain_name,
+				&notif_chain_elem,
+				&notif_chain_comm_channel)){
+
+		printf("%s() : Error : Malformed subscription request\n",
+				__FUNCTION__);
+		return;
+	}
 
-	NOTIF_CHAIN_ELEM_SKT_FD(notif_chain_elem->notif_chain_comm_channel)
-		= subs_skt_fd;
+	NOTIF_CHAIN_ELEM_SKT_FD(&notif_chain_comm_channel) = subs_skt_fd;
 	
-	notif_ch_type = NOTIF_CHAIN_COMM_CH_TYPE(notif_chain_elem);
+	notif_ch_type = NOTIF_CHAIN_COMM_CH_TYPE((&notif_chain_elem));
 
 	assert(notif_ch_type != NOTIF_C_CALLBACKS);
 
-	notif_code = notif_chain_elem->notif_code;
+	notif_code = notif_chain_elem.notif_code;
 
 	switch(notif_code){
 
@@ -751,60 +2486,160 @@ notif_chain_process_remote_subscriber_request(
 		case PUB_TO_SUBS_NOTIF_C_DELETE:
 			assert(0);
 		case SUBS_TO_PUB_NOTIF_C_SUBSCRIBE:
-			should_free = !notif_chain_subscribe(notif_chain_name,
-					notif_chain_elem);
+			notif_chain_refresh_comm_channel_caps(
+					notif_chain_elem.client_id,
+					&notif_chain_comm_channel);
+			/* Chain registers its own copy of the element */
+			notif_chain_subscribe(notif_chain_name,
+					&notif_chain_elem);
 			break;
 		case SUBS_TO_PUB_NOTIF_C_UNSUBSCRIBE:
 			notif_chain_unsubscribe(notif_chain_name,
-					notif_chain_elem);
-			should_free = true;
+					&notif_chain_elem);
 			break;
 		case SUBS_TO_PUB_NOTIFY_C_NOTIFY_ALL:
 			break;
 		case SUBS_TO_PUB_NOTIFY_C_CLIENT_UNSUBSCRIBE_ALL:
+			notif_chain_unsubscribe_all(notif_chain_name,
+					notif_chain_elem.client_id);
 			break;
 		case NOTIF_C_UNKNOWN:
 		default:
 			return;
 	}
-	if(should_free) {
-		free(notif_chain_elem->notif_chain_comm_channel);
-		free(notif_chain_elem);
-	}
 }
 
-/* APIs to be used by client/subscribers to subscribe
- * with publishers*/
-bool
-notif_chain_subscribe_by_callback(
+/* Subscribers living in the publisher process */
+static bool
+notif_chain_subscribe_local(
 		char *notif_chain_name,
 		void *key,
 		uint32_t key_size,
 		uint32_t client_id,
-		notif_chain_app_cb cb){
+		notif_chain_app_cb cb,
+		notif_mailbox_t *mailbox){
 
+	bool res;
 	notif_chain_elem_t notif_chain_elem;
+	notif_chain_comm_channel_t notif_chain_comm_channel;
+
 	memset(&notif_chain_elem, 0, sizeof(notif_chain_elem_t));
 	notif_chain_elem.client_id = client_id;
 	notif_chain_elem.notif_code = SUBS_TO_PUB_NOTIF_C_SUBSCRIBE;
 
 	if(key && key_size){	
-		notif_chain_elem.data.app_key_data = calloc(1, key_size);
-		memcpy((char *)notif_chain_elem.data.app_key_data,
-				(char *)key, key_size);
-		notif_chain_elem.data.app_key_data_size = key_size;
+		notif_chain_elem_set_app_key_data(&notif_chain_elem,
+				key, key_size);
 	}
 
-	notif_chain_comm_channel_t notif_chain_comm_channel;
-	
-	 notif_chain_elem.notif_chain_comm_channel = 
+	memset(&notif_chain_comm_channel, 0, sizeof(notif_chain_comm_channel_t));
+	notif_chain_elem.notif_chain_comm_channel = 
 			&notif_chain_comm_channel;
 	notif_chain_comm_channel.notif_ch_type = NOTIF_C_CALLBACKS;
 	NOTIF_CHAIN_ELEM_APP_CB(&notif_chain_comm_channel) = cb;
-	notif_chain_subscribe(notif_chain_name, &notif_chain_elem);
-    if(notif_chain_elem.data.app_key_data){
-        free(notif_chain_elem.data.app_key_data);
-    }
+	NOTIF_CHAIN_ELEM_MAILBOX(&notif_chain_comm_channel) = mailbox;
+	res = notif_chain_subscribe(notif_chain_name, &notif_chain_elem);
+	notif_chain_elem_free_app_key_data(&notif_chain_elem);
+	return res;
+}
+
+/* APIs to be used by client/subscribers to subscribe
+ * with publishers*/
+bool
+notif_chain_subscribe_by_callback(
+		char *notif_chain_name,
+		void *key,
+		uint32_t key_size,
+		uint32_t client_id,
+		notif_chain_app_cb cb){
+
+	return notif_chain_subscribe_local(notif_chain_name,
+			key, key_size, client_id, cb, NULL);
+}
+
+bool
+notif_chain_subscribe_by_mailbox(
+		char *notif_chain_name,
+		void *key,
+		uint32_t key_size,
+		uint32_t client_id,
+		notif_mailbox_t *mailbox){
+
+	return notif_chain_subscribe_local(notif_chain_name,
+			key, key_size, client_id, mailbox->app_cb, mailbox);
+}
+
+/* All the TLVs of a subscriber request but the key */
+#define NOTIF_C_SUBS_REQ_TLV_BUFFER_SIZE	128
+
+#define NOTIF_C_CAPABILITIES_TLV_SIZE	\
+	(TLV_OVERHEAD_SIZE + NOTIF_C_CAPABILITIES_VALUE_LEN)
+
+/* Lets the publisher know what it may send back */
+static char *
+notif_chain_serialize_capabilities_tlv(char *output_buff){
+
+	uint32_t caps = NOTIF_C_LOCAL_CAPS;
+
+	return tlv_buffer_insert_tlv(output_buff,
+			NOTIF_C_CAPABILITIES_TLV,
+			NOTIF_C_CAPABILITIES_VALUE_LEN,
+			(char *)&caps);
+}
+
+/* Sends the keyless notif_chain_elem to the publisher, with key as
+ * its key. The key goes out of the caller's buffer behind its own
+ * TLV header, nothing is allocated nor concatenated */
+static int
+notif_chain_send_subscriber_request(char *notif_chain_name,
+		notif_chain_elem_t *notif_chain_elem,
+		void *key,
+		uint32_t key_size,
+		char *publisher_addr,
+		uint32_t publisher_port_no,
+		int sock_fd,
+		uint32_t protocol_no){
+
+	int iov_count = 0;
+	struct iovec iov[3];
+	char *tlv_buff_end;
+	char tlv_buff[NOTIF_C_SUBS_REQ_TLV_BUFFER_SIZE];
+	char key_tlv_hdr[TLV_WIDE_OVERHEAD_SIZE];
+
+	assert(!notif_chain_elem->data.app_key_data);
+	assert(notif_chain_compute_subscriber_tlv_size(notif_chain_elem) +
+		notif_chain_compute_publish_tlv_size(notif_chain_elem) +
+		NOTIF_C_CAPABILITIES_TLV_SIZE <= sizeof(tlv_buff));
+
+	tlv_buff_end = notif_chain_serialize_subscriber_tlvs(tlv_buff,
+			notif_chain_elem);
+	tlv_buff_end = notif_chain_serialize_publish_tlvs(tlv_buff_end,
+			notif_chain_name, notif_chain_elem);
+	tlv_buff_end = notif_chain_serialize_capabilities_tlv(tlv_buff_end);
+
+	iov[iov_count].iov_base = tlv_buff;
+	iov[iov_count].iov_len = tlv_buff_end - tlv_buff;
+	iov_count++;
+
+	/* For wild card subscription, key can be NULL */
+	if(key && key_size){
+
+		iov[iov_count].iov_base = key_tlv_hdr;
+		iov[iov_count].iov_len = tlv_buffer_insert_tlv_header(key_tlv_hdr,
+				NOTIF_C_APP_KEY_DATA_TLV, key_size) - key_tlv_hdr;
+		iov_count++;
+
+		iov[iov_count].iov_base = key;
+		iov[iov_count].iov_len = key_size;
+		iov_count++;
+	}
+
+	return notif_chain_send_msgv_to_publisher(publisher_addr,
+			publisher_port_no,
+			iov,
+			iov_count,
+			sock_fd,
+			protocol_no);
 }
 
 int
@@ -822,23 +2657,12 @@ notif_chain_subscribe_by_inet_skt(
 		int sock_fd){
 
 
-	char *subs_tlv_buff = NULL;
-	uint32_t subs_tlv_buff_size;
 	notif_chain_elem_t notif_chain_elem;
 
 	memset(&notif_chain_elem, 0, sizeof(notif_chain_elem_t));
 	notif_chain_elem.client_id = client_id;
 	notif_chain_elem.notif_code = op_code;
 
-	/* For wild card subscription, key can be NULL */
-	if(key && key_size){
-
-		notif_chain_elem.data.app_key_data = calloc(1, key_size);
-		memcpy((char *)notif_chain_elem.data.app_key_data,
-				(char *)key, key_size);
-		notif_chain_elem.data.app_key_data_size = key_size;
-	}
-
 	notif_chain_comm_channel_t notif_chain_comm_channel;
 
 	notif_chain_elem.notif_chain_comm_channel = 
@@ -853,33 +2677,14 @@ notif_chain_subscribe_by_inet_skt(
 
 	NOTIF_CHAIN_ELEM_PROTO(&notif_chain_comm_channel) = protocol_no;
 
-	subs_tlv_buff_size = notif_chain_serialize_notif_chain_elem(
-			notif_chain_name,
+	return notif_chain_send_subscriber_request(notif_chain_name,
 			&notif_chain_elem,
-			0,
-			0,
-			&subs_tlv_buff);
-
-	if(!subs_tlv_buff_size){
-		printf("%s() : Error : Msg send to publisher failed\n",
-				__FUNCTION__);
-		return false;
-	}
-
-	int new_sock_fd = notif_chain_send_msg_to_publisher(publisher_addr, 
+			key,
+			key_size,
+			publisher_addr,
 			publisher_port_no,
-			subs_tlv_buff,
-			subs_tlv_buff_size,
 			sock_fd,
 			protocol_no);
-
-    if(notif_chain_elem.data.app_key_data){
-        free(notif_chain_elem.data.app_key_data);
-    }
-	
-	free(subs_tlv_buff);
-	subs_tlv_buff = NULL;
-	return new_sock_fd;
 }
 
 bool
@@ -892,23 +2697,12 @@ notif_chain_subscribe_by_unix_skt(
 		char *publisher_addr,
 		uint16_t publisher_port_no){
 
-	char *subs_tlv_buff = NULL;
-	uint32_t subs_tlv_buff_size;
 	notif_chain_elem_t notif_chain_elem;
 
 	memset(&notif_chain_elem, 0, sizeof(notif_chain_elem_t));
 	notif_chain_elem.client_id = client_id;
 	notif_chain_elem.notif_code = SUBS_TO_PUB_NOTIF_C_SUBSCRIBE;
 
-	/* For wild card subscription, key can be NULL */
-	if(key && key_size){
-		notif_chain_elem.data.app_key_data = calloc(1, key_size);
-
-		memcpy((char *)notif_chain_elem.data.app_key_data,
-				(char *)key, key_size);
-		notif_chain_elem.data.app_key_data_size = key_size;
-	}
-
 	notif_chain_comm_channel_t notif_chain_comm_channel;
 	
 	notif_chain_elem.notif_chain_comm_channel = 
@@ -920,31 +2714,13 @@ notif_chain_subscribe_by_unix_skt(
 			subs_unix_skt_name, 
 			NOTIF_C_COMM_CHANNEL_UNIX_SKT_NAME_VALUE_LEN);
 
-	subs_tlv_buff_size = notif_chain_serialize_notif_chain_elem(
-			notif_chain_name,
+	notif_chain_send_subscriber_request(notif_chain_name,
 			&notif_chain_elem,
-			0,
-			0,
-			&subs_tlv_buff);
-
-	if(!subs_tlv_buff_size){
-		printf("%s() : Error : Msg send to publisher failed\n",
-				__FUNCTION__);
-		return false;
-	}
-
-	notif_chain_send_msg_to_publisher(publisher_addr, 
+			key,
+			key_size,
+			publisher_addr,
 			publisher_port_no,
-			subs_tlv_buff,
-			subs_tlv_buff_size,
 			-1, UINT32_MAX);
-
-    if(notif_chain_elem.data.app_key_data){
-        free(notif_chain_elem.data.app_key_data);
-    }
-
-	free(subs_tlv_buff);
-	subs_tlv_buff = NULL;
 	return true;
 }
 
@@ -958,24 +2734,12 @@ notif_chain_subscribe_msgq(
 		char *publisher_addr,
 		uint16_t publisher_port_no){
 
-	char *subs_tlv_buff = NULL;
-	uint32_t subs_tlv_buff_size;
 	notif_chain_elem_t notif_chain_elem;
 
 	memset(&notif_chain_elem, 0, sizeof(notif_chain_elem_t));
 	notif_chain_elem.client_id = client_id;
 	notif_chain_elem.notif_code = SUBS_TO_PUB_NOTIF_C_SUBSCRIBE;
 
-	/* For wild card subscription, key can be NULL */
-	if(key && key_size){
-
-		notif_chain_elem.data.app_key_data = calloc(1, key_size);
-
-		memcpy((char *)notif_chain_elem.data.app_key_data,
-				(char *)key, key_size);
-		notif_chain_elem.data.app_key_data_size = key_size;
-	}
-
 	notif_chain_comm_channel_t notif_chain_comm_channel;
 	
 	notif_chain_elem.notif_chain_comm_channel = 
@@ -987,85 +2751,85 @@ notif_chain_subscribe_msgq(
 			subs_msgq_name,
 			NOTIF_C_COMM_CHANNEL_MSGQ_NAME_VALUE_LEN);
 
-	subs_tlv_buff_size = notif_chain_serialize_notif_chain_elem(
-			notif_chain_name,
+	notif_chain_send_subscriber_request(notif_chain_name,
 			&notif_chain_elem,
-			0,
-			0,
-			&subs_tlv_buff);
-
-	if(!subs_tlv_buff_size){
-		printf("%s() : Error : Msg send to publisher failed\n",
-				__FUNCTION__);
-		return false;
-	}
-
-	notif_chain_send_msg_to_publisher(publisher_addr, 
+			key,
+			key_size,
+			publisher_addr,
 			publisher_port_no,
-			subs_tlv_buff,
-			subs_tlv_buff_size,
 			-1, UINT32_MAX);
-
-    if(notif_chain_elem.data.app_key_data){
-        free(notif_chain_elem.data.app_key_data);
-    }
-
-	free(subs_tlv_buff);
-	subs_tlv_buff = NULL;
 	return true;
 }
 
 /* APIs for Rx/Tx Msgs between Publisher and Subscribers
  * Over Network UDP Sockets*/
 static int
-notif_chain_send_udp_msg(
+notif_chain_send_udp_msgv(
 		char *dest_ip_addr,
 		uint32_t dest_port_no,
-		char *msg,
-		uint32_t msg_size,
+		struct iovec *iov,
+		int iov_count,
 		int sock_fd){
 
-	return send_udp_msg(dest_ip_addr,
+	return send_udp_msgv(dest_ip_addr,
 	   			 dest_port_no,
-				 msg, msg_size, sock_fd);
+				 iov, iov_count, sock_fd);
 }
 
 static int
-notif_chain_send_tcp_msg(char *dest_ip_addr,
+notif_chain_send_tcp_msgv(char *dest_ip_addr,
 		uint32_t dest_port_no,
+		struct iovec *iov,
+		int iov_count,
+		int sock_fd){
+
+	return tcp_send_msgv(dest_ip_addr,
+			dest_port_no, 
+			sock_fd, iov, iov_count);
+}
+
+int
+notif_chain_send_msg_to_publisher(char *publisher_addr,
+		uint32_t publisher_port_no,
 		char *msg,
 		uint32_t msg_size,
-		int sock_fd){
+		int sock_fd,
+		uint32_t protocol_no){
 
-	return tcp_send_msg(dest_ip_addr,
-			dest_port_no, 
-			sock_fd, msg, msg_size);
+	struct iovec iov;
+
+	iov.iov_base = msg;
+	iov.iov_len = msg_size;
+
+	return notif_chain_send_msgv_to_publisher(publisher_addr,
+			publisher_port_no, &iov, 1, sock_fd, protocol_no);
 }
 
 int
-notif_chain_send_msg_to_publisher(char *publisher_addr,
+notif_chain_send_msgv_to_publisher(char *publisher_addr,
 		uint32_t publisher_port_no,
-		char *msg,
-		uint32_t msg_size,
+		struct iovec *iov,
+		int iov_count,
 		int sock_fd,
 		uint32_t protocol_no){
 
 	switch(protocol_no){
 	case IPPROTO_UDP:
-	return notif_chain_send_udp_msg(publisher_addr, 
+	return notif_chain_send_udp_msgv(publisher_addr, 
 			publisher_port_no,
-			msg,
-			msg_size,
+			iov,
+			iov_count,
 			sock_fd);
 	case IPPROTO_TCP:
-	return notif_chain_send_tcp_msg(publisher_addr,
+	return notif_chain_send_tcp_msgv(publisher_addr,
 			publisher_port_no,
-			msg,
-			msg_size,
+			iov,
+			iov_count,
 			sock_fd);
 	default:
 	;
 	}
+	return -1;
 }
 
 int
@@ -1077,81 +2841,52 @@ notif_chain_send_msg_to_subscriber(
 		int sock_fd,
 		int protocol_no){
 
+	struct iovec iov;
+
+	iov.iov_base = msg;
+	iov.iov_len = msg_size;
+
+	return notif_chain_send_msgv_to_subscriber(subscriber_addr,
+			subscriber_port_no, &iov, 1, sock_fd, protocol_no);
+}
+
+int
+notif_chain_send_msgv_to_subscriber(
+		char *subscriber_addr,
+		uint32_t subscriber_port_no,
+		struct iovec *iov,
+		int iov_count,
+		int sock_fd,
+		int protocol_no){
+
 	assert(sock_fd > 0);
 
 	switch(protocol_no){
 	case IPPROTO_UDP:
-	return notif_chain_send_udp_msg(subscriber_addr,
+	return notif_chain_send_udp_msgv(subscriber_addr,
 			subscriber_port_no,
-			msg,
-			msg_size,
+			iov,
+			iov_count,
 			sock_fd);
 	case IPPROTO_TCP:
-	return notif_chain_send_tcp_msg(subscriber_addr,
+	return notif_chain_send_tcp_msgv(subscriber_addr,
 			subscriber_port_no,
-			msg,
-			msg_size,
+			iov,
+			iov_count,
 			sock_fd);
 	default:
 	;
 	}
+	return -1;
 }
 
 uint32_t
 notif_chain_compute_required_tlv_buffer_size_for_notif_chain_elem_encoding(
 		notif_chain_elem_t *notif_chain_elem){
 
-	uint32_t size = 0;
-
-	/* Mandatory TLVs*/
-	/* Notif chain name*/
-	size += TLV_OVERHEAD_SIZE + NOTIF_C_NOTIF_CHAIN_NAME_VALUE_LEN;
-
-	/* client id*/
-	size += TLV_OVERHEAD_SIZE + NOTIF_C_CLIENT_ID_VALUE_LEN;
-
-	/*notif code*/
-	size += TLV_OVERHEAD_SIZE + NOTIF_C_NOTIF_CODE_VALUE_LEN;
-
-	/* Non-Mandatory TLV*/
-	switch(NOTIF_CHAIN_COMM_CH_TYPE(notif_chain_elem)){
-
-		case NOTIF_C_CALLBACKS:
-			break;
-		case NOTIF_C_MSG_Q:
-			size += TLV_OVERHEAD_SIZE + NOTIF_C_COMM_CHANNEL_TYPE_VALUE_LEN;
-			size += TLV_OVERHEAD_SIZE + NOTIF_C_COMM_CHANNEL_MSGQ_NAME_VALUE_LEN;
-			break;
-		case NOTIF_C_AF_UNIX:
-			size += TLV_OVERHEAD_SIZE + NOTIF_C_COMM_CHANNEL_TYPE_VALUE_LEN;
-			size += TLV_OVERHEAD_SIZE + NOTIF_C_COMM_CHANNEL_UNIX_SKT_NAME_VALUE_LEN;
-			break;
-		case NOTIF_C_INET_SOCKETS:
-			size += TLV_OVERHEAD_SIZE + NOTIF_C_COMM_CHANNEL_TYPE_VALUE_LEN;
-			size += TLV_OVERHEAD_SIZE + NOTIF_C_IP_ADDR_VALUE_LEN;
-			size += TLV_OVERHEAD_SIZE + NOTIF_C_PORT_NO_VALUE_LEN;
-			size += TLV_OVERHEAD_SIZE + NOTIF_C_PROTOCOL_NO_VALUE_LEN;
-			break;
-		case NOTIF_C_NOT_KNOWN:
-			break;
-		default:
-			;
-	}
-
-
-	if(notif_chain_elem->data.app_key_data && 
-			notif_chain_elem->data.app_key_data_size){
-
-		size += TLV_OVERHEAD_SIZE + notif_chain_elem->data.app_key_data_size;
-	}
-
-	if(notif_chain_elem->data.app_data_to_notify &&
-			notif_chain_elem->data.app_data_to_notify_size){
-
-		size += TLV_OVERHEAD_SIZE + notif_chain_elem->data.app_data_to_notify_size;
-	}
-
-	return size;
+	return notif_chain_compute_subscriber_tlv_size(notif_chain_elem) +
+		notif_chain_compute_publish_tlv_size(notif_chain_elem) +
+		NOTIF_C_CAPABILITIES_TLV_SIZE;
 }
 
 uint32_t
@@ -1164,8 +2899,6 @@ notif_chain_serialize_notif_chain_elem(
 
 	char *output_buff;
 	uint32_t tlv_buff_cal_size = 0 ;
-	notif_chain_comm_channel_t *
-		notif_chain_comm_channel = NULL;
 
 	/* If neither output buffer provided, nor are
 	 * we being asked to allocate new one, then
@@ -1212,109 +2945,115 @@ notif_chain_serialize_notif_chain_elem(
 		return 0;
 	}
 
-	/* Mandatory TLVs First*/
-	output_buff = tlv_buffer_insert_tlv(output_buff,
-			NOTIF_C_NOTIF_CHAIN_NAME_TLV,
-			NOTIF_C_NOTIF_CHAIN_NAME_VALUE_LEN,
-			notif_chain_name);
+	/* Laid out as for a publish to a socket subscriber, see
+	 * notif_chain_encode_publish(). TLVs may come in any order */
+	output_buff = notif_chain_serialize_subscriber_tlvs(output_buff,
+			notif_chain_elem);
+	output_buff = notif_chain_serialize_publish_tlvs(output_buff,
+			notif_chain_name, notif_chain_elem);
+	output_buff = notif_chain_serialize_capabilities_tlv(output_buff);
 
-	output_buff = tlv_buffer_insert_tlv(output_buff,
-			NOTIF_C_CLIENT_ID_TLV,
-			NOTIF_C_CLIENT_ID_VALUE_LEN,
-			(char *)&(notif_chain_elem->client_id));
+	return tlv_buff_cal_size;
+}
 
-	output_buff = tlv_buffer_insert_tlv(output_buff,
-			NOTIF_C_NOTIF_CODE_TLV,
-			NOTIF_C_NOTIF_CODE_VALUE_LEN,
-			(char *)&(notif_chain_elem->notif_code));
+uint32_t
+notif_chain_for_each_notification(char *msg,
+		uint32_t msg_size,
+		notif_chain_record_cb record_cb,
+		void *arg){
 
-	notif_chain_comm_channel = notif_chain_elem->notif_chain_comm_channel;
+	uint8_t tlv_type, *tlv_value;
+	uint32_t tlv_len, n_records = 0;
 
-	/*Non-Mandatory TLVs now*/
-	switch(NOTIF_CHAIN_COMM_CH_TYPE(notif_chain_elem)){
-		case NOTIF_C_CALLBACKS:
-			break;
-		case NOTIF_C_MSG_Q:
-		case NOTIF_C_AF_UNIX:
-			output_buff = tlv_buffer_insert_tlv(output_buff,
-					NOTIF_C_COMM_CHANNEL_TYPE_TLV,
-					NOTIF_C_COMM_CHANNEL_TYPE_VALUE_LEN,
-					(char *)&(NOTIF_CHAIN_COMM_CH_TYPE(notif_chain_elem)));
-			output_buff = tlv_buffer_insert_tlv(output_buff,
-					NOTIF_C_COMM_CHANNEL_NAME_TLV,
+	if(!msg_size) return 0;
 
-					NOTIF_CHAIN_COMM_CH_TYPE(notif_chain_elem) == NOTIF_C_MSG_Q ?
-					NOTIF_C_COMM_CHANNEL_MSGQ_NAME_VALUE_LEN :
-					NOTIF_C_COMM_CHANNEL_UNIX_SKT_NAME_VALUE_LEN,
+	/* Anything but a frame is a lone notification */
+	if(*(uint8_t *)msg != NOTIF_C_FRAME_TLV){
+		record_cb(msg, msg_size, arg);
+		return 1;
+	}
 
-					NOTIF_CHAIN_COMM_CH_TYPE(notif_chain_elem) == NOTIF_C_MSG_Q ?
-					NOTIF_CHAIN_ELEM_MSGQ_NAME(notif_chain_comm_channel) :
-					NOTIF_CHAIN_ELEM_SKT_NAME(notif_chain_comm_channel));
-			break;
-		case NOTIF_C_INET_SOCKETS:
-			output_buff = tlv_buffer_insert_tlv(output_buff,
-					NOTIF_C_COMM_CHANNEL_TYPE_TLV,
-					NOTIF_C_COMM_CHANNEL_TYPE_VALUE_LEN,
-					(char *)&(NOTIF_CHAIN_COMM_CH_TYPE(notif_chain_elem)));
+	ITERATE_TLV_BEGIN(msg, tlv_type,
+			tlv_len, tlv_value,
+			msg_size){
 
-			output_buff = tlv_buffer_insert_tlv(output_buff,
-					NOTIF_C_IP_ADDR_TLV,
-					NOTIF_C_IP_ADDR_VALUE_LEN,
-					(char *)&(NOTIF_CHAIN_ELEM_IP_ADDR(notif_chain_comm_channel)));
+		if(tlv_type != NOTIF_C_FRAME_RECORD_TLV) continue;
+		record_cb((char *)tlv_value, tlv_len, arg);
+		n_records++;
+	}ITERATE_TLV_END(msg, tlv_type,
+			tlv_len, tlv_value,
+			msg_size);
 
-			output_buff = tlv_buffer_insert_tlv(output_buff,
-					NOTIF_C_PORT_NO_TLV,
-					NOTIF_C_PORT_NO_VALUE_LEN,
-					(char *)&(NOTIF_CHAIN_ELEM_PORT_NO(notif_chain_comm_channel)));
+	return n_records;
+}
 
-			output_buff = tlv_buffer_insert_tlv(output_buff,
-					NOTIF_C_PROTOCOL_NO_TLV,
-					NOTIF_C_PROTOCOL_NO_VALUE_LEN,
-					(char *)&(NOTIF_CHAIN_ELEM_PROTO(notif_chain_comm_channel)));
-			break;
-		case NOTIF_C_NOT_KNOWN:
-			break;
-		default:
-			;
-	}
+void
+notif_chain_print_notification(char *tlv_buffer,
+		uint32_t tlv_buff_size,
+		void *arg){
 
+	char notif_chain_name[NOTIF_C_NOTIF_CHAIN_NAME_VALUE_LEN];
+	notif_chain_elem_t notif_chain_elem;
+	notif_chain_comm_channel_t notif_chain_comm_channel;
 
-	if(notif_chain_elem->data.app_key_data &&
-			notif_chain_elem->data.app_key_data_size){
+	(void)arg;
 
-		output_buff = tlv_buffer_insert_tlv(output_buff,
-				NOTIF_C_APP_KEY_DATA_TLV,
-				notif_chain_elem->data.app_key_data_size,
-				(char *)notif_chain_elem->data.app_key_data);
+	if(!notif_chain_deserialize_notif_chain_elem_view(tlv_buffer,
+				tlv_buff_size, notif_chain_name,
+				&notif_chain_elem, &notif_chain_comm_channel)){
+		return;
 	}
 
-	if(notif_chain_elem->data.app_data_to_notify &&
-			notif_chain_elem->data.app_data_to_notify_size){
+	printf("%s() : %s : %s\n", __FUNCTION__, notif_chain_name,
+			notif_chain_get_str_notify_opcode(notif_chain_elem.notif_code));
+}
 
-		output_buff = tlv_buffer_insert_tlv(output_buff,
-				NOTIF_C_APP_DATA_TO_NOTIFY_TLV,
-				notif_chain_elem->data.app_data_to_notify_size,
-				(char *)notif_chain_elem->data.app_data_to_notify);
+/* Values are copied into fixed size fields : a scalar's TLV must be
+ * exactly its size, a name's at most its field's size */
+static bool
+notif_chain_tlv_len_is_valid(uint8_t tlv_type,
+		uint32_t tlv_len,
+		uint32_t value_len,
+		bool is_name){
+
+	if(is_name ? tlv_len <= value_len : tlv_len == value_len){
+		return true;
 	}
 
-	return tlv_buff_cal_size;
+	printf("%s() : Error : TLV %u of length %u, expected %s%u\n",
+			__FUNCTION__, tlv_type, tlv_len,
+			is_name ? "at most " : "", value_len);
+	return false;
 }
 
-notif_chain_elem_t *
-notif_chain_deserialize_notif_chain_elem(
+/* name_size bytes at most, NUL terminated even if the sender's
+ * name filled its field */
+static void
+notif_chain_copy_tlv_name(char *name,
+		uint32_t name_size,
+		uint8_t *tlv_value,
+		uint32_t tlv_len){
+
+	memcpy(name, tlv_value, tlv_len);
+	name[tlv_len < name_size ? tlv_len : name_size - 1] = '\0';
+}
+
+bool
+notif_chain_deserialize_notif_chain_elem_view(
 		char *tlv_buffer,
 		uint32_t tlv_buff_size,
-		char *notif_chain_name /*o/p*/){
+		char *notif_chain_name, /*o/p*/
+		notif_chain_elem_t *notif_chain_elem, /*o/p*/
+		notif_chain_comm_channel_t *notif_chain_comm_channel /*o/p*/){
 
-	notif_chain_elem_t *notif_chain_elem;
-	uint8_t tlv_type, tlv_len, *tlv_value;
-	notif_chain_comm_channel_t *
-		notif_chain_comm_channel = NULL;
+	uint8_t tlv_type, *tlv_value;
+	uint32_t tlv_len;
 
 	assert(notif_chain_name);
 
-	notif_chain_elem = calloc(1, sizeof(notif_chain_elem_t));
-	notif_chain_comm_channel = calloc(1, sizeof(notif_chain_comm_channel_t));
+	notif_chain_name[0] = '\0';
+	memset(notif_chain_elem, 0, sizeof(notif_chain_elem_t));
+	memset(notif_chain_comm_channel, 0, sizeof(notif_chain_comm_channel_t));
 	notif_chain_elem->notif_chain_comm_channel = notif_chain_comm_channel;
 
 	ITERATE_TLV_BEGIN(tlv_buffer, tlv_type,
@@ -1324,13 +3063,27 @@ notif_chain_deserialize_notif_chain_elem(
 		switch(tlv_type){
 
 			case NOTIF_C_NOTIF_CHAIN_NAME_TLV:
-				strncpy(notif_chain_name, tlv_value, tlv_len);
+				if(!notif_chain_tlv_len_is_valid(tlv_type, tlv_len,
+							NOTIF_C_NOTIF_CHAIN_NAME_VALUE_LEN, true)){
+					return false;
+				}
+				notif_chain_copy_tlv_name(notif_chain_name,
+						NOTIF_C_NOTIF_CHAIN_NAME_VALUE_LEN,
+						tlv_value, tlv_len);
 				break;
 			case NOTIF_C_CLIENT_ID_TLV:
+				if(!notif_chain_tlv_len_is_valid(tlv_type, tlv_len,
+							NOTIF_C_CLIENT_ID_VALUE_LEN, false)){
+					return false;
+				}
 				memcpy((char *)&notif_chain_elem->client_id,
 						tlv_value, tlv_len);
 				break;
 			case NOTIF_C_COMM_CHANNEL_TYPE_TLV:
+				if(!notif_chain_tlv_len_is_valid(tlv_type, tlv_len,
+							NOTIF_C_COMM_CHANNEL_TYPE_VALUE_LEN, false)){
+					return false;
+				}
 				memcpy((char *)&(NOTIF_CHAIN_COMM_CH_TYPE(notif_chain_elem)),
 						tlv_value, tlv_len);
 				break;
@@ -1339,11 +3092,23 @@ notif_chain_deserialize_notif_chain_elem(
 					case NOTIF_C_CALLBACKS:
 						break;
 					case NOTIF_C_MSG_Q:
-						memcpy(NOTIF_CHAIN_ELEM_MSGQ_NAME(notif_chain_comm_channel),
+						if(!notif_chain_tlv_len_is_valid(tlv_type, tlv_len,
+								NOTIF_C_COMM_CHANNEL_MSGQ_NAME_VALUE_LEN, true)){
+							return false;
+						}
+						notif_chain_copy_tlv_name(
+								NOTIF_CHAIN_ELEM_MSGQ_NAME(notif_chain_comm_channel),
+								NOTIF_C_COMM_CHANNEL_MSGQ_NAME_VALUE_LEN,
 								tlv_value, tlv_len);
 						break;
 					case NOTIF_C_AF_UNIX:
-						memcpy(NOTIF_CHAIN_ELEM_SKT_NAME(notif_chain_comm_channel),
+						if(!notif_chain_tlv_len_is_valid(tlv_type, tlv_len,
+								NOTIF_C_COMM_CHANNEL_UNIX_SKT_NAME_VALUE_LEN, true)){
+							return false;
+						}
+						notif_chain_copy_tlv_name(
+								NOTIF_CHAIN_ELEM_SKT_NAME(notif_chain_comm_channel),
+								NOTIF_C_COMM_CHANNEL_UNIX_SKT_NAME_VALUE_LEN,
 								tlv_value, tlv_len);
 						break;
 					case NOTIF_C_INET_SOCKETS:
@@ -1355,35 +3120,60 @@ notif_chain_deserialize_notif_chain_elem(
 				}
 				break;
 			case NOTIF_C_IP_ADDR_TLV:
+				if(!notif_chain_tlv_len_is_valid(tlv_type, tlv_len,
+							NOTIF_C_IP_ADDR_VALUE_LEN, false)){
+					return false;
+				}
 				memcpy((char *)&(NOTIF_CHAIN_ELEM_IP_ADDR(notif_chain_comm_channel)),
 						tlv_value, tlv_len);
 				break;
 			case NOTIF_C_PORT_NO_TLV:
+				if(!notif_chain_tlv_len_is_valid(tlv_type, tlv_len,
+							NOTIF_C_PORT_NO_VALUE_LEN, false)){
+					return false;
+				}
 				memcpy((char *)&(NOTIF_CHAIN_ELEM_PORT_NO(notif_chain_comm_channel)),
 						tlv_value, tlv_len);
 				break;
 			case NOTIF_C_PROTOCOL_NO_TLV:
+				if(!notif_chain_tlv_len_is_valid(tlv_type, tlv_len,
+							NOTIF_C_PROTOCOL_NO_VALUE_LEN, false)){
+					return false;
+				}
 				memcpy((char *)&(NOTIF_CHAIN_ELEM_PROTO(notif_chain_comm_channel)),
 						tlv_value, tlv_len);
 				break;
 			case NOTIF_C_NOTIF_CODE_TLV:
+				if(!notif_chain_tlv_len_is_valid(tlv_type, tlv_len,
+							NOTIF_C_NOTIF_CODE_VALUE_LEN, false)){
+					return false;
+				}
 				memcpy((char *)&notif_chain_elem->notif_code,
 						tlv_value, tlv_len);
 				break;
 			case NOTIF_C_APP_KEY_DATA_TLV:
-				notif_chain_elem->data.app_key_data = (char *)calloc(1,
-						tlv_len);
-				memcpy((char *)notif_chain_elem->data.app_key_data,
-						tlv_value, tlv_len);
-				notif_chain_elem->data.app_key_data_size = (uint32_t)tlv_len;
+				/* Small keys are copied inline, which keeps them
+				 * aligned for comp_cb, larger ones stay in place */
+				if(tlv_len <= sizeof(notif_chain_elem->data.app_key_data_inline)){
+					notif_chain_elem_set_app_key_data(notif_chain_elem,
+							tlv_value, tlv_len);
+				}
+				else {
+					notif_chain_elem->data.app_key_data = tlv_value;
+					notif_chain_elem->data.app_key_data_size = tlv_len;
+				}
 				break;
 			case NOTIF_C_APP_DATA_TO_NOTIFY_TLV:
-				notif_chain_elem->data.app_data_to_notify = (char *)calloc(1,
-						tlv_len);
-				memcpy((char *)notif_chain_elem->data.app_data_to_notify,
+				notif_chain_elem->data.app_data_to_notify = tlv_value;
+				notif_chain_elem->data.app_data_to_notify_size = tlv_len;
+				break;
+			case NOTIF_C_CAPABILITIES_TLV:
+				if(!notif_chain_tlv_len_is_valid(tlv_type, tlv_len,
+							NOTIF_C_CAPABILITIES_VALUE_LEN, false)){
+					return false;
+				}
+				memcpy((char *)&notif_chain_comm_channel->peer_caps,
 						tlv_value, tlv_len);
-				notif_chain_elem->data.app_data_to_notify_size = (uint32_t)tlv_len;
-				notif_chain_elem->data.is_alloc_app_data_to_notify = true;
 				break;
 			default:
 				;
@@ -1392,9 +3182,66 @@ notif_chain_deserialize_notif_chain_elem(
 			tlv_len, tlv_value,
 			tlv_buff_size);
 
+	return true;
+}
+
+notif_chain_elem_t *
+notif_chain_deserialize_notif_chain_elem(
+		char *tlv_buffer,
+		uint32_t tlv_buff_size,
+		char *notif_chain_name /*o/p*/){
+
+	void *view_data;
+	notif_chain_elem_t *notif_chain_elem;
+	notif_chain_comm_channel_t *notif_chain_comm_channel;
+
+	notif_chain_elem = notif_slab_alloc(&notif_chain_elem_slab);
+	notif_chain_comm_channel = notif_slab_alloc(&notif_chain_comm_channel_slab);
+
+	if(!notif_chain_deserialize_notif_chain_elem_view(tlv_buffer,
+				tlv_buff_size, notif_chain_name,
+				notif_chain_elem, notif_chain_comm_channel)){
+
+		notif_slab_free(&notif_chain_comm_channel_slab,
+				notif_chain_comm_channel);
+		notif_slab_free(&notif_chain_elem_slab, notif_chain_elem);
+		return NULL;
+	}
+
+	/* Detach the element from tlv_buffer */
+	if(notif_chain_elem->data.app_key_data &&
+		!NOTIF_CHAIN_ELEM_KEY_IS_INLINE(notif_chain_elem)){
+
+		view_data = notif_chain_elem->data.app_key_data;
+		notif_chain_elem_set_app_key_data(notif_chain_elem,
+				view_data, notif_chain_elem->data.app_key_data_size);
+	}
+
+	if(notif_chain_elem->data.app_data_to_notify){
+
+		view_data = notif_chain_elem->data.app_data_to_notify;
+		notif_chain_elem->data.app_data_to_notify = 
+			malloc(notif_chain_elem->data.app_data_to_notify_size);
+		memcpy(notif_chain_elem->data.app_data_to_notify,
+				view_data, notif_chain_elem->data.app_data_to_notify_size);
+		notif_chain_elem->data.is_alloc_app_data_to_notify = true;
+	}
 	return notif_chain_elem;
 }
 
+void
+notif_chain_free_deserialized_notif_chain_elem(
+		notif_chain_elem_t *notif_chain_elem){
+
+	notif_chain_elem_free_app_key_data(notif_chain_elem);
+	if(notif_chain_elem->data.app_data_to_notify){
+		free(notif_chain_elem->data.app_data_to_notify);
+	}
+	notif_slab_free(&notif_chain_comm_channel_slab,
+			notif_chain_elem->notif_chain_comm_channel);
+	notif_slab_free(&notif_chain_elem_slab, notif_chain_elem);
+}
+
 bool
 notif_chain_resurrect_communication_channel(
 		notif_chain_comm_channel_t *notif_chain_comm_channel){
@@ -1402,68 +3249,121 @@ notif_chain_resurrect_communication_channel(
 	return true;
 }
 
+static notif_chain_comm_channel_t *
+notif_chain_find_matching_comm_channel_per_client(
+        uint32_t client_id,
+        notif_chain_comm_channel_t *notif_chain_comm_channel_template);
+
+/* A socket subscriber tells its capabilities with every request, it
+ * may have been restarted by another version since the channel was
+ * recorded */
+static void
+notif_chain_refresh_comm_channel_caps(uint32_t client_id,
+		notif_chain_comm_channel_t *notif_chain_comm_channel_template){
+
+	notif_chain_comm_channel_t *existing_comm_channel;
+
+	pthread_mutex_lock(&notif_chain_db.mutex);
+
+	existing_comm_channel = notif_chain_find_matching_comm_channel_per_client(
+			client_id, notif_chain_comm_channel_template);
+
+	if(existing_comm_channel && existing_comm_channel->outq){
+		__atomic_store_n(&existing_comm_channel->peer_caps,
+				notif_chain_comm_channel_template->peer_caps,
+				__ATOMIC_RELAXED);
+		notif_outq_set_wide_tlv(existing_comm_channel->outq,
+				notif_chain_comm_channel_template->peer_caps &
+				NOTIF_C_CAP_WIDE_TLV);
+	}
+
+	pthread_mutex_unlock(&notif_chain_db.mutex);
+}
+
 notif_chain_comm_channel_t *
 notif_chain_record_comm_channel_per_client(
 		uint32_t client_id,
 		notif_chain_comm_channel_t *notif_chain_comm_channel_template){
 
-	glthread_t *curr;
-	comm_channel_per_client_db_t *comm_channel_per_client_db_curr;
+	comm_channel_per_client_db_t *comm_channel_per_client_db;
+
+	pthread_mutex_lock(&notif_chain_db.mutex);
 
 	notif_chain_comm_channel_t *existing_comm_channel = 
-		notif_chain_lookup_matching_comm_channel_per_client(
+		notif_chain_find_matching_comm_channel_per_client(
 			client_id,
 			notif_chain_comm_channel_template);
 
 	if (existing_comm_channel) {
 
 		existing_comm_channel->ref_count++;
+		pthread_mutex_unlock(&notif_chain_db.mutex);
 		return existing_comm_channel;
 	}
 
 	notif_chain_comm_channel_t *new_comm_channel = 
-		notif_chain_comm_channel_template;
+		notif_slab_alloc(&notif_chain_comm_channel_slab);
+
+	memcpy(new_comm_channel, notif_chain_comm_channel_template,
+			sizeof(notif_chain_comm_channel_t));
 
 	new_comm_channel->ref_count = 1;
+	new_comm_channel->client_id = client_id;
+	new_comm_channel->channel_hash = 
+		notif_chain_compute_comm_channel_hash(client_id, new_comm_channel);
 	init_glthread(&new_comm_channel->glue);
 
-	ITERATE_GLTHREAD_BEGIN(
-		&notif_chain_db.comm_channel_per_client_db_head,
-		curr){
+	/* A socket subscriber slow to read must not hold up the
+	 * publish, it is written to through a bounded queue */
+	new_comm_channel->outq = NULL;
+	if(new_comm_channel->notif_ch_type == NOTIF_C_INET_SOCKETS){
+		new_comm_channel->outq = notif_outq_create(
+				NOTIF_CHAIN_ELEM_SKT_FD(new_comm_channel),
+				NOTIF_CHAIN_ELEM_PROTO(new_comm_channel),
+				NOTIF_CHAIN_ELEM_IP_ADDR(new_comm_channel),
+				NOTIF_CHAIN_ELEM_PORT_NO(new_comm_channel));
+		notif_outq_set_wide_tlv(new_comm_channel->outq,
+				new_comm_channel->peer_caps & NOTIF_C_CAP_WIDE_TLV);
+	}
 
-		comm_channel_per_client_db_curr = 
-			glthread_glue_to_comm_channel_per_client_db(curr);
+	notif_hash_table_insert(&notif_chain_db.comm_channel_index,
+			new_comm_channel->channel_hash,
+			(void *)new_comm_channel);
 
-		if(comm_channel_per_client_db_curr->client_id != client_id){
-			continue;
-		}
+	comm_channel_per_client_db = 
+		notif_chain_lookup_comm_channel_per_client_db(client_id);
+
+	if(comm_channel_per_client_db){
 
 		glthread_add_next(
-			&comm_channel_per_client_db_curr->comm_channel_head,
+			&comm_channel_per_client_db->comm_channel_head,
 			&new_comm_channel->glue);
 		
+		pthread_mutex_unlock(&notif_chain_db.mutex);
 		return new_comm_channel;
-			
-	}ITERATE_GLTHREAD_END(
-		&notif_chain_db.comm_channel_per_client_db_head,
-		curr);
+	}
 
-	comm_channel_per_client_db_curr = calloc(1,
-			sizeof(comm_channel_per_client_db_t));
+	comm_channel_per_client_db = 
+		notif_slab_alloc(&comm_channel_per_client_db_slab);
 
-	comm_channel_per_client_db_curr->client_id = client_id;
-	init_glthread(&comm_channel_per_client_db_curr->comm_channel_head);
-	init_glthread(&comm_channel_per_client_db_curr->glue);
+	comm_channel_per_client_db->client_id = client_id;
+	init_glthread(&comm_channel_per_client_db->comm_channel_head);
+	init_glthread(&comm_channel_per_client_db->glue);
 
 	glthread_add_next(&notif_chain_db.comm_channel_per_client_db_head,
-		&comm_channel_per_client_db_curr->glue);
+		&comm_channel_per_client_db->glue);
+
+	notif_hash_table_insert(&notif_chain_db.comm_channel_per_client_db_index,
+			notif_chain_compute_client_hash(client_id),
+			(void *)comm_channel_per_client_db);
 
 	glthread_add_next(
-		&comm_channel_per_client_db_curr->comm_channel_head,
+		&comm_channel_per_client_db->comm_channel_head,
 		&new_comm_channel->glue);
 	
 	notif_chain_resurrect_communication_channel(new_comm_channel);
 
+	pthread_mutex_unlock(&notif_chain_db.mutex);
 	return new_comm_channel;
 }
 
@@ -1472,43 +3372,84 @@ notif_chain_lookup_matching_comm_channel_per_client(
         uint32_t client_id,
         notif_chain_comm_channel_t *notif_chain_comm_channel_template){
 
-	glthread_t *curr1, *curr2;
+	notif_chain_comm_channel_t *notif_chain_comm_channel;
+
+	pthread_mutex_lock(&notif_chain_db.mutex);
+	notif_chain_comm_channel = 
+		notif_chain_find_matching_comm_channel_per_client(
+			client_id, notif_chain_comm_channel_template);
+	pthread_mutex_unlock(&notif_chain_db.mutex);
+	return notif_chain_comm_channel;
+}
+
+uint32_t
+notif_chain_set_client_outq_policy(uint32_t client_id,
+		notif_outq_policy_t policy,
+		uint32_t max_depth){
+
+	glthread_t *curr;
+	uint32_t n_updated = 0;
+	notif_chain_comm_channel_t *notif_chain_comm_channel;
+	comm_channel_per_client_db_t *comm_channel_per_client_db;
+
+	pthread_mutex_lock(&notif_chain_db.mutex);
+
+	comm_channel_per_client_db = 
+		notif_chain_lookup_comm_channel_per_client_db(client_id);
+
+	if(!comm_channel_per_client_db){
+		pthread_mutex_unlock(&notif_chain_db.mutex);
+		return 0;
+	}
+
+	ITERATE_GLTHREAD_BEGIN(&comm_channel_per_client_db->comm_channel_head, curr){
+
+		notif_chain_comm_channel = glthread_glue_to_notif_chain_comm_channel(curr);
+
+		if(notif_chain_comm_channel->outq &&
+			notif_outq_set_policy(notif_chain_comm_channel->outq,
+				policy, max_depth)){
+			n_updated++;
+		}
+	} ITERATE_GLTHREAD_END(&comm_channel_per_client_db->comm_channel_head, curr);
+
+	pthread_mutex_unlock(&notif_chain_db.mutex);
+	return n_updated;
+}
+
+/* Called with notif_chain_db.mutex held */
+static notif_chain_comm_channel_t *
+notif_chain_find_matching_comm_channel_per_client(
+        uint32_t client_id,
+        notif_chain_comm_channel_t *notif_chain_comm_channel_template){
+
+	uint32_t channel_hash;
+	notif_hash_entry_t *entry;
 	notif_chain_comm_channel_t *notif_chain_comm_channel_curr;
-	comm_channel_per_client_db_t *comm_channel_per_client_db_curr;
 
-	ITERATE_GLTHREAD_BEGIN(
-		&notif_chain_db.comm_channel_per_client_db_head,
-		curr1){
+	channel_hash = notif_chain_compute_comm_channel_hash(client_id,
+						notif_chain_comm_channel_template);
 
-		comm_channel_per_client_db_curr = 
-			glthread_glue_to_comm_channel_per_client_db(curr1);
-		
-		if (comm_channel_per_client_db_curr->client_id != client_id){
+	ITERATE_NOTIF_HASH_BUCKET_BEGIN(&notif_chain_db.comm_channel_index,
+		channel_hash, entry){
+
+		notif_chain_comm_channel_curr = 
+			(notif_chain_comm_channel_t *)entry->data;
+
+		if (notif_chain_comm_channel_curr->client_id != client_id){
 			continue;
 		}
 
-		ITERATE_GLTHREAD_BEGIN(
-			&comm_channel_per_client_db_curr->comm_channel_head,
-			curr2){
-		
-			notif_chain_comm_channel_curr = 
-				glthread_glue_to_notif_chain_comm_channel(curr2);
-
-			if (!notif_chain_communication_channel_match(
-					notif_chain_comm_channel_curr,
-					notif_chain_comm_channel_template)) {
-			 continue;
-			}
+		if (!notif_chain_communication_channel_match(
+				notif_chain_comm_channel_curr,
+				notif_chain_comm_channel_template)) {
+			continue;
+		}
 
-			return notif_chain_comm_channel_curr;
+		return notif_chain_comm_channel_curr;
 
-		} ITERATE_GLTHREAD_END(
-			&comm_channel_per_client_db_curr->comm_channel_head,
-			curr2);
-		
-	} ITERATE_GLTHREAD_END(
-		&notif_chain_db.comm_channel_per_client_db_head,
-		curr1);
+	} ITERATE_NOTIF_HASH_BUCKET_END(&notif_chain_db.comm_channel_index,
+		channel_hash, entry);
 
 	return NULL;
 }
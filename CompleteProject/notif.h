@@ -35,10 +35,19 @@
 #include <stdbool.h>
 #include <assert.h>
 #include <unistd.h>
+#include <pthread.h>
+#include <sys/uio.h>
 #include "gluethread/glthread.h"
+#include "notif_hash.h"
+#include "notif_trie.h"
+#include "notif_outq.h"
 
 typedef struct notif_chain_elem_ notif_chain_elem_t;
 typedef struct notif_chain_ notif_chain_t;
+typedef struct notif_mailbox_ notif_mailbox_t;
+typedef struct notif_chain_conflation_ notif_chain_conflation_t;
+typedef struct notif_chain_shards_ notif_chain_shards_t;
+typedef struct notif_chain_post_queue_ notif_chain_post_queue_t;
 typedef int (*notif_chain_comp_cb)(void *data1, uint32_t data_size1,
                                    void *data2, uint32_t data_size2);
 typedef void (*notif_chain_app_cb)(notif_chain_elem_t *notif_chain_elem);
@@ -46,8 +55,22 @@ typedef char * (*app_key_data_print_cb)(void *data,
                         uint32_t size,
                         char *outbuffer,
                         uint32_t outbuffer_size);
+/* Must return same hash for keys which comp_cb reports equal */
+typedef uint32_t (*notif_chain_key_hash_cb)(void *data,
+                                            uint32_t data_size);
+/* Maps key to a prefix of at most 32 bits, host bits beyond
+ * prefix_len must be zero. Returns false if key is not a prefix */
+typedef bool (*notif_chain_key_prefix_cb)(void *data,
+                                          uint32_t data_size,
+                                          uint32_t *prefix,
+                                          uint8_t *prefix_len);
 
 #define NOTIF_NAME_SIZE 	32
+
+/* Keys up to this size are stored inside notif_chain_elem_t */
+#ifndef NOTIF_CHAIN_INLINE_KEY_SIZE
+#define NOTIF_CHAIN_INLINE_KEY_SIZE	32
+#endif
 #define NOTIF_CHAIN_PROTO	240
 
 typedef enum notif_ch_type_{
@@ -126,12 +149,34 @@ notif_chain_get_str_notify_opcode(
     }
 }
 
+/* Priority class of a publish. Withdrawals matter more to
+ * forwarding than attribute updates, so by default a DELETE
+ * travels in the high lane and everything else in the low one */
+typedef enum notif_chain_prio_{
+
+    NOTIF_C_PRIO_DEFAULT,   /* Derived from notif_code */
+    NOTIF_C_PRIO_HIGH,
+    NOTIF_C_PRIO_LOW
+} notif_chain_prio_t;
+
+#define NOTIF_C_LANE_HIGH       0
+#define NOTIF_C_LANE_LOW        1
+#define NOTIF_C_N_LANES         2
+/* Queues serve the high lane first, but take one low lane
+ * entry after this many high ones in a row */
+#define NOTIF_C_PRIO_HIGH_BURST 16
+
 typedef struct notif_chain_comm_channel_{
     
     notif_ch_type_t notif_ch_type;
     union {
         /*Via Callbacks*/
-        notif_chain_app_cb app_cb;
+        struct {
+            notif_chain_app_cb app_cb;
+            /* If set, app_cb is run by the subscriber's own
+             * thread on draining the mailbox */
+            notif_mailbox_t *mailbox;
+        } cb;
         /*Via MsgQ*/
         struct {
             char msgQ_name[NOTIF_NAME_SIZE];
@@ -150,13 +195,23 @@ typedef struct notif_chain_comm_channel_{
         } inet_skt_info;
     }u;
 	uint32_t ref_count;			/* No of entries using this comm channel */
+	/* Owner client and hash of (client id, type, identity),
+	 * set once the channel is recorded in notif_chain_db_t */
+	uint32_t client_id;
+	uint32_t channel_hash;
+	/* Socket channels only, what the subscriber is yet to read */
+	notif_outq_t *outq;
+	/* NOTIF_C_CAP_* the subscriber's last request advertised */
+	uint32_t peer_caps;
 	glthread_t glue;
 } notif_chain_comm_channel_t;
 GLTHREAD_TO_STRUCT(glthread_glue_to_notif_chain_comm_channel,
 					notif_chain_comm_channel_t, glue);
 
 #define NOTIF_CHAIN_ELEM_APP_CB(notif_chain_comm_channel_ptr)           \
-    ((notif_chain_comm_channel_ptr)->u.app_cb)
+    ((notif_chain_comm_channel_ptr)->u.cb.app_cb)
+#define NOTIF_CHAIN_ELEM_MAILBOX(notif_chain_comm_channel_ptr)          \
+    ((notif_chain_comm_channel_ptr)->u.cb.mailbox)
 #define NOTIF_CHAIN_ELEM_MSGQ_NAME(notif_chain_comm_channel_ptr)        \
     ((notif_chain_comm_channel_ptr)->u.mq.msgQ_name)
 #define NOTIF_CHAIN_ELEM_SKT_NAME(notif_chain_comm_channel_ptr)         \
@@ -176,6 +231,8 @@ struct notif_chain_elem_{
    
     uint32_t client_id;
     notif_ch_notify_opcode_t notif_code;
+    /* Set by the publisher, else left NOTIF_C_PRIO_DEFAULT */
+    notif_chain_prio_t prio;
     
     struct {
         /* Key data to decide which 
@@ -183,6 +240,11 @@ struct notif_chain_elem_{
          * */
         void *app_key_data;
         uint32_t app_key_data_size;
+        /* app_key_data points here for small keys, set the key
+         * with notif_chain_elem_set_app_key_data(). uint64_t to
+         * keep the key aligned for comp_cb */
+        uint64_t app_key_data_inline[
+            (NOTIF_CHAIN_INLINE_KEY_SIZE + sizeof(uint64_t) - 1) / sizeof(uint64_t)];
 
         /* Once the subscriber is chosen, 
          * NCM must send notif to subscriber 
@@ -194,17 +256,78 @@ struct notif_chain_elem_{
 
     notif_chain_comm_channel_t 
         *notif_chain_comm_channel;
+
+    /* Matching index through which notif_chain_invoke()
+     * reaches this element, maintained by notif chain */
+    uint32_t subs_hash;
+    uint32_t key_hash;
+    struct notif_chain_key_bucket_ *key_bucket;
+    notif_chain_elem_t *index_next;
+    notif_chain_elem_t **index_pprev;
+    /* Links the element to notif_chain_client_subs_t->subs_head */
+    glthread_t client_glue;
 	glthread_t glue;
 };
 GLTHREAD_TO_STRUCT(glthread_glue_to_notif_chain_elem,
 					notif_chain_elem_t, glue);
+GLTHREAD_TO_STRUCT(glthread_client_glue_to_notif_chain_elem,
+					notif_chain_elem_t, client_glue);
+
+/* All subscribers of one exact key, reachable through
+ * notif_chain_t->key_index or notif_chain_t->prefix_trie */
+typedef struct notif_chain_key_bucket_{
+
+    void *app_key_data;
+    uint32_t app_key_data_size;
+    uint32_t key_hash;
+    /* Linked through notif_chain_elem_t->index_next */
+    notif_chain_elem_t *subs_head;
+} notif_chain_key_bucket_t;
+
+/* All subscriptions of one client on a chain, reachable
+ * through notif_chain_t->client_index */
+typedef struct notif_chain_client_subs_{
+
+    uint32_t client_id;
+    /* notif_chain_elem_t linked through client_glue */
+    glthread_t subs_head;
+} notif_chain_client_subs_t;
+
+/* Wildcard subscribers of a chain. Replaced as a whole through
+ * notif_chain_t->wildcard_subs except for appends, which fill
+ * elems[count] before count is bumped */
+typedef struct notif_chain_wildcard_subs_{
+
+    uint32_t count;
+    uint32_t size;
+    notif_chain_elem_t *elems[];
+} notif_chain_wildcard_subs_t;
 
 #define NOTIF_CHAIN_COMM_CH_TYPE(notif_chain_elem_ptr)                     \
     (notif_chain_elem_ptr->notif_chain_comm_channel->notif_ch_type)
 
+#define NOTIF_CHAIN_ELEM_KEY_IS_INLINE(notif_chain_elem_ptr)               \
+    ((notif_chain_elem_ptr)->data.app_key_data ==                          \
+     (void *)(notif_chain_elem_ptr)->data.app_key_data_inline)
+
+/* Subscribed with NULL key, notified of every publish */
+#define NOTIF_CHAIN_ELEM_IS_WILDCARD(notif_chain_elem_ptr)                 \
+    (!(notif_chain_elem_ptr)->data.app_key_data ||                         \
+     !(notif_chain_elem_ptr)->data.app_key_data_size)
+
+/* NOTIF_C_LANE_HIGH or NOTIF_C_LANE_LOW */
+#define NOTIF_CHAIN_ELEM_LANE(notif_chain_elem_ptr)                        \
+    (((notif_chain_elem_ptr)->prio == NOTIF_C_PRIO_HIGH ||                 \
+      ((notif_chain_elem_ptr)->prio == NOTIF_C_PRIO_DEFAULT &&             \
+       (notif_chain_elem_ptr)->notif_code == PUB_TO_SUBS_NOTIF_C_DELETE)) ? \
+        NOTIF_C_LANE_HIGH : NOTIF_C_LANE_LOW)
+
 struct notif_chain_{
 
     char name[NOTIF_NAME_SIZE];
+    /* Precomputed hash of name, used to index the
+     * chain in notif_chain_db_t */
+    uint32_t name_hash;
     /* Comparison fn to compare app_key_data 
      * present in notif_chain_elem_t objects
      * present in chain. This can be NULL if
@@ -213,15 +336,63 @@ struct notif_chain_{
     notif_chain_comp_cb comp_cb;
     app_key_data_print_cb print_cb;
 
+    /* Optional. If present, keyed subscribers are indexed
+     * by key hash so that notif_chain_invoke() only visits the
+     * subscribers of the published key. Without comp_cb, they
+     * are all visited still
+     * */
+    notif_chain_key_hash_cb key_hash_cb;
+    /* key hash -> notif_chain_key_bucket_t */
+    notif_hash_table_t key_index;
+    /* Optional, set by notif_chain_enable_prefix_match().
+     * If present, keyed subscribers are indexed in a binary
+     * prefix trie instead, and a publish reaches every
+     * subscriber whose prefix covers the published key
+     * */
+    notif_chain_key_prefix_cb key_prefix_cb;
+    /* prefix -> notif_chain_key_bucket_t */
+    notif_trie_t prefix_trie;
+    /* Keyed subscribers of chains which are not indexed,
+     * linked through notif_chain_elem_t->index_next */
+    notif_chain_elem_t *keyed_subs_head;
+    /* Wildcard subscribers, kept apart from keyed ones so that
+     * they are notified without any key comparison. NULL if none */
+    notif_chain_wildcard_subs_t *wildcard_subs;
+
+    /* client id -> notif_chain_client_subs_t, lets
+     * unsubscribe operations visit only the subscriptions
+     * of the client
+     * */
+    notif_hash_table_t client_index;
+    /* hash of (client id, key) -> notif_chain_elem_t, for
+     * duplicate detection on registration
+     * */
+    notif_hash_table_t subs_index;
+
     /* Head of the linked list containing
      * notif_chain_elem_t
      * */
     glthread_t notif_chain_elem_head;
+    /* Serializes subscription changes. notif_chain_invoke()
+     * does not take it, it walks the matching indexes under
+     * notif_rcu_read_lock() and removed elements are freed
+     * only once no publish can be looking at them
+     * */
+    pthread_mutex_t mutex;
+    /* Set by notif_chain_enable_conflation(), NULL otherwise */
+    notif_chain_conflation_t *conflation;
+    /* Set by notif_chain_enable_sharding(), NULL otherwise */
+    notif_chain_shards_t *shards;
+    /* Set by notif_chain_enable_post_queue(), NULL otherwise */
+    notif_chain_post_queue_t *post_queue;
 	glthread_t glue;
 };
 GLTHREAD_TO_STRUCT(glthread_glue_to_notif_chain,
 					notif_chain_t, glue);
 
+#define NOTIF_CHAIN_IS_INDEXED(notif_chain_ptr)         \
+    ((notif_chain_ptr)->key_hash_cb || (notif_chain_ptr)->key_prefix_cb)
+
 typedef struct comm_channel_per_client_db_{
 
 	uint32_t client_id;
@@ -234,7 +405,16 @@ GLTHREAD_TO_STRUCT(glthread_glue_to_comm_channel_per_client_db,
 typedef struct notif_chain_db_ {
 
 	glthread_t notif_chain_head;
+	/* name hash -> notif_chain_t, kept in sync with notif_chain_head */
+	notif_hash_table_t notif_chain_name_index;
 	glthread_t comm_channel_per_client_db_head;
+	/* client id hash -> comm_channel_per_client_db_t */
+	notif_hash_table_t comm_channel_per_client_db_index;
+	/* channel_hash -> notif_chain_comm_channel_t, shared
+	 * (ref counted) channels of all clients */
+	notif_hash_table_t comm_channel_index;
+	/* Protects all of the above, taken after notif_chain_t->mutex */
+	pthread_mutex_t mutex;
 } notif_chain_db_t;
 
 notif_chain_comm_channel_t *
@@ -270,11 +450,44 @@ void
 notif_chain_free_notif_chain_elem_internals(
                 notif_chain_elem_t *notif_chain_elem);
 
+/* Copies the key into the element, inline if it fits */
+void
+notif_chain_elem_set_app_key_data(
+                notif_chain_elem_t *notif_chain_elem,
+                void *app_key_data,
+                uint32_t app_key_data_size);
+
+void
+notif_chain_elem_free_app_key_data(
+                notif_chain_elem_t *notif_chain_elem);
+
+/* Deep copies what a publish carries : client id, notif code, key
+ * and data to notify, so that the copy outlives the publisher's
+ * buffers. Release with notif_chain_elem_free_publish() */
+void
+notif_chain_elem_copy_publish(
+                notif_chain_elem_t *dst_notif_chain_elem,
+                notif_chain_elem_t *src_notif_chain_elem);
+
+void
+notif_chain_elem_free_publish(
+                notif_chain_elem_t *notif_chain_elem);
+
 void
 notif_chain_init(notif_chain_t *notif_chain,
                  char *chain_name,
                  notif_chain_comp_cb comp_cb,
-                 app_key_data_print_cb print_cb);
+                 app_key_data_print_cb print_cb,
+                 notif_chain_key_hash_cb key_hash_cb);
+
+/* As notif_chain_init(), but the chain is not recorded in
+ * notif_chain_db_t, and can not be subscribed to by name */
+void
+notif_chain_init_internals(notif_chain_t *notif_chain,
+                 char *chain_name,
+                 notif_chain_comp_cb comp_cb,
+                 app_key_data_print_cb print_cb,
+                 notif_chain_key_hash_cb key_hash_cb);
 
 bool
 notif_chain_is_matching_notif_chain_element(
@@ -283,6 +496,9 @@ notif_chain_is_matching_notif_chain_element(
                 void *app_key_data,
                 uint32_t app_key_data_size);
 
+/* Safe against concurrent subscribes and unsubscribes. The element
+ * returned remains valid only within the caller's own read side
+ * critical section, or while no one unsubscribes it */
 notif_chain_elem_t *
 notif_chain_lookup_notif_chain_element(
 				notif_chain_t *notif_chain,
@@ -290,6 +506,13 @@ notif_chain_lookup_notif_chain_element(
 				void *app_key_data,
 				uint32_t app_key_data_size);
 
+/* Must be invoked before any subscriber registers with the chain */
+bool
+notif_chain_enable_prefix_match(notif_chain_t *notif_chain,
+                 notif_chain_key_prefix_cb key_prefix_cb);
+
+/* Unsubscribes everyone and takes the chain out of notif_chain_db, it
+ * can no longer be looked up by name and may be freed on return */
 void
 notif_chain_delete(notif_chain_t *notif_chain);
 
@@ -297,25 +520,114 @@ bool
 notif_chain_register_chain_element(notif_chain_t *notif_chain,
                 notif_chain_elem_t *notif_chain_elem);
 
+/* Registers an array of elements, sorting them once by
+ * client and channel. Returns the no of elements registered,
+ * registered[i], if registered is not NULL, tells whether
+ * notif_chain_elems[i] was. Those with an unknown channel type,
+ * a key which is not a prefix on prefix matching chains or
+ * already subscribed are not */
+uint32_t
+notif_chain_register_chain_elements(notif_chain_t *notif_chain,
+                notif_chain_elem_t *notif_chain_elems,
+                uint32_t n_elems,
+                bool *registered /* o/p, may be NULL */);
+
 bool
 notif_chain_deregister_chain_element(notif_chain_t *notif_chain,
                 notif_chain_elem_t *notif_chain_elem);
 
+/* Returns the no of subscriptions removed */
+uint32_t
+notif_chain_deregister_client(notif_chain_t *notif_chain,
+                uint32_t client_id);
+
 void
 notif_chain_invoke(notif_chain_t *notif_chain,
                 notif_chain_elem_t *notif_chain_elem);
 
+/* Socket subscribers get the notifications of the publishes made
+ * by this thread between begin and end framed together, in as few
+ * writes as the frame limits allow. Batches nest. Subscriptions may
+ * change inside a batch, chains must not be deleted */
+void
+notif_chain_batch_begin(void);
+
+void
+notif_chain_batch_end(void);
+
+/* Calls record_cb on every notification of a message received by a
+ * socket subscriber, framed or not. Returns the no of notifications */
+typedef void (*notif_chain_record_cb)(char *tlv_buffer,
+                uint32_t tlv_buff_size,
+                void *arg);
+
+uint32_t
+notif_chain_for_each_notification(char *msg,
+                uint32_t msg_size,
+                notif_chain_record_cb record_cb,
+                void *arg);
+
+/* notif_chain_record_cb printing the chain name and notif code of
+ * the notification, arg is unused */
+void
+notif_chain_print_notification(char *tlv_buffer,
+                uint32_t tlv_buff_size,
+                void *arg);
+
+/* As notif_chain_invoke(), but delivers only to the subscribers
+ * whose channel_hash % n_partitions is partition */
+void
+notif_chain_invoke_partition(notif_chain_t *notif_chain,
+                notif_chain_elem_t *notif_chain_elem,
+                uint32_t partition,
+                uint32_t n_partitions);
+
+/* The subscribers notif_chain_invoke() would deliver notif_chain_elem
+ * to, in *matched, to be freed by the caller. Must be called within
+ * a read side critical section, the subscribers are valid only as
+ * long as it lasts */
+uint32_t
+notif_chain_match_subscribers(notif_chain_t *notif_chain,
+                notif_chain_elem_t *notif_chain_elem,
+                notif_chain_elem_t ***matched);
+
+/* Delivers notif_chain_elem to subscribers gathered by
+ * notif_chain_match_subscribers() */
+void
+notif_chain_deliver_to_subscribers(notif_chain_t *notif_chain,
+                notif_chain_elem_t *notif_chain_elem,
+                notif_chain_elem_t **matched,
+                uint32_t n_matched);
+
 void
 notif_chain_dump(notif_chain_t *notif_chain);
 
+/* Sets the queuing policy of the socket channels of the client.
+ * Returns the no of channels updated */
+uint32_t
+notif_chain_set_client_outq_policy(uint32_t client_id,
+                      notif_outq_policy_t policy,
+                      uint32_t max_depth);
+
 bool
 notif_chain_subscribe(char *notif_name, 
                       notif_chain_elem_t *notif_chain_elem);
 
+/* See notif_chain_register_chain_elements() */
+uint32_t
+notif_chain_subscribe_bulk(char *notif_name,
+                      notif_chain_elem_t *notif_chain_elems,
+                      uint32_t n_elems,
+                      bool *subscribed /* o/p, may be NULL */);
+
 bool
 notif_chain_unsubscribe(char *notif_name, 
                       notif_chain_elem_t *notif_chain_elem);
 
+bool
+notif_chain_unsubscribe_all(char *notif_name,
+                      uint32_t client_id);
+
 void
 notif_chain_process_remote_subscriber_request(
         char *subs_tlv_buffer,
@@ -332,6 +644,16 @@ notif_chain_subscribe_by_callback(
         uint32_t client_id,
         notif_chain_app_cb cb);
 
+/* As notif_chain_subscribe_by_callback(), but notifications are
+ * queued to the mailbox, whose app_cb the subscriber thread runs */
+bool
+notif_chain_subscribe_by_mailbox(
+        char *notif_chain_name,
+        void *key,
+        uint32_t key_size,
+        uint32_t client_id,
+        notif_mailbox_t *mailbox);
+
 /* Returns the skt file Des using which the msg was sent */
 int
 notif_chain_subscribe_by_inet_skt(
@@ -382,6 +704,23 @@ notif_chain_send_msg_to_subscriber(char *subscriber_addr,
 								   int sock_fd,
 								   int protocol_no);
 
+/* As the above, the message gathered from iov_count pieces and sent
+ * with a single sendmsg(), none of them is copied */
+int
+notif_chain_send_msgv_to_publisher(char *publisher_addr,
+                                   uint32_t publisher_port_no,
+                                   struct iovec *iov,
+                                   int iov_count,
+								   int sock_fd,
+								   uint32_t protocol_no);
+int
+notif_chain_send_msgv_to_subscriber(char *subscriber_addr,
+								   uint32_t subscriber_port_no,
+								   struct iovec *iov,
+								   int iov_count,
+								   int sock_fd,
+								   int protocol_no);
+
 /* TLV Management */
 #define NOTIF_C_NOTIF_CHAIN_NAME_TLV    (1)  /* Value len : NOTIF_NAME_SIZE */
 #define NOTIF_C_CLIENT_ID_TLV           (2)  /* Value len : 4 */
@@ -393,7 +732,21 @@ notif_chain_send_msg_to_subscriber(char *subscriber_addr,
 #define NOTIF_C_PROTOCOL_NO_TLV         (8)  /* Value len : 1 */
 #define NOTIF_C_APP_KEY_DATA_TLV        (9)  /* Variable Size */
 #define NOTIF_C_APP_DATA_TO_NOTIFY_TLV  (10) /* Variable Size */
-#define NOTIF_C_MAX_TLV                 (11)
+/* A frame of several notifications, NOTIF_C_FRAME_TLV first, then
+ * one NOTIF_C_FRAME_RECORD_TLV per notification */
+#define NOTIF_C_FRAME_TLV               (11) /* Value len : 4, record count */
+#define NOTIF_C_FRAME_RECORD_TLV        (12) /* Variable Size, a notification */
+/* Sent by subscribers with their requests, what they can decode.
+ * Peers which do not know it skip it */
+#define NOTIF_C_CAPABILITIES_TLV        (13) /* Value len : 4, NOTIF_C_CAP_* */
+#define NOTIF_C_MAX_TLV                 (14)
+
+/* Takes TLVs in wide form, see TLV_WIDE_FLAG. A subscriber which did
+ * not advertise it is never sent a notification whose key or data is
+ * too long for the short form, nor a frame of such records */
+#define NOTIF_C_CAP_WIDE_TLV            (1 << 0)
+/* What this library advertises */
+#define NOTIF_C_LOCAL_CAPS              (NOTIF_C_CAP_WIDE_TLV)
 
 #define NOTIF_C_NOTIF_CHAIN_NAME_VALUE_LEN  (FIELD_SIZE(notif_chain_t, name))
 #define NOTIF_C_CLIENT_ID_VALUE_LEN         (FIELD_SIZE(notif_chain_elem_t, client_id))
@@ -406,6 +759,7 @@ notif_chain_send_msg_to_subscriber(char *subscriber_addr,
 #define NOTIF_C_PORT_NO_VALUE_LEN           (FIELD_SIZE(notif_chain_comm_channel_t, u.inet_skt_info.port_no))
 #define NOTIF_C_NOTIF_CODE_VALUE_LEN        (FIELD_SIZE(notif_chain_elem_t, notif_code)) 
 #define NOTIF_C_PROTOCOL_NO_VALUE_LEN       (FIELD_SIZE(notif_chain_comm_channel_t, u.inet_skt_info.protocol_no))
+#define NOTIF_C_CAPABILITIES_VALUE_LEN      (FIELD_SIZE(notif_chain_comm_channel_t, peer_caps))
 
 uint32_t
 notif_chain_compute_required_tlv_buffer_size_for_notif_chain_elem_encoding(
@@ -418,10 +772,31 @@ notif_chain_serialize_notif_chain_elem(char *notif_chain_name,
                                     uint32_t output_buffer_provided_size,
                                     char **output_buffer_computed);
 
+/* Decodes into caller provided storage, nothing is allocated. The
+ * key, unless small enough to be inline, and the data to notify point
+ * into tlv_buffer : the element is only valid as long as tlv_buffer,
+ * and must not be passed to notif_chain_elem_free_publish().
+ * notif_chain_name is NOTIF_C_NOTIF_CHAIN_NAME_VALUE_LEN bytes.
+ * Returns false, leaving the outputs partly filled, if a TLV does not
+ * fit its field */
+bool
+notif_chain_deserialize_notif_chain_elem_view(
+                char *tlv_buffer,
+                uint32_t tlv_buff_size,
+                char *notif_chain_name, /*o/p*/
+                notif_chain_elem_t *notif_chain_elem, /*o/p*/
+                notif_chain_comm_channel_t *notif_chain_comm_channel /*o/p*/);
+
+/* Release the result with notif_chain_free_deserialized_notif_chain_elem().
+ * NULL if tlv_buffer is malformed */
 notif_chain_elem_t *
 notif_chain_deserialize_notif_chain_elem(
                 char *tlv_buffer,
                 uint32_t tlv_buff_size,
                 char *notif_chain_name /*o/p*/);
 
+void
+notif_chain_free_deserialized_notif_chain_elem(
+                notif_chain_elem_t *notif_chain_elem);
+
 #endif /* __NOTIF_H__ */
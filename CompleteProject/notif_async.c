@@ -0,0 +1,666 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  notif_async.c
+ *
+ *    Description:  This file implements the worker pool delivering Notification Chains
+ *                  publishes asynchronously
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026 09:26:02 PM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Er. Abhishek Sagar, Juniper Networks (https://csepracticals.wixsite.com/csepracticals), sachinites@gmail.com
+ *        Company:  Juniper Networks
+ *
+ *        This file is part of the NotificationChains distribution (https://github.com/sachinites)
+ *        Copynext (c) 2019 Abhishek Sagar.
+ *        This program is free software: you can redistribute it and/or modify it under the terms of the GNU General
+ *        Public License as published by the Free Software Foundation, version 3.
+ *
+ *        This program is distributed in the hope that it will be useful, but
+ *        WITHOUT ANY WARRANTY; without even the implied warranty of
+ *        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *        General Public License for more details.
+ *
+ *        visit website : https://csepracticals.wixsite.com/csepracticals for more courses and projects
+ *
+ * =====================================================================================
+ */
+
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <stdio.h>
+#include <memory.h>
+#include <assert.h>
+#include <pthread.h>
+#include <sched.h>
+#include "notif.h"
+#include "notif_rcu.h"
+#include "notif_slab.h"
+#include "notif_async.h"
+#include "notif_conflate.h"
+#include "notif_shard.h"
+
+/* Private copy of a publish, shared by all workers. The last
+ * worker done with it frees it */
+typedef struct notif_async_publish_{
+
+	notif_chain_t *notif_chain;
+	bool has_notif_chain_elem;
+	notif_chain_elem_t notif_chain_elem;
+	/* Subscribers gathered by the dispatcher, grouped by worker,
+	 * each job delivers to its worker's slice */
+	notif_chain_elem_t **matched;
+	/* NOTIF_C_LANE_HIGH or NOTIF_C_LANE_LOW */
+	uint32_t lane;
+	/* Hash of the published key, if has_key */
+	bool has_key;
+	uint32_t key_hash;
+	uint32_t ref_count;
+} notif_async_publish_t;
+
+typedef struct notif_async_job_{
+
+	notif_async_publish_t *publish;
+	/* Slice of publish->matched, if any */
+	uint32_t begin;
+	uint32_t end;
+	struct notif_async_job_ *next;
+} notif_async_job_t;
+
+/* FIFO of jobs */
+typedef struct notif_async_lane_{
+
+	notif_async_job_t *head;
+	notif_async_job_t *tail;
+} notif_async_lane_t;
+
+typedef struct notif_async_worker_{
+
+	pthread_t thread;
+	notif_async_pool_t *pool;
+	/* Passed to pool->deliver_cb. Workers of notif_async_start()
+	 * deliver to the channels with channel_hash % n_workers == index */
+	uint32_t index;
+	bool stop;
+	notif_async_lane_t lanes[NOTIF_C_N_LANES];
+	/* High lane jobs taken since the last low lane one */
+	uint32_t n_high_in_row;
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+} notif_async_worker_t;
+
+struct notif_async_pool_{
+
+	notif_async_worker_t *workers;
+	uint32_t n_workers;
+	notif_async_deliver_cb deliver_cb;
+	bool pin_workers;
+	/* Pool of notif_async_start() only. Looks up the subscribers of
+	 * the publishes queued to it and splits them among the workers */
+	notif_async_worker_t *dispatcher;
+	/* Slices the workers have yet to deliver of the publishes the
+	 * dispatcher is done with */
+	uint32_t n_slices_pending;
+	pthread_mutex_t slices_mutex;
+	pthread_cond_t slices_cond;
+};
+
+/* Protects notif_async_pool, the pool of notif_async_start() */
+static pthread_rwlock_t notif_async_rwlock = PTHREAD_RWLOCK_INITIALIZER;
+static notif_async_pool_t *notif_async_pool;
+
+/* Worker of notif_async_start() serving the subscriber's channel */
+#define NOTIF_ASYNC_MATCHED_WORKER(pool, notif_chain_elem)	\
+	((notif_chain_elem)->notif_chain_comm_channel->channel_hash % \
+		(pool)->n_workers)
+
+static notif_slab_t notif_async_publish_slab =
+	NOTIF_SLAB_INITIALIZER("notif_async_publish_t",
+		sizeof(notif_async_publish_t));
+static notif_slab_t notif_async_job_slab =
+	NOTIF_SLAB_INITIALIZER("notif_async_job_t",
+		sizeof(notif_async_job_t));
+
+static notif_async_publish_t *
+notif_async_publish_create(notif_chain_t *notif_chain,
+		notif_chain_elem_t *notif_chain_elem){
+
+	notif_async_publish_t *publish;
+
+	publish = notif_slab_alloc(&notif_async_publish_slab);
+	publish->notif_chain = notif_chain;
+	publish->lane = NOTIF_C_LANE_LOW;
+
+	if(!notif_chain_elem) return publish;
+
+	publish->has_notif_chain_elem = true;
+
+	/* Caller's buffers are gone by the time workers run */
+	notif_chain_elem_copy_publish(&publish->notif_chain_elem,
+			notif_chain_elem);
+
+	publish->lane = NOTIF_CHAIN_ELEM_LANE(notif_chain_elem);
+
+	if(!NOTIF_CHAIN_ELEM_IS_WILDCARD(notif_chain_elem)){
+		publish->has_key = true;
+		publish->key_hash = notif_hash_bytes(
+				notif_chain_elem->data.app_key_data,
+				notif_chain_elem->data.app_key_data_size,
+				NOTIF_HASH_SEED);
+	}
+	return publish;
+}
+
+static void
+notif_async_publish_release(notif_async_publish_t *publish){
+
+	if(__atomic_sub_fetch(&publish->ref_count, 1, __ATOMIC_ACQ_REL)) return;
+
+	free(publish->matched);
+	notif_chain_elem_free_publish(&publish->notif_chain_elem);
+	notif_slab_free(&notif_async_publish_slab, publish);
+}
+
+static void
+notif_async_lane_append(notif_async_lane_t *lane, notif_async_job_t *job){
+
+	job->next = NULL;
+	if(lane->tail){
+		lane->tail->next = job;
+	}
+	else {
+		lane->head = job;
+	}
+	lane->tail = job;
+}
+
+static notif_async_job_t *
+notif_async_lane_pop(notif_async_lane_t *lane){
+
+	notif_async_job_t *job = lane->head;
+
+	lane->head = job->next;
+	if(!lane->head) lane->tail = NULL;
+	return job;
+}
+
+/* A high lane publish must not overtake what was published before
+ * for the same key, say a DELETE the CREATE it withdraws. Such low
+ * lane jobs move ahead of it, in order. Hash collisions only move
+ * a job earlier than needed */
+static void
+notif_async_worker_promote(notif_async_worker_t *worker, uint32_t key_hash){
+
+	notif_async_job_t *job, **job_slot;
+	notif_async_lane_t *low_lane = &worker->lanes[NOTIF_C_LANE_LOW];
+
+	low_lane->tail = NULL;
+
+	for(job_slot = &low_lane->head; (job = *job_slot); ){
+
+		if(!job->publish->has_key || job->publish->key_hash != key_hash){
+			low_lane->tail = job;
+			job_slot = &job->next;
+			continue;
+		}
+		*job_slot = job->next;
+		notif_async_lane_append(&worker->lanes[NOTIF_C_LANE_HIGH], job);
+	}
+}
+
+static void
+notif_async_worker_enqueue(notif_async_worker_t *worker,
+		notif_async_publish_t *publish,
+		uint32_t begin,
+		uint32_t end){
+
+	notif_async_job_t *job = notif_slab_alloc(&notif_async_job_slab);
+
+	job->publish = publish;
+	job->begin = begin;
+	job->end = end;
+
+	pthread_mutex_lock(&worker->mutex);
+
+	if(publish->lane == NOTIF_C_LANE_HIGH && publish->has_key){
+		notif_async_worker_promote(worker, publish->key_hash);
+	}
+	notif_async_lane_append(&worker->lanes[publish->lane], job);
+
+	pthread_cond_signal(&worker->cond);
+	pthread_mutex_unlock(&worker->mutex);
+}
+
+/* High lane first, but no more than NOTIF_C_PRIO_HIGH_BURST jobs
+ * in a row while the low lane waits. Called with worker->mutex held */
+static notif_async_job_t *
+notif_async_worker_dequeue(notif_async_worker_t *worker){
+
+	notif_async_lane_t *high_lane = &worker->lanes[NOTIF_C_LANE_HIGH];
+	notif_async_lane_t *low_lane = &worker->lanes[NOTIF_C_LANE_LOW];
+
+	if(high_lane->head &&
+		(!low_lane->head || worker->n_high_in_row < NOTIF_C_PRIO_HIGH_BURST)){
+
+		worker->n_high_in_row++;
+		return notif_async_lane_pop(high_lane);
+	}
+
+	worker->n_high_in_row = 0;
+	if(!low_lane->head) return NULL;
+	return notif_async_lane_pop(low_lane);
+}
+
+/* Worker i runs on core i, modulo the no of cores, so that the
+ * queue and the subscriptions it delivers to stay in its caches */
+static void
+notif_async_worker_pin(notif_async_worker_t *worker){
+
+	int rc;
+	long n_cpus;
+	cpu_set_t cpu_set;
+
+	n_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	if(n_cpus <= 0) return;
+
+	CPU_ZERO(&cpu_set);
+	CPU_SET(worker->index % n_cpus, &cpu_set);
+
+	rc = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+	if(rc){
+		printf("%s() : Error : Could not pin worker %u, error = %d\n",
+				__FUNCTION__, worker->index, rc);
+	}
+}
+
+/* Wakes the dispatcher once the last slice it queued is delivered */
+static void
+notif_async_slice_done(notif_async_pool_t *pool){
+
+	pthread_mutex_lock(&pool->slices_mutex);
+	if(!--pool->n_slices_pending){
+		pthread_cond_signal(&pool->slices_cond);
+	}
+	pthread_mutex_unlock(&pool->slices_mutex);
+}
+
+static void *
+notif_async_worker_fn(void *arg){
+
+	bool is_idle;
+	uint32_t begin, end, n_batched = 0;
+	notif_async_job_t *job;
+	notif_async_publish_t *publish;
+	notif_async_worker_t *worker = (notif_async_worker_t *)arg;
+	notif_async_pool_t *pool = worker->pool;
+
+	if(pool->pin_workers) notif_async_worker_pin(worker);
+
+	while(1){
+
+		pthread_mutex_lock(&worker->mutex);
+
+		while(!worker->lanes[NOTIF_C_LANE_HIGH].head &&
+				!worker->lanes[NOTIF_C_LANE_LOW].head && !worker->stop){
+			pthread_cond_wait(&worker->cond, &worker->mutex);
+		}
+
+		/* Stop only once the queue is drained */
+		job = notif_async_worker_dequeue(worker);
+		if(!job){
+			pthread_mutex_unlock(&worker->mutex);
+			break;
+		}
+
+		pthread_mutex_unlock(&worker->mutex);
+
+		/* Socket subscribers get the jobs' notifications framed
+		 * together, as for the publisher's own batches */
+		if(!n_batched++) notif_chain_batch_begin();
+
+		publish = job->publish;
+		begin = job->begin;
+		end = job->end;
+		notif_slab_free(&notif_async_job_slab, job);
+
+		if(publish->matched){
+			notif_chain_deliver_to_subscribers(publish->notif_chain,
+					publish->has_notif_chain_elem ?
+						&publish->notif_chain_elem : NULL,
+					&publish->matched[begin], end - begin);
+			notif_async_publish_release(publish);
+			notif_async_slice_done(pool);
+		}
+		else {
+			pool->deliver_cb(publish->notif_chain,
+					publish->has_notif_chain_elem ?
+						&publish->notif_chain_elem : NULL,
+					worker->index, pool->n_workers);
+			notif_async_publish_release(publish);
+		}
+
+		pthread_mutex_lock(&worker->mutex);
+		is_idle = !worker->lanes[NOTIF_C_LANE_HIGH].head &&
+			!worker->lanes[NOTIF_C_LANE_LOW].head;
+		pthread_mutex_unlock(&worker->mutex);
+
+		/* Nothing is held back while waiting for more jobs */
+		if(is_idle || n_batched == NOTIF_ASYNC_BATCH_MAX_JOBS){
+			notif_chain_batch_end();
+			n_batched = 0;
+		}
+	}
+	return NULL;
+}
+
+/* Lets the thread drain its queue, then joins it */
+static void
+notif_async_worker_stop(notif_async_worker_t *worker){
+
+	pthread_mutex_lock(&worker->mutex);
+	worker->stop = true;
+	pthread_cond_signal(&worker->cond);
+	pthread_mutex_unlock(&worker->mutex);
+
+	pthread_join(worker->thread, NULL);
+	pthread_mutex_destroy(&worker->mutex);
+	pthread_cond_destroy(&worker->cond);
+}
+
+notif_async_pool_t *
+notif_async_pool_create(uint32_t n_workers,
+		notif_async_deliver_cb deliver_cb,
+		bool pin_workers){
+
+	uint32_t i;
+	notif_async_pool_t *pool;
+	notif_async_worker_t *worker;
+
+	if(!n_workers || n_workers > NOTIF_ASYNC_MAX_WORKERS){
+		printf("%s() : Error : Invalid no of workers %u\n",
+				__FUNCTION__, n_workers);
+		return NULL;
+	}
+
+	pool = calloc(1, sizeof(notif_async_pool_t));
+	pool->workers = calloc(n_workers, sizeof(notif_async_worker_t));
+	pool->n_workers = n_workers;
+	pool->deliver_cb = deliver_cb;
+	pool->pin_workers = pin_workers;
+	pthread_mutex_init(&pool->slices_mutex, NULL);
+	pthread_cond_init(&pool->slices_cond, NULL);
+
+	for(i = 0; i < n_workers; i++){
+
+		worker = &pool->workers[i];
+		worker->pool = pool;
+		worker->index = i;
+		pthread_mutex_init(&worker->mutex, NULL);
+		pthread_cond_init(&worker->cond, NULL);
+		pthread_create(&worker->thread, NULL,
+				notif_async_worker_fn, (void *)worker);
+	}
+	return pool;
+}
+
+void
+notif_async_pool_destroy(notif_async_pool_t *pool){
+
+	uint32_t i;
+	notif_async_worker_t *worker;
+
+	/* The dispatcher drains first, its last publishes still need
+	 * the workers */
+	if(pool->dispatcher){
+		notif_async_worker_stop(pool->dispatcher);
+		free(pool->dispatcher);
+	}
+
+	for(i = 0; i < pool->n_workers; i++){
+
+		worker = &pool->workers[i];
+		pthread_mutex_lock(&worker->mutex);
+		worker->stop = true;
+		pthread_cond_signal(&worker->cond);
+		pthread_mutex_unlock(&worker->mutex);
+	}
+
+	for(i = 0; i < pool->n_workers; i++){
+
+		worker = &pool->workers[i];
+		pthread_join(worker->thread, NULL);
+		pthread_mutex_destroy(&worker->mutex);
+		pthread_cond_destroy(&worker->cond);
+	}
+	pthread_mutex_destroy(&pool->slices_mutex);
+	pthread_cond_destroy(&pool->slices_cond);
+	free(pool->workers);
+	free(pool);
+}
+
+void
+notif_async_pool_enqueue(notif_async_pool_t *pool,
+		notif_chain_t *notif_chain,
+		notif_chain_elem_t *notif_chain_elem,
+		uint32_t worker_index){
+
+	uint32_t i;
+	notif_async_publish_t *publish;
+
+	publish = notif_async_publish_create(notif_chain, notif_chain_elem);
+
+	if(worker_index != NOTIF_ASYNC_ALL_WORKERS){
+		assert(worker_index < pool->n_workers);
+		publish->ref_count = 1;
+		notif_async_worker_enqueue(&pool->workers[worker_index], publish,
+				0, 0);
+		return;
+	}
+
+	publish->ref_count = pool->n_workers;
+
+	for(i = 0; i < pool->n_workers; i++){
+		notif_async_worker_enqueue(&pool->workers[i], publish, 0, 0);
+	}
+}
+
+/* Groups the subscribers of the publish by the worker of their
+ * channel, keeping their order, and queues every worker its own
+ * group only. Called on the dispatcher, within its read side
+ * section */
+static void
+notif_async_dispatcher_split(notif_async_pool_t *pool,
+		notif_async_publish_t *publish){
+
+	uint32_t i, n_matched, n_slices = 0;
+	uint32_t slice_end[NOTIF_ASYNC_MAX_WORKERS];
+	uint32_t slice_begin[NOTIF_ASYNC_MAX_WORKERS + 1];
+	notif_chain_elem_t **matched, **grouped;
+
+	n_matched = notif_chain_match_subscribers(publish->notif_chain,
+			publish->has_notif_chain_elem ?
+				&publish->notif_chain_elem : NULL,
+			&matched);
+
+	if(!n_matched) return;
+
+	memset(slice_begin, 0, sizeof(slice_begin));
+
+	for(i = 0; i < n_matched; i++){
+		slice_begin[NOTIF_ASYNC_MATCHED_WORKER(pool, matched[i]) + 1]++;
+	}
+
+	for(i = 0; i < pool->n_workers; i++){
+		if(slice_begin[i + 1]) n_slices++;
+		slice_begin[i + 1] += slice_begin[i];
+		slice_end[i] = slice_begin[i];
+	}
+
+	grouped = malloc(n_matched * sizeof(notif_chain_elem_t *));
+
+	for(i = 0; i < n_matched; i++){
+		grouped[slice_end[NOTIF_ASYNC_MATCHED_WORKER(pool, matched[i])]++] =
+			matched[i];
+	}
+	free(matched);
+
+	publish->matched = grouped;
+	/* The dispatcher keeps its own reference till all are delivered */
+	publish->ref_count += n_slices;
+
+	pthread_mutex_lock(&pool->slices_mutex);
+	pool->n_slices_pending += n_slices;
+	pthread_mutex_unlock(&pool->slices_mutex);
+
+	for(i = 0; i < pool->n_workers; i++){
+		if(slice_end[i] == slice_begin[i]) continue;
+		notif_async_worker_enqueue(&pool->workers[i], publish,
+				slice_begin[i], slice_end[i]);
+	}
+}
+
+/* Takes up to NOTIF_ASYNC_BATCH_MAX_JOBS publishes at a time, in
+ * the order of its lanes, and hands them to the workers. The
+ * subscribers so found are valid as long as the read side section
+ * they were looked up in, which therefore lasts till the workers
+ * delivered to them. Publishers never wait on any of this */
+static void *
+notif_async_dispatcher_fn(void *arg){
+
+	uint32_t i, n_publishes;
+	notif_async_job_t *job;
+	notif_async_job_t *jobs[NOTIF_ASYNC_BATCH_MAX_JOBS];
+	notif_async_worker_t *dispatcher = (notif_async_worker_t *)arg;
+	notif_async_pool_t *pool = dispatcher->pool;
+
+	while(1){
+
+		pthread_mutex_lock(&dispatcher->mutex);
+
+		while(!dispatcher->lanes[NOTIF_C_LANE_HIGH].head &&
+				!dispatcher->lanes[NOTIF_C_LANE_LOW].head &&
+				!dispatcher->stop){
+			pthread_cond_wait(&dispatcher->cond, &dispatcher->mutex);
+		}
+
+		for(n_publishes = 0; n_publishes < NOTIF_ASYNC_BATCH_MAX_JOBS &&
+				(job = notif_async_worker_dequeue(dispatcher)); n_publishes++){
+			jobs[n_publishes] = job;
+		}
+
+		pthread_mutex_unlock(&dispatcher->mutex);
+
+		/* Stop only once the queue is drained */
+		if(!n_publishes) break;
+
+		notif_rcu_read_lock();
+
+		for(i = 0; i < n_publishes; i++){
+			notif_async_dispatcher_split(pool, jobs[i]->publish);
+		}
+
+		pthread_mutex_lock(&pool->slices_mutex);
+		while(pool->n_slices_pending){
+			pthread_cond_wait(&pool->slices_cond, &pool->slices_mutex);
+		}
+		pthread_mutex_unlock(&pool->slices_mutex);
+
+		notif_rcu_read_unlock();
+
+		for(i = 0; i < n_publishes; i++){
+			notif_async_publish_release(jobs[i]->publish);
+			notif_slab_free(&notif_async_job_slab, jobs[i]);
+		}
+	}
+	return NULL;
+}
+
+bool
+notif_async_start(uint32_t n_workers){
+
+	notif_async_pool_t *pool;
+	notif_async_worker_t *dispatcher;
+
+	pthread_rwlock_wrlock(&notif_async_rwlock);
+
+	if(notif_async_pool){
+		pthread_rwlock_unlock(&notif_async_rwlock);
+		printf("%s() : Error : Workers already running\n", __FUNCTION__);
+		return false;
+	}
+
+	pool = notif_async_pool_create(n_workers,
+				notif_chain_invoke_partition, false);
+
+	if(pool){
+		dispatcher = calloc(1, sizeof(notif_async_worker_t));
+		dispatcher->pool = pool;
+		pthread_mutex_init(&dispatcher->mutex, NULL);
+		pthread_cond_init(&dispatcher->cond, NULL);
+		pthread_create(&dispatcher->thread, NULL,
+				notif_async_dispatcher_fn, (void *)dispatcher);
+		pool->dispatcher = dispatcher;
+	}
+	notif_async_pool = pool;
+
+	pthread_rwlock_unlock(&notif_async_rwlock);
+	return pool != NULL;
+}
+
+void
+notif_async_stop(void){
+
+	notif_async_pool_t *pool;
+
+	/* Detach the pool first, publishes made meanwhile (including
+	 * from the subscriber callbacks being drained) go synchronous */
+	pthread_rwlock_wrlock(&notif_async_rwlock);
+	pool = notif_async_pool;
+	notif_async_pool = NULL;
+	pthread_rwlock_unlock(&notif_async_rwlock);
+
+	if(!pool) return;
+
+	notif_async_pool_destroy(pool);
+}
+
+void
+notif_async_dispatch(notif_chain_t *notif_chain,
+		notif_chain_elem_t *notif_chain_elem){
+
+	notif_async_publish_t *publish;
+
+	/* Sharded chains have dispatchers of their own */
+	if(notif_chain->shards){
+		notif_shard_dispatch(notif_chain, notif_chain_elem);
+		return;
+	}
+
+	pthread_rwlock_rdlock(&notif_async_rwlock);
+
+	if(!notif_async_pool){
+		pthread_rwlock_unlock(&notif_async_rwlock);
+		notif_chain_invoke_partition(notif_chain, notif_chain_elem, 0, 1);
+		return;
+	}
+
+	/* The subscribers are looked up by the dispatcher, the
+	 * publisher only queues its copy */
+	publish = notif_async_publish_create(notif_chain, notif_chain_elem);
+	publish->ref_count = 1;
+	notif_async_worker_enqueue(notif_async_pool->dispatcher, publish, 0, 0);
+
+	pthread_rwlock_unlock(&notif_async_rwlock);
+}
+
+void
+notif_chain_invoke_async(notif_chain_t *notif_chain,
+		notif_chain_elem_t *notif_chain_elem){
+
+	if(notif_conflate_publish(notif_chain, notif_chain_elem)) return;
+
+	notif_async_dispatch(notif_chain, notif_chain_elem);
+}
@@ -0,0 +1,103 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  notif_async.h
+ *
+ *    Description:  This file defines the worker pool which lets Notification Chains
+ *                  publishers hand over the delivery of a publish
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026 09:14:37 PM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Er. Abhishek Sagar, Juniper Networks (https://csepracticals.wixsite.com/csepracticals), sachinites@gmail.com
+ *        Company:  Juniper Networks
+ *
+ *        This file is part of the NotificationChains distribution (https://github.com/sachinites)
+ *        Copynext (c) 2019 Abhishek Sagar.
+ *        This program is free software: you can redistribute it and/or modify it under the terms of the GNU General
+ *        Public License as published by the Free Software Foundation, version 3.
+ *
+ *        This program is distributed in the hope that it will be useful, but
+ *        WITHOUT ANY WARRANTY; without even the implied warranty of
+ *        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *        General Public License for more details.
+ *
+ *        visit website : https://csepracticals.wixsite.com/csepracticals for more courses and projects
+ *
+ * =====================================================================================
+ */
+
+#ifndef __NOTIF_ASYNC_H__
+#define __NOTIF_ASYNC_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "notif.h"
+
+#define NOTIF_ASYNC_DEFAULT_WORKERS	4
+#define NOTIF_ASYNC_MAX_WORKERS		64
+
+/* A worker delivers the jobs it finds queued within one outq batch,
+ * see notif_chain_batch_begin(), of at most this many jobs */
+#define NOTIF_ASYNC_BATCH_MAX_JOBS	32
+
+/* notif_async_pool_enqueue() worker_index queuing to every worker */
+#define NOTIF_ASYNC_ALL_WORKERS		UINT32_MAX
+
+typedef struct notif_async_pool_ notif_async_pool_t;
+
+/* Delivers a queued publish, called on worker worker_index. Its
+ * signature is that of notif_chain_invoke_partition() */
+typedef void (*notif_async_deliver_cb)(notif_chain_t *notif_chain,
+                notif_chain_elem_t *notif_chain_elem,
+                uint32_t worker_index,
+                uint32_t n_workers);
+
+/* Pool of n_workers delivery threads, each with its own queue.
+ * If pin_workers, worker i is bound to core i % no of cores */
+notif_async_pool_t *
+notif_async_pool_create(uint32_t n_workers,
+                notif_async_deliver_cb deliver_cb,
+                bool pin_workers);
+
+/* Delivers whatever is queued already, then stops and frees the pool */
+void
+notif_async_pool_destroy(notif_async_pool_t *pool);
+
+/* Copies the publish and queues it to worker worker_index, or to
+ * every worker if NOTIF_ASYNC_ALL_WORKERS. Same as for
+ * notif_chain_invoke_async(), a high priority publish overtakes
+ * the queued low priority ones, except those of its own key */
+void
+notif_async_pool_enqueue(notif_async_pool_t *pool,
+                notif_chain_t *notif_chain,
+                notif_chain_elem_t *notif_chain_elem,
+                uint32_t worker_index);
+
+/* Starts n_workers delivery threads and a dispatcher which looks up
+ * the subscribers of the queued publishes. Every subscriber is served
+ * by one fixed worker, chosen by the hash of its communication
+ * channel, so a subscriber sees publishes in the order made */
+bool
+notif_async_start(uint32_t n_workers);
+
+/* Delivers whatever is queued already, then stops the workers */
+void
+notif_async_stop(void);
+
+/* Copies the publish and queues it to the dispatcher, cost does not
+ * depend on the no of subscribers. Delivers on the caller's thread,
+ * as notif_chain_invoke(), if the workers are not running */
+void
+notif_chain_invoke_async(notif_chain_t *notif_chain,
+                notif_chain_elem_t *notif_chain_elem);
+
+/* As notif_chain_invoke_async(), but never conflated. Used to
+ * deliver what the conflation window let through */
+void
+notif_async_dispatch(notif_chain_t *notif_chain,
+                notif_chain_elem_t *notif_chain_elem);
+
+#endif /* __NOTIF_ASYNC_H__ */
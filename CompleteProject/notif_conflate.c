@@ -0,0 +1,406 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  notif_conflate.c
+ *
+ *    Description:  This file implements the per key conflation window of Notification
+ *                  Chains
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026 10:52:43 PM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Er. Abhishek Sagar, Juniper Networks (https://csepracticals.wixsite.com/csepracticals), sachinites@gmail.com
+ *        Company:  Juniper Networks
+ *
+ *        This file is part of the NotificationChains distribution (https://github.com/sachinites)
+ *        Copynext (c) 2019 Abhishek Sagar.
+ *        This program is free software: you can redistribute it and/or modify it under the terms of the GNU General
+ *        Public License as published by the Free Software Foundation, version 3.
+ *
+ *        This program is distributed in the hope that it will be useful, but
+ *        WITHOUT ANY WARRANTY; without even the implied warranty of
+ *        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *        General Public License for more details.
+ *
+ *        visit website : https://csepracticals.wixsite.com/csepracticals for more courses and projects
+ *
+ * =====================================================================================
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <memory.h>
+#include <time.h>
+#include <pthread.h>
+#include "notif.h"
+#include "notif_slab.h"
+#include "notif_rcu.h"
+#include "notif_async.h"
+#include "notif_conflate.h"
+
+/* Latest publish of a key, not yet delivered */
+typedef struct notif_conflate_entry_{
+
+	notif_chain_elem_t notif_chain_elem;
+	uint32_t key_hash;
+	struct timespec deadline;
+	/* A high priority publish was made for the key, deliver
+	 * without waiting for the deadline */
+	bool urgent;
+	struct notif_conflate_entry_ *next;
+} notif_conflate_entry_t;
+
+struct notif_chain_conflation_{
+
+	notif_chain_t *notif_chain;
+	uint32_t window_ms;
+	/* Protects everything below */
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	/* key hash -> notif_conflate_entry_t */
+	notif_hash_table_t pending_index;
+	/* FIFO of entries by first publish, hence by deadline. A
+	 * replaced entry keeps its place */
+	notif_conflate_entry_t *head;
+	notif_conflate_entry_t *tail;
+	/* No of urgent entries in the FIFO */
+	uint32_t n_urgent;
+	bool stop;
+	pthread_t flusher;
+	uint64_t n_held;
+	uint64_t n_conflated;
+	uint64_t n_flushed;
+};
+
+static notif_slab_t notif_conflate_entry_slab =
+	NOTIF_SLAB_INITIALIZER("notif_conflate_entry_t",
+		sizeof(notif_conflate_entry_t));
+
+static bool
+notif_conflate_timespec_before(struct timespec *ts1, struct timespec *ts2){
+
+	if(ts1->tv_sec != ts2->tv_sec) return ts1->tv_sec < ts2->tv_sec;
+	return ts1->tv_nsec < ts2->tv_nsec;
+}
+
+static notif_conflate_entry_t *
+notif_conflate_lookup_entry(notif_chain_conflation_t *conflation,
+		uint32_t key_hash,
+		void *app_key_data,
+		uint32_t app_key_data_size){
+
+	notif_hash_entry_t *entry;
+	notif_conflate_entry_t *conflate_entry;
+
+	ITERATE_NOTIF_HASH_BUCKET_BEGIN(&conflation->pending_index,
+			key_hash, entry){
+
+		conflate_entry = (notif_conflate_entry_t *)entry->data;
+
+		if(conflate_entry->notif_chain_elem.data.app_key_data_size ==
+				app_key_data_size &&
+			memcmp(conflate_entry->notif_chain_elem.data.app_key_data,
+				app_key_data, app_key_data_size) == 0){
+
+			return conflate_entry;
+		}
+	} ITERATE_NOTIF_HASH_BUCKET_END(&conflation->pending_index,
+			key_hash, entry);
+
+	return NULL;
+}
+
+static void *
+notif_conflate_flusher_fn(void *arg){
+
+	bool due;
+	struct timespec now;
+	notif_conflate_entry_t *expired, *expired_tail,
+						   *last, *conflate_entry, **conflate_entry_slot;
+	notif_chain_conflation_t *conflation = (notif_chain_conflation_t *)arg;
+
+	pthread_mutex_lock(&conflation->mutex);
+
+	while(1){
+
+		if(!conflation->head){
+			/* Stop only once everything held is delivered */
+			if(conflation->stop) break;
+			pthread_cond_wait(&conflation->cond, &conflation->mutex);
+			continue;
+		}
+
+		clock_gettime(CLOCK_MONOTONIC, &now);
+
+		if(!conflation->stop && !conflation->n_urgent &&
+			notif_conflate_timespec_before(&now, &conflation->head->deadline)){
+
+			pthread_cond_timedwait(&conflation->cond, &conflation->mutex,
+					&conflation->head->deadline);
+			continue;
+		}
+
+		/* Detach every expired or urgent entry, all of them when
+		 * stopping. Past the expired ones, the rest of the FIFO
+		 * is looked at only for urgent entries */
+		expired = expired_tail = last = NULL;
+		conflate_entry_slot = &conflation->head;
+
+		while((conflate_entry = *conflate_entry_slot)){
+
+			due = conflation->stop || conflate_entry->urgent ||
+				!notif_conflate_timespec_before(&now, &conflate_entry->deadline);
+
+			if(!due){
+				if(!conflation->n_urgent) break;
+				last = conflate_entry;
+				conflate_entry_slot = &conflate_entry->next;
+				continue;
+			}
+
+			*conflate_entry_slot = conflate_entry->next;
+			if(!conflate_entry->next) conflation->tail = last;
+			if(conflate_entry->urgent) conflation->n_urgent--;
+
+			notif_hash_table_remove(&conflation->pending_index,
+					conflate_entry->key_hash, (void *)conflate_entry);
+			conflation->n_flushed++;
+
+			conflate_entry->next = NULL;
+			if(expired_tail){
+				expired_tail->next = conflate_entry;
+			}
+			else {
+				expired = conflate_entry;
+			}
+			expired_tail = conflate_entry;
+		}
+
+		pthread_mutex_unlock(&conflation->mutex);
+
+		for(conflate_entry = expired; conflate_entry; conflate_entry = last){
+
+			last = conflate_entry->next;
+			notif_async_dispatch(conflation->notif_chain,
+					&conflate_entry->notif_chain_elem);
+			notif_chain_elem_free_publish(&conflate_entry->notif_chain_elem);
+			notif_slab_free(&notif_conflate_entry_slab, conflate_entry);
+		}
+
+		/* Hash entries removed above */
+		notif_rcu_reclaim();
+
+		pthread_mutex_lock(&conflation->mutex);
+	}
+
+	pthread_mutex_unlock(&conflation->mutex);
+	return NULL;
+}
+
+bool
+notif_chain_enable_conflation(notif_chain_t *notif_chain,
+		uint32_t window_ms){
+
+	pthread_condattr_t condattr;
+	notif_chain_conflation_t *conflation;
+
+	if(!window_ms || window_ms > NOTIF_CONFLATE_MAX_WINDOW_MS){
+		printf("%s() : Error : Invalid conflation window %u ms\n",
+				__FUNCTION__, window_ms);
+		return false;
+	}
+
+	pthread_mutex_lock(&notif_chain->mutex);
+
+	if(notif_chain->conflation){
+		pthread_mutex_unlock(&notif_chain->mutex);
+		printf("%s() : Error : Notif Chain %s already conflates\n",
+				__FUNCTION__, notif_chain->name);
+		return false;
+	}
+
+	conflation = calloc(1, sizeof(notif_chain_conflation_t));
+	conflation->notif_chain = notif_chain;
+	conflation->window_ms = window_ms;
+	pthread_mutex_init(&conflation->mutex, NULL);
+
+	/* Deadlines must not move with the wall clock */
+	pthread_condattr_init(&condattr);
+	pthread_condattr_setclock(&condattr, CLOCK_MONOTONIC);
+	pthread_cond_init(&conflation->cond, &condattr);
+	pthread_condattr_destroy(&condattr);
+
+	pthread_create(&conflation->flusher, NULL,
+			notif_conflate_flusher_fn, (void *)conflation);
+
+	NOTIF_RCU_ASSIGN_POINTER(notif_chain->conflation, conflation);
+
+	pthread_mutex_unlock(&notif_chain->mutex);
+	return true;
+}
+
+static void
+notif_conflate_free_retired_conflation(void *arg){
+
+	notif_chain_conflation_t *conflation = (notif_chain_conflation_t *)arg;
+
+	pthread_mutex_destroy(&conflation->mutex);
+	pthread_cond_destroy(&conflation->cond);
+	free(conflation);
+}
+
+void
+notif_chain_disable_conflation(notif_chain_t *notif_chain){
+
+	notif_chain_conflation_t *conflation;
+
+	pthread_mutex_lock(&notif_chain->mutex);
+	conflation = notif_chain->conflation;
+	NOTIF_RCU_ASSIGN_POINTER(notif_chain->conflation, NULL);
+	pthread_mutex_unlock(&notif_chain->mutex);
+
+	if(!conflation) return;
+
+	/* Publishers still holding conflation see stop, and deliver
+	 * by themselves */
+	pthread_mutex_lock(&conflation->mutex);
+	conflation->stop = true;
+	pthread_cond_signal(&conflation->cond);
+	pthread_mutex_unlock(&conflation->mutex);
+
+	pthread_join(conflation->flusher, NULL);
+
+	notif_hash_table_destroy(&conflation->pending_index);
+	notif_rcu_retire(conflation, notif_conflate_free_retired_conflation);
+	notif_rcu_reclaim();
+}
+
+/* High priority publishes still go through the window, so that they
+ * are delivered after anything the flusher has taken for the key
+ * already, but without waiting for the deadline.
+ * Called with conflation->mutex held */
+static void
+notif_conflate_mark_urgent(notif_chain_conflation_t *conflation,
+		notif_conflate_entry_t *conflate_entry){
+
+	if(conflate_entry->urgent ||
+		NOTIF_CHAIN_ELEM_LANE(&conflate_entry->notif_chain_elem) !=
+			NOTIF_C_LANE_HIGH){
+		return;
+	}
+
+	conflate_entry->urgent = true;
+	conflation->n_urgent++;
+	pthread_cond_signal(&conflation->cond);
+}
+
+bool
+notif_conflate_publish(notif_chain_t *notif_chain,
+		notif_chain_elem_t *notif_chain_elem){
+
+	uint32_t key_hash;
+	notif_conflate_entry_t *conflate_entry;
+	notif_chain_conflation_t *conflation;
+
+	if(!notif_chain_elem ||
+		NOTIF_CHAIN_ELEM_IS_WILDCARD(notif_chain_elem)){
+		return false;
+	}
+
+	notif_rcu_read_lock();
+
+	conflation = NOTIF_RCU_DEREFERENCE(notif_chain->conflation);
+
+	if(!conflation){
+		notif_rcu_read_unlock();
+		return false;
+	}
+
+	key_hash = notif_hash_bytes(notif_chain_elem->data.app_key_data,
+			notif_chain_elem->data.app_key_data_size, NOTIF_HASH_SEED);
+
+	pthread_mutex_lock(&conflation->mutex);
+
+	if(conflation->stop){
+		pthread_mutex_unlock(&conflation->mutex);
+		notif_rcu_read_unlock();
+		return false;
+	}
+
+	conflation->n_held++;
+
+	conflate_entry = notif_conflate_lookup_entry(conflation, key_hash,
+			notif_chain_elem->data.app_key_data,
+			notif_chain_elem->data.app_key_data_size);
+
+	if(conflate_entry){
+		/* Only the latest state of the key is worth delivering */
+		notif_chain_elem_free_publish(&conflate_entry->notif_chain_elem);
+		notif_chain_elem_copy_publish(&conflate_entry->notif_chain_elem,
+				notif_chain_elem);
+		conflation->n_conflated++;
+		notif_conflate_mark_urgent(conflation, conflate_entry);
+		pthread_mutex_unlock(&conflation->mutex);
+		notif_rcu_read_unlock();
+		return true;
+	}
+
+	conflate_entry = notif_slab_alloc(&notif_conflate_entry_slab);
+	notif_chain_elem_copy_publish(&conflate_entry->notif_chain_elem,
+			notif_chain_elem);
+	conflate_entry->key_hash = key_hash;
+
+	clock_gettime(CLOCK_MONOTONIC, &conflate_entry->deadline);
+	conflate_entry->deadline.tv_sec += conflation->window_ms / 1000;
+	conflate_entry->deadline.tv_nsec += (conflation->window_ms % 1000) * 1000000L;
+	if(conflate_entry->deadline.tv_nsec >= 1000000000L){
+		conflate_entry->deadline.tv_sec++;
+		conflate_entry->deadline.tv_nsec -= 1000000000L;
+	}
+
+	notif_hash_table_insert(&conflation->pending_index,
+			key_hash, (void *)conflate_entry);
+
+	/* Later entries expire later, the flusher needs waking only
+	 * for a new head */
+	if(conflation->tail){
+		conflation->tail->next = conflate_entry;
+	}
+	else {
+		conflation->head = conflate_entry;
+		pthread_cond_signal(&conflation->cond);
+	}
+	conflation->tail = conflate_entry;
+
+	notif_conflate_mark_urgent(conflation, conflate_entry);
+
+	pthread_mutex_unlock(&conflation->mutex);
+	notif_rcu_read_unlock();
+	return true;
+}
+
+void
+notif_conflate_dump(notif_chain_t *notif_chain){
+
+	notif_chain_conflation_t *conflation;
+
+	notif_rcu_read_lock();
+
+	conflation = NOTIF_RCU_DEREFERENCE(notif_chain->conflation);
+
+	if(conflation){
+		pthread_mutex_lock(&conflation->mutex);
+		printf("\tConflation window : %u ms held : %llu conflated : %llu "
+				"flushed : %llu pending : %u\n",
+				conflation->window_ms,
+				(unsigned long long)conflation->n_held,
+				(unsigned long long)conflation->n_conflated,
+				(unsigned long long)conflation->n_flushed,
+				conflation->pending_index.count);
+		pthread_mutex_unlock(&conflation->mutex);
+	}
+
+	notif_rcu_read_unlock();
+}
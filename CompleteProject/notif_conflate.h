@@ -0,0 +1,65 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  notif_conflate.h
+ *
+ *    Description:  This file defines the per key conflation window of Notification Chains,
+ *                  which collapses bursts of publishes for a key into the latest one
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026 10:41:09 PM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Er. Abhishek Sagar, Juniper Networks (https://csepracticals.wixsite.com/csepracticals), sachinites@gmail.com
+ *        Company:  Juniper Networks
+ *
+ *        This file is part of the NotificationChains distribution (https://github.com/sachinites)
+ *        Copynext (c) 2019 Abhishek Sagar.
+ *        This program is free software: you can redistribute it and/or modify it under the terms of the GNU General
+ *        Public License as published by the Free Software Foundation, version 3.
+ *
+ *        This program is distributed in the hope that it will be useful, but
+ *        WITHOUT ANY WARRANTY; without even the implied warranty of
+ *        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *        General Public License for more details.
+ *
+ *        visit website : https://csepracticals.wixsite.com/csepracticals for more courses and projects
+ *
+ * =====================================================================================
+ */
+
+#ifndef __NOTIF_CONFLATE_H__
+#define __NOTIF_CONFLATE_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "notif.h"
+
+#define NOTIF_CONFLATE_DEFAULT_WINDOW_MS	50
+#define NOTIF_CONFLATE_MAX_WINDOW_MS		10000
+
+/* Keyed publishes on the chain are held for window_ms. A publish for
+ * a key already held replaces it, so a key flapping within the window
+ * is delivered once, with its latest notif code and data. Publishes
+ * without a key are not held. Delivery happens on a flusher thread of
+ * the chain, through the workers if notif_async_start() was called */
+bool
+notif_chain_enable_conflation(notif_chain_t *notif_chain,
+                uint32_t window_ms);
+
+/* Delivers whatever is held, then stops the flusher. Must not be
+ * called from a subscriber callback */
+void
+notif_chain_disable_conflation(notif_chain_t *notif_chain);
+
+/* Returns true if the publish was taken into the conflation window,
+ * false if the caller must deliver it */
+bool
+notif_conflate_publish(notif_chain_t *notif_chain,
+                notif_chain_elem_t *notif_chain_elem);
+
+void
+notif_conflate_dump(notif_chain_t *notif_chain);
+
+#endif /* __NOTIF_CONFLATE_H__ */
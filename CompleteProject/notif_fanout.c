@@ -0,0 +1,414 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  notif_fanout.c
+ *
+ *    Description:  This file implements the work stealing fan-out pool of Notification Chains
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026 11:38:15 PM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Er. Abhishek Sagar, Juniper Networks (https://csepracticals.wixsite.com/csepracticals), sachinites@gmail.com
+ *        Company:  Juniper Networks
+ *
+ *        This file is part of the NotificationChains distribution (https://github.com/sachinites)
+ *        Copynext (c) 2019 Abhishek Sagar.
+ *        This program is free software: you can redistribute it and/or modify it under the terms of the GNU General
+ *        Public License as published by the Free Software Foundation, version 3.
+ *
+ *        This program is distributed in the hope that it will be useful, but
+ *        WITHOUT ANY WARRANTY; without even the implied warranty of
+ *        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *        General Public License for more details.
+ *
+ *        visit website : https://csepracticals.wixsite.com/csepracticals for more courses and projects
+ *
+ * =====================================================================================
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <pthread.h>
+#include "notif_fanout.h"
+
+/* One fan-out, on the stack of the thread which runs it */
+typedef struct notif_fanout_job_{
+
+	notif_fanout_fn fn;
+	void *arg;
+	/* Chunks not done yet */
+	uint32_t n_pending;
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+} notif_fanout_job_t;
+
+typedef struct notif_fanout_task_{
+
+	notif_fanout_job_t *job;
+	uint32_t begin;
+	uint32_t end;
+} notif_fanout_task_t;
+
+/* Owner pushes and pops at bottom, thieves take from top */
+typedef struct notif_fanout_deque_{
+
+	pthread_mutex_t mutex;
+	uint32_t top;
+	uint32_t bottom;
+	notif_fanout_task_t tasks[NOTIF_FANOUT_DEQUE_SIZE];
+} notif_fanout_deque_t;
+
+typedef struct notif_fanout_pool_ notif_fanout_pool_t;
+
+typedef struct notif_fanout_worker_{
+
+	pthread_t thread;
+	/* Not notif_fanout_pool, which a stop may have cleared by the
+	 * time the worker starts */
+	notif_fanout_pool_t *pool;
+	uint32_t index;
+	notif_fanout_deque_t deque;
+} notif_fanout_worker_t;
+
+struct notif_fanout_pool_{
+
+	notif_fanout_worker_t *workers;
+	uint32_t n_workers;
+	/* Tasks sitting in the deques */
+	uint32_t n_queued;
+	/* Deque the next fan-out starts filling from */
+	uint32_t next_deque;
+	bool stop;
+	/* Idle workers sleep on cond until n_queued or stop */
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+};
+
+/* Held for reading by every notif_fanout_run() in progress */
+static pthread_rwlock_t notif_fanout_rwlock = PTHREAD_RWLOCK_INITIALIZER;
+static notif_fanout_pool_t *notif_fanout_pool;
+
+/* Set while the thread runs a chunk : a fan-out started from there
+ * could wait on workers waiting on it in turn */
+static __thread bool notif_fanout_in_chunk;
+
+static bool
+notif_fanout_deque_push(notif_fanout_deque_t *deque,
+		notif_fanout_task_t *task){
+
+	pthread_mutex_lock(&deque->mutex);
+
+	if(deque->bottom - deque->top == NOTIF_FANOUT_DEQUE_SIZE){
+		pthread_mutex_unlock(&deque->mutex);
+		return false;
+	}
+	deque->tasks[deque->bottom % NOTIF_FANOUT_DEQUE_SIZE] = *task;
+	/* Atomic stores, for notif_fanout_deque_steal()'s peek */
+	__atomic_store_n(&deque->bottom, deque->bottom + 1, __ATOMIC_RELAXED);
+
+	pthread_mutex_unlock(&deque->mutex);
+	return true;
+}
+
+static bool
+notif_fanout_deque_pop(notif_fanout_deque_t *deque,
+		notif_fanout_task_t *task){
+
+	pthread_mutex_lock(&deque->mutex);
+
+	if(deque->bottom == deque->top){
+		pthread_mutex_unlock(&deque->mutex);
+		return false;
+	}
+	*task = deque->tasks[(deque->bottom - 1) % NOTIF_FANOUT_DEQUE_SIZE];
+	__atomic_store_n(&deque->bottom, deque->bottom - 1, __ATOMIC_RELAXED);
+
+	pthread_mutex_unlock(&deque->mutex);
+	return true;
+}
+
+static bool
+notif_fanout_deque_steal(notif_fanout_deque_t *deque,
+		notif_fanout_task_t *task){
+
+	/* Unlocked peek, not worth contending for an empty deque */
+	if(__atomic_load_n(&deque->bottom, __ATOMIC_RELAXED) ==
+			__atomic_load_n(&deque->top, __ATOMIC_RELAXED)){
+		return false;
+	}
+
+	pthread_mutex_lock(&deque->mutex);
+
+	if(deque->bottom == deque->top){
+		pthread_mutex_unlock(&deque->mutex);
+		return false;
+	}
+	*task = deque->tasks[deque->top % NOTIF_FANOUT_DEQUE_SIZE];
+	__atomic_store_n(&deque->top, deque->top + 1, __ATOMIC_RELAXED);
+
+	pthread_mutex_unlock(&deque->mutex);
+	return true;
+}
+
+/* Steals from the deques after first_index, round the pool */
+static bool
+notif_fanout_steal(notif_fanout_pool_t *pool,
+		uint32_t first_index,
+		notif_fanout_task_t *task){
+
+	uint32_t i;
+
+	for(i = 0; i < pool->n_workers; i++){
+
+		if(notif_fanout_deque_steal(
+					&pool->workers[(first_index + i) % pool->n_workers].deque,
+					task)){
+			__atomic_sub_fetch(&pool->n_queued, 1, __ATOMIC_RELAXED);
+			return true;
+		}
+	}
+	return false;
+}
+
+static void
+notif_fanout_run_task(notif_fanout_task_t *task){
+
+	notif_fanout_job_t *job = task->job;
+
+	notif_fanout_in_chunk = true;
+	job->fn(job->arg, task->begin, task->end);
+	notif_fanout_in_chunk = false;
+
+	/* Under the mutex : the job is gone as soon as its owner
+	 * sees n_pending drop to 0 */
+	pthread_mutex_lock(&job->mutex);
+	if(!--job->n_pending) pthread_cond_signal(&job->cond);
+	pthread_mutex_unlock(&job->mutex);
+}
+
+static void *
+notif_fanout_worker_fn(void *arg){
+
+	notif_fanout_task_t task;
+	notif_fanout_worker_t *worker = (notif_fanout_worker_t *)arg;
+	notif_fanout_pool_t *pool = worker->pool;
+
+	while(1){
+
+		if(notif_fanout_deque_pop(&worker->deque, &task)){
+			__atomic_sub_fetch(&pool->n_queued, 1, __ATOMIC_RELAXED);
+			notif_fanout_run_task(&task);
+			continue;
+		}
+
+		if(notif_fanout_steal(pool, worker->index + 1, &task)){
+			notif_fanout_run_task(&task);
+			continue;
+		}
+
+		pthread_mutex_lock(&pool->mutex);
+
+		while(!__atomic_load_n(&pool->n_queued, __ATOMIC_RELAXED) &&
+				!pool->stop){
+			pthread_cond_wait(&pool->cond, &pool->mutex);
+		}
+
+		if(pool->stop){
+			pthread_mutex_unlock(&pool->mutex);
+			break;
+		}
+		pthread_mutex_unlock(&pool->mutex);
+	}
+	return NULL;
+}
+
+bool
+notif_fanout_start(uint32_t n_workers){
+
+	uint32_t i;
+	notif_fanout_pool_t *pool;
+	notif_fanout_worker_t *worker;
+
+	if(!n_workers || n_workers > NOTIF_FANOUT_MAX_WORKERS){
+		printf("%s() : Error : Invalid no of workers %u\n",
+				__FUNCTION__, n_workers);
+		return false;
+	}
+
+	pthread_rwlock_wrlock(&notif_fanout_rwlock);
+
+	if(notif_fanout_pool){
+		pthread_rwlock_unlock(&notif_fanout_rwlock);
+		printf("%s() : Error : Workers already running\n", __FUNCTION__);
+		return false;
+	}
+
+	pool = calloc(1, sizeof(notif_fanout_pool_t));
+	pool->workers = calloc(n_workers, sizeof(notif_fanout_worker_t));
+	pool->n_workers = n_workers;
+	pthread_mutex_init(&pool->mutex, NULL);
+	pthread_cond_init(&pool->cond, NULL);
+
+	/* Every deque is ready before any worker may steal from it */
+	for(i = 0; i < n_workers; i++){
+
+		worker = &pool->workers[i];
+		worker->pool = pool;
+		worker->index = i;
+		pthread_mutex_init(&worker->deque.mutex, NULL);
+	}
+
+	for(i = 0; i < n_workers; i++){
+		pthread_create(&pool->workers[i].thread, NULL,
+				notif_fanout_worker_fn, (void *)&pool->workers[i]);
+	}
+
+	__atomic_store_n(&notif_fanout_pool, pool, __ATOMIC_RELEASE);
+
+	pthread_rwlock_unlock(&notif_fanout_rwlock);
+	return true;
+}
+
+void
+notif_fanout_stop(void){
+
+	uint32_t i;
+	notif_fanout_pool_t *pool;
+
+	/* Fan-outs in progress hold the lock, and finish first */
+	pthread_rwlock_wrlock(&notif_fanout_rwlock);
+	pool = notif_fanout_pool;
+	__atomic_store_n(&notif_fanout_pool, NULL, __ATOMIC_RELEASE);
+	pthread_rwlock_unlock(&notif_fanout_rwlock);
+
+	if(!pool) return;
+
+	pthread_mutex_lock(&pool->mutex);
+	pool->stop = true;
+	pthread_cond_broadcast(&pool->cond);
+	pthread_mutex_unlock(&pool->mutex);
+
+	for(i = 0; i < pool->n_workers; i++){
+		pthread_join(pool->workers[i].thread, NULL);
+		pthread_mutex_destroy(&pool->workers[i].deque.mutex);
+	}
+
+	pthread_mutex_destroy(&pool->mutex);
+	pthread_cond_destroy(&pool->cond);
+	free(pool->workers);
+	free(pool);
+}
+
+bool
+notif_fanout_is_active(void){
+
+	return !notif_fanout_in_chunk &&
+		__atomic_load_n(&notif_fanout_pool, __ATOMIC_RELAXED);
+}
+
+void
+notif_fanout_run(notif_fanout_fn fn, void *arg, uint32_t n_items){
+
+	uint32_t chunk_size, first_deque, n_deques, n_pushed;
+	notif_fanout_job_t job;
+	notif_fanout_task_t task;
+	notif_fanout_pool_t *pool;
+
+	if(n_items < NOTIF_FANOUT_THRESHOLD || notif_fanout_in_chunk){
+		if(n_items) fn(arg, 0, n_items);
+		return;
+	}
+
+	pthread_rwlock_rdlock(&notif_fanout_rwlock);
+
+	pool = notif_fanout_pool;
+	if(!pool){
+		pthread_rwlock_unlock(&notif_fanout_rwlock);
+		fn(arg, 0, n_items);
+		return;
+	}
+
+	chunk_size = n_items /
+		((pool->n_workers + 1) * NOTIF_FANOUT_CHUNKS_PER_THREAD);
+	if(chunk_size < NOTIF_FANOUT_MIN_CHUNK) chunk_size = NOTIF_FANOUT_MIN_CHUNK;
+
+	job.fn = fn;
+	job.arg = arg;
+	job.n_pending = 0;
+	pthread_mutex_init(&job.mutex, NULL);
+	pthread_cond_init(&job.cond, NULL);
+
+	/* Concurrent fan-outs start on different deques */
+	n_deques = pool->n_workers;
+	first_deque = __atomic_fetch_add(&pool->next_deque, 1, __ATOMIC_RELAXED);
+
+	/* Chunks after the first are dealt round the deques, the
+	 * first one is the caller's own */
+	task.job = &job;
+	n_pushed = 0;
+
+	for(task.begin = chunk_size; task.begin < n_items; task.begin = task.end){
+
+		task.end = task.begin + chunk_size;
+		if(task.end > n_items || n_items - task.end < chunk_size / 2){
+			task.end = n_items;
+		}
+
+		pthread_mutex_lock(&job.mutex);
+		job.n_pending++;
+		pthread_mutex_unlock(&job.mutex);
+
+		if(notif_fanout_deque_push(
+					&pool->workers[(first_deque + n_pushed) % n_deques].deque,
+					&task)){
+			__atomic_add_fetch(&pool->n_queued, 1, __ATOMIC_RELAXED);
+			n_pushed++;
+			continue;
+		}
+		/* Deque full, the pool is swamped anyway */
+		notif_fanout_run_task(&task);
+	}
+
+	if(n_pushed){
+		pthread_mutex_lock(&pool->mutex);
+		pthread_cond_broadcast(&pool->cond);
+		pthread_mutex_unlock(&pool->mutex);
+	}
+
+	notif_fanout_in_chunk = true;
+	fn(arg, 0, chunk_size < n_items ? chunk_size : n_items);
+	notif_fanout_in_chunk = false;
+
+	/* Help with whatever is queued, ours or not, until ours are
+	 * all taken. Chunks never wait on anything, so neither do
+	 * the ones taken here */
+	while(1){
+
+		pthread_mutex_lock(&job.mutex);
+		if(!job.n_pending){
+			pthread_mutex_unlock(&job.mutex);
+			break;
+		}
+		pthread_mutex_unlock(&job.mutex);
+
+		if(notif_fanout_steal(pool, first_deque, &task)){
+			notif_fanout_run_task(&task);
+			continue;
+		}
+
+		/* What is left of ours is running elsewhere */
+		pthread_mutex_lock(&job.mutex);
+		while(job.n_pending){
+			pthread_cond_wait(&job.cond, &job.mutex);
+		}
+		pthread_mutex_unlock(&job.mutex);
+		break;
+	}
+
+	pthread_mutex_destroy(&job.mutex);
+	pthread_cond_destroy(&job.cond);
+
+	pthread_rwlock_unlock(&notif_fanout_rwlock);
+}
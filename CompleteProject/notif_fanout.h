@@ -0,0 +1,74 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  notif_fanout.h
+ *
+ *    Description:  This file defines the work stealing pool which fans a publish out to a
+ *                  large set of Notification Chains subscribers in parallel
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026 11:38:15 PM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Er. Abhishek Sagar, Juniper Networks (https://csepracticals.wixsite.com/csepracticals), sachinites@gmail.com
+ *        Company:  Juniper Networks
+ *
+ *        This file is part of the NotificationChains distribution (https://github.com/sachinites)
+ *        Copynext (c) 2019 Abhishek Sagar.
+ *        This program is free software: you can redistribute it and/or modify it under the terms of the GNU General
+ *        Public License as published by the Free Software Foundation, version 3.
+ *
+ *        This program is distributed in the hope that it will be useful, but
+ *        WITHOUT ANY WARRANTY; without even the implied warranty of
+ *        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *        General Public License for more details.
+ *
+ *        visit website : https://csepracticals.wixsite.com/csepracticals for more courses and projects
+ *
+ * =====================================================================================
+ */
+
+#ifndef __NOTIF_FANOUT_H__
+#define __NOTIF_FANOUT_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define NOTIF_FANOUT_DEFAULT_WORKERS	4
+#define NOTIF_FANOUT_MAX_WORKERS		64
+/* Fewer items than this are not worth waking up the pool */
+#define NOTIF_FANOUT_THRESHOLD			1024
+/* Smallest chunk of items handed out */
+#define NOTIF_FANOUT_MIN_CHUNK			128
+/* Chunks per participating thread, so that stealing can even out
+ * slow subscribers */
+#define NOTIF_FANOUT_CHUNKS_PER_THREAD	8
+#define NOTIF_FANOUT_DEQUE_SIZE			1024
+
+/* Processes items [begin, end) */
+typedef void (*notif_fanout_fn)(void *arg, uint32_t begin, uint32_t end);
+
+/* Starts n_workers threads, each owning a deque of chunks. A worker
+ * takes the most recent chunk of its own deque, and once it runs
+ * dry steals the oldest chunk of another worker's */
+bool
+notif_fanout_start(uint32_t n_workers);
+
+/* Waits for the fan-outs in progress, then stops the workers */
+void
+notif_fanout_stop(void);
+
+/* true if notif_fanout_run() on this thread could go parallel */
+bool
+notif_fanout_is_active(void);
+
+/* Runs fn over n_items, split into chunks spread over the workers
+ * while the caller takes its share, and returns once all are done.
+ * Runs fn on the caller's thread alone if n_items is below
+ * NOTIF_FANOUT_THRESHOLD, if the pool is not running, or if called
+ * from within a chunk */
+void
+notif_fanout_run(notif_fanout_fn fn, void *arg, uint32_t n_items);
+
+#endif /* __NOTIF_FANOUT_H__ */
@@ -0,0 +1,198 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  notif_hash.c
+ *
+ *    Description:  This file implements the chained Hash Table used by Notification Chains
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026 09:20:11 AM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Er. Abhishek Sagar, Juniper Networks (https://csepracticals.wixsite.com/csepracticals), sachinites@gmail.com
+ *        Company:  Juniper Networks
+ *
+ *        This file is part of the NotificationChains distribution (https://github.com/sachinites)
+ *        Copynext (c) 2019 Abhishek Sagar.
+ *        This program is free software: you can redistribute it and/or modify it under the terms of the GNU General
+ *        Public License as published by the Free Software Foundation, version 3.
+ *
+ *        This program is distributed in the hope that it will be useful, but
+ *        WITHOUT ANY WARRANTY; without even the implied warranty of
+ *        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *        General Public License for more details.
+ *
+ *        visit website : https://csepracticals.wixsite.com/csepracticals for more courses and projects
+ *
+ * =====================================================================================
+ */
+
+#include <stdlib.h>
+#include <memory.h>
+#include <assert.h>
+#include "notif_hash.h"
+#include "notif_slab.h"
+
+static notif_slab_t notif_hash_entry_slab = 
+	NOTIF_SLAB_INITIALIZER("notif_hash_entry_t", sizeof(notif_hash_entry_t));
+
+uint32_t
+notif_hash_bytes(void *data, uint32_t size, uint32_t seed){
+
+	uint32_t i;
+	uint32_t hash = seed;
+	uint8_t *ptr = (uint8_t *)data;
+
+	for(i = 0; i < size; i++){
+		hash ^= ptr[i];
+		hash *= 16777619U;
+	}
+	return hash;
+}
+
+static void
+notif_hash_free_entry(void *entry){
+
+	notif_slab_free(&notif_hash_entry_slab, entry);
+}
+
+static notif_hash_buckets_t *
+notif_hash_buckets_alloc(uint32_t n_buckets){
+
+	notif_hash_buckets_t *buckets;
+
+	buckets = calloc(1, sizeof(notif_hash_buckets_t) +
+				n_buckets * sizeof(notif_hash_entry_t *));
+	buckets->n_buckets = n_buckets;
+	return buckets;
+}
+
+/* Retire all entries of the bucket array, and the array itself */
+static void
+notif_hash_buckets_retire(notif_hash_buckets_t *buckets){
+
+	uint32_t index;
+	notif_hash_entry_t *entry;
+
+	for(index = 0; index < buckets->n_buckets; index++){
+
+		for(entry = buckets->bucket[index]; entry; entry = entry->next){
+			notif_rcu_retire(entry, notif_hash_free_entry);
+		}
+	}
+	notif_rcu_retire(buckets, free);
+}
+
+void
+notif_hash_table_init(notif_hash_table_t *tbl, uint32_t n_buckets){
+
+	uint32_t size = NOTIF_HASH_DEFAULT_BUCKETS;
+
+	/* Round up to power of 2 */
+	while(size < n_buckets) size <<= 1;
+
+	tbl->count = 0;
+	NOTIF_RCU_ASSIGN_POINTER(tbl->buckets, notif_hash_buckets_alloc(size));
+}
+
+void
+notif_hash_table_destroy(notif_hash_table_t *tbl){
+
+	notif_hash_buckets_t *buckets = tbl->buckets;
+
+	if(!buckets) return;
+
+	NOTIF_RCU_ASSIGN_POINTER(tbl->buckets, NULL);
+	tbl->count = 0;
+	notif_hash_buckets_retire(buckets);
+}
+
+/* Readers may be walking the old buckets, so the entries are
+ * copied into the new bucket array which is then published whole */
+static void
+notif_hash_table_resize(notif_hash_table_t *tbl, uint32_t new_n_buckets){
+
+	uint32_t index, new_index;
+	notif_hash_entry_t *entry, *new_entry;
+	notif_hash_buckets_t *old_buckets = tbl->buckets;
+	notif_hash_buckets_t *new_buckets;
+
+	new_buckets = notif_hash_buckets_alloc(new_n_buckets);
+
+	for(index = 0; index < old_buckets->n_buckets; index++){
+
+		for(entry = old_buckets->bucket[index]; entry; entry = entry->next){
+
+			new_entry = notif_slab_alloc(&notif_hash_entry_slab);
+			new_entry->hash = entry->hash;
+			new_entry->data = entry->data;
+
+			new_index = NOTIF_HASH_BUCKET_INDEX(new_buckets, entry->hash);
+			new_entry->next = new_buckets->bucket[new_index];
+			new_buckets->bucket[new_index] = new_entry;
+		}
+	}
+
+	NOTIF_RCU_ASSIGN_POINTER(tbl->buckets, new_buckets);
+	notif_hash_buckets_retire(old_buckets);
+}
+
+void
+notif_hash_table_insert(notif_hash_table_t *tbl,
+						uint32_t hash,
+						void *data){
+
+	uint32_t index;
+	notif_hash_entry_t *entry;
+
+	if(!tbl->buckets){
+		notif_hash_table_init(tbl, NOTIF_HASH_DEFAULT_BUCKETS);
+	}
+
+	entry = notif_slab_alloc(&notif_hash_entry_slab);
+	entry->hash = hash;
+	entry->data = data;
+
+	index = NOTIF_HASH_BUCKET_INDEX(tbl->buckets, hash);
+	entry->next = tbl->buckets->bucket[index];
+	NOTIF_RCU_ASSIGN_POINTER(tbl->buckets->bucket[index], entry);
+	tbl->count++;
+
+	if(tbl->count > tbl->buckets->n_buckets * NOTIF_HASH_MAX_LOAD_FACTOR){
+		notif_hash_table_resize(tbl, tbl->buckets->n_buckets << 1);
+	}
+}
+
+bool
+notif_hash_table_remove(notif_hash_table_t *tbl,
+						uint32_t hash,
+						void *data){
+
+	notif_hash_entry_t **prev_next;
+	notif_hash_entry_t *entry;
+
+	if(!tbl->buckets) return false;
+
+	prev_next = &tbl->buckets->bucket[NOTIF_HASH_BUCKET_INDEX(tbl->buckets, hash)];
+
+	for(entry = *prev_next; entry; entry = *prev_next){
+
+		if(entry->hash == hash && entry->data == data){
+			/* entry->next is left intact for readers on entry */
+			NOTIF_RCU_ASSIGN_POINTER(*prev_next, entry->next);
+			notif_rcu_retire(entry, notif_hash_free_entry);
+			assert(tbl->count);
+			tbl->count--;
+			return true;
+		}
+		prev_next = &entry->next;
+	}
+	return false;
+}
+
+void
+notif_hash_dump_allocator(void){
+
+	notif_slab_dump(&notif_hash_entry_slab);
+}
@@ -0,0 +1,134 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  notif_hash.h
+ *
+ *    Description:  This file defines the chained Hash Table used by Notification Chains
+ *                  to index chains, subscriptions and communication channels
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026 09:12:40 AM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Er. Abhishek Sagar, Juniper Networks (https://csepracticals.wixsite.com/csepracticals), sachinites@gmail.com
+ *        Company:  Juniper Networks
+ *
+ *        This file is part of the NotificationChains distribution (https://github.com/sachinites)
+ *        Copynext (c) 2019 Abhishek Sagar.
+ *        This program is free software: you can redistribute it and/or modify it under the terms of the GNU General
+ *        Public License as published by the Free Software Foundation, version 3.
+ *
+ *        This program is distributed in the hope that it will be useful, but
+ *        WITHOUT ANY WARRANTY; without even the implied warranty of
+ *        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *        General Public License for more details.
+ *
+ *        visit website : https://csepracticals.wixsite.com/csepracticals for more courses and projects
+ *
+ * =====================================================================================
+ */
+
+#ifndef __NOTIF_HASH_H__
+#define __NOTIF_HASH_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "notif_rcu.h"
+
+/* Bucket count used when a zeroed table sees its first insert.
+ * Must be a power of 2 */
+#define NOTIF_HASH_DEFAULT_BUCKETS	16
+/* Table doubles its buckets when count exceeds n_buckets * this */
+#define NOTIF_HASH_MAX_LOAD_FACTOR	2
+
+#define NOTIF_HASH_SEED				2166136261U
+
+typedef struct notif_hash_entry_{
+
+	uint32_t hash;
+	void *data;
+	struct notif_hash_entry_ *next;
+} notif_hash_entry_t;
+
+/* Bucket array and its size are published to readers together */
+typedef struct notif_hash_buckets_{
+
+	uint32_t n_buckets;	/* Always power of 2 */
+	notif_hash_entry_t *bucket[];
+} notif_hash_buckets_t;
+
+/* A zeroed notif_hash_table_t is a valid empty table,
+ * buckets are allocated on first insert.
+ * Lookups and iterations are safe against one concurrent writer
+ * when done within notif_rcu_read_lock(), writers must be serialized
+ * by the owner of the table. Entries removed and bucket arrays
+ * replaced on resize are freed through notif_rcu_retire() */
+typedef struct notif_hash_table_{
+
+	notif_hash_buckets_t *buckets;
+	uint32_t count;
+} notif_hash_table_t;
+
+#define NOTIF_HASH_BUCKET_INDEX(buckets_ptr, hash_val)	\
+	((hash_val) & ((buckets_ptr)->n_buckets - 1))
+
+/* FNV-1a, seed with NOTIF_HASH_SEED or with the result of
+ * previous call to hash composite keys */
+uint32_t
+notif_hash_bytes(void *data, uint32_t size, uint32_t seed);
+
+void
+notif_hash_table_init(notif_hash_table_t *tbl, uint32_t n_buckets);
+
+void
+notif_hash_table_destroy(notif_hash_table_t *tbl);
+
+void
+notif_hash_table_insert(notif_hash_table_t *tbl,
+						uint32_t hash,
+						void *data);
+
+bool
+notif_hash_table_remove(notif_hash_table_t *tbl,
+						uint32_t hash,
+						void *data);
+
+/* Occupancy of the allocator of hash entries, shared by all tables */
+void
+notif_hash_dump_allocator(void);
+
+/* Iterate over all entries whose hash is hash_val.
+ * delete safe, normal continue and break can be used */
+#define ITERATE_NOTIF_HASH_BUCKET_BEGIN(tbl_ptr, hash_val, entry_ptr)              \
+{                                                                                  \
+    notif_hash_entry_t *_next_hash_entry = NULL;                                   \
+    notif_hash_buckets_t *_hash_buckets =                                          \
+        NOTIF_RCU_DEREFERENCE((tbl_ptr)->buckets);                                 \
+    entry_ptr = _hash_buckets ? NOTIF_RCU_DEREFERENCE(_hash_buckets->bucket[       \
+        NOTIF_HASH_BUCKET_INDEX(_hash_buckets, hash_val)]) : NULL;                 \
+    for(; entry_ptr; entry_ptr = _next_hash_entry){                                \
+        _next_hash_entry = NOTIF_RCU_DEREFERENCE((entry_ptr)->next);               \
+        if((entry_ptr)->hash != (hash_val)) continue;
+
+#define ITERATE_NOTIF_HASH_BUCKET_END(tbl_ptr, hash_val, entry_ptr)                \
+    }}
+
+/* Iterate over all entries of the table. delete safe,
+ * continue can be used, break only leaves the current bucket */
+#define ITERATE_NOTIF_HASH_TABLE_BEGIN(tbl_ptr, entry_ptr)                         \
+{                                                                                  \
+    uint32_t _bucket_index = 0;                                                    \
+    notif_hash_entry_t *_next_hash_entry = NULL;                                   \
+    notif_hash_buckets_t *_hash_buckets =                                          \
+        NOTIF_RCU_DEREFERENCE((tbl_ptr)->buckets);                                 \
+    for(; _hash_buckets && _bucket_index < _hash_buckets->n_buckets;               \
+            _bucket_index++){                                                      \
+        entry_ptr = NOTIF_RCU_DEREFERENCE(_hash_buckets->bucket[_bucket_index]);   \
+        for(; entry_ptr; entry_ptr = _next_hash_entry){                            \
+            _next_hash_entry = NOTIF_RCU_DEREFERENCE((entry_ptr)->next);
+
+#define ITERATE_NOTIF_HASH_TABLE_END(tbl_ptr, entry_ptr)                           \
+    }}}
+
+#endif /* __NOTIF_HASH_H__ */
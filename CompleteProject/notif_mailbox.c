@@ -0,0 +1,179 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  notif_mailbox.c
+ *
+ *    Description:  This file implements the mailbox delivering Notification Chains
+ *                  notifications to callback subscriber threads
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026 10:17:26 PM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Er. Abhishek Sagar, Juniper Networks (https://csepracticals.wixsite.com/csepracticals), sachinites@gmail.com
+ *        Company:  Juniper Networks
+ *
+ *        This file is part of the NotificationChains distribution (https://github.com/sachinites)
+ *        Copynext (c) 2019 Abhishek Sagar.
+ *        This program is free software: you can redistribute it and/or modify it under the terms of the GNU General
+ *        Public License as published by the Free Software Foundation, version 3.
+ *
+ *        This program is distributed in the hope that it will be useful, but
+ *        WITHOUT ANY WARRANTY; without even the implied warranty of
+ *        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *        General Public License for more details.
+ *
+ *        visit website : https://csepracticals.wixsite.com/csepracticals for more courses and projects
+ *
+ * =====================================================================================
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <memory.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include "notif.h"
+#include "notif_mailbox.h"
+
+notif_mailbox_t *
+notif_mailbox_create(uint32_t size, notif_chain_app_cb app_cb){
+
+	notif_mailbox_t *mailbox;
+
+	if(!size || (size & (size - 1)) || !app_cb){
+		printf("%s() : Error : Invalid mailbox size %u or callback\n",
+				__FUNCTION__, size);
+		return NULL;
+	}
+
+	if(posix_memalign((void **)&mailbox, NOTIF_MAILBOX_CACHE_LINE,
+				sizeof(notif_mailbox_t))){
+		return NULL;
+	}
+	memset(mailbox, 0, sizeof(notif_mailbox_t));
+
+	mailbox->event_fd = eventfd(0, EFD_CLOEXEC);
+	if(mailbox->event_fd < 0){
+		printf("%s() : Error : eventfd failed, errno = %d\n",
+				__FUNCTION__, errno);
+		free(mailbox);
+		return NULL;
+	}
+
+	mailbox->size = size;
+	mailbox->app_cb = app_cb;
+	mailbox->slots = calloc(size, sizeof(notif_chain_elem_t));
+	pthread_mutex_init(&mailbox->producer_mutex, NULL);
+	return mailbox;
+}
+
+void
+notif_mailbox_destroy(notif_mailbox_t *mailbox){
+
+	uint32_t head;
+
+	for(head = mailbox->head; head != mailbox->tail; head++){
+		notif_chain_elem_free_publish(&mailbox->slots[head & (mailbox->size - 1)]);
+	}
+
+	close(mailbox->event_fd);
+	pthread_mutex_destroy(&mailbox->producer_mutex);
+	free(mailbox->slots);
+	free(mailbox);
+}
+
+bool
+notif_mailbox_post(notif_mailbox_t *mailbox,
+				   notif_chain_elem_t *notif_chain_elem){
+
+	uint32_t tail, head;
+	uint64_t event = 1;
+	notif_chain_elem_t *slot;
+
+	pthread_mutex_lock(&mailbox->producer_mutex);
+
+	tail = mailbox->tail;
+	head = __atomic_load_n(&mailbox->head, __ATOMIC_ACQUIRE);
+
+	if(tail - head == mailbox->size){
+		mailbox->n_dropped++;
+		pthread_mutex_unlock(&mailbox->producer_mutex);
+		return false;
+	}
+
+	/* Key and data belong to the publisher and to the subscription,
+	 * neither outlives the publish */
+	slot = &mailbox->slots[tail & (mailbox->size - 1)];
+	notif_chain_elem_copy_publish(slot, notif_chain_elem);
+
+	/* seq_cst pairs with the fence of the consumer's emptiness
+	 * checks : either the consumer sees the slot, or we see it
+	 * drained the mailbox empty and wake it */
+	__atomic_store_n(&mailbox->tail, tail + 1, __ATOMIC_SEQ_CST);
+
+	/* Only reads the consumer's line. The eventfd is written on
+	 * the empty to non-empty transitions only */
+	if(__atomic_load_n(&mailbox->head, __ATOMIC_SEQ_CST) == tail){
+		if(write(mailbox->event_fd, &event, sizeof(event)) < 0){
+			printf("%s() : Error : eventfd write failed, errno = %d\n",
+					__FUNCTION__, errno);
+		}
+	}
+
+	pthread_mutex_unlock(&mailbox->producer_mutex);
+	return true;
+}
+
+int
+notif_mailbox_fd(notif_mailbox_t *mailbox){
+
+	return mailbox->event_fd;
+}
+
+void
+notif_mailbox_wait(notif_mailbox_t *mailbox){
+
+	uint64_t event;
+
+	/* Events of transitions already drained only cost a recheck */
+	while(1){
+
+		__atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+		if(__atomic_load_n(&mailbox->tail, __ATOMIC_SEQ_CST) != mailbox->head){
+			return;
+		}
+
+		while(read(mailbox->event_fd, &event, sizeof(event)) < 0 &&
+				errno == EINTR);
+	}
+}
+
+uint32_t
+notif_mailbox_drain(notif_mailbox_t *mailbox, uint32_t max_batch){
+
+	uint32_t n_drained, head, tail;
+	notif_chain_elem_t *slot;
+
+	head = mailbox->head;
+
+	/* Orders the head stores of the previous drain before the tail
+	 * load, see notif_mailbox_post() : a drain finding the mailbox
+	 * empty is sure to be followed by an event */
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	tail = __atomic_load_n(&mailbox->tail, __ATOMIC_SEQ_CST);
+
+	for(n_drained = 0; head != tail && n_drained < max_batch; n_drained++){
+
+		slot = &mailbox->slots[head & (mailbox->size - 1)];
+		mailbox->app_cb(slot);
+		notif_chain_elem_free_publish(slot);
+
+		/* Hand the slot back to the producer */
+		__atomic_store_n(&mailbox->head, ++head, __ATOMIC_RELEASE);
+	}
+	return n_drained;
+}
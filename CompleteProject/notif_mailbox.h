@@ -0,0 +1,100 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  notif_mailbox.h
+ *
+ *    Description:  This file defines the bounded mailbox through which Notification
+ *                  Chains hands notifications over to callback subscriber threads
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026 10:05:48 PM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Er. Abhishek Sagar, Juniper Networks (https://csepracticals.wixsite.com/csepracticals), sachinites@gmail.com
+ *        Company:  Juniper Networks
+ *
+ *        This file is part of the NotificationChains distribution (https://github.com/sachinites)
+ *        Copynext (c) 2019 Abhishek Sagar.
+ *        This program is free software: you can redistribute it and/or modify it under the terms of the GNU General
+ *        Public License as published by the Free Software Foundation, version 3.
+ *
+ *        This program is distributed in the hope that it will be useful, but
+ *        WITHOUT ANY WARRANTY; without even the implied warranty of
+ *        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *        General Public License for more details.
+ *
+ *        visit website : https://csepracticals.wixsite.com/csepracticals for more courses and projects
+ *
+ * =====================================================================================
+ */
+
+#ifndef __NOTIF_MAILBOX_H__
+#define __NOTIF_MAILBOX_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include "notif.h"
+
+/* Must be power of 2 */
+#define NOTIF_MAILBOX_DEFAULT_SIZE	1024
+/* Max notifications handed to app_cb per notif_mailbox_drain() */
+#define NOTIF_MAILBOX_DEFAULT_BATCH	64
+
+#define NOTIF_MAILBOX_CACHE_LINE	64
+
+/* Single producer single consumer ring of notifications. Publishers
+ * only copy the notification in, the subscriber's own thread runs
+ * app_cb on it. A full mailbox drops the notification rather than
+ * block the publisher */
+struct notif_mailbox_{
+
+    /* Written by consumer only */
+    uint32_t head __attribute__((aligned(NOTIF_MAILBOX_CACHE_LINE)));
+    /* Written by producer only */
+    uint32_t tail __attribute__((aligned(NOTIF_MAILBOX_CACHE_LINE)));
+    uint64_t n_dropped;
+    /* Publishes made through notif_chain_invoke_async() reach a
+     * mailbox from one worker only and never contend on this.
+     * Concurrent notif_chain_invoke() callers are serialized here */
+    pthread_mutex_t producer_mutex;
+
+    uint32_t size __attribute__((aligned(NOTIF_MAILBOX_CACHE_LINE)));
+    /* Counts the posts to an empty mailbox */
+    int event_fd;
+    notif_chain_app_cb app_cb;
+    /* Slots own copies of key and data to notify */
+    notif_chain_elem_t *slots;
+};
+
+notif_mailbox_t *
+notif_mailbox_create(uint32_t size, notif_chain_app_cb app_cb);
+
+/* Subscriber must have unsubscribed all subscriptions using
+ * the mailbox first, queued notifications are discarded */
+void
+notif_mailbox_destroy(notif_mailbox_t *mailbox);
+
+/* Producer side, used by notif chain to deliver */
+bool
+notif_mailbox_post(notif_mailbox_t *mailbox,
+                   notif_chain_elem_t *notif_chain_elem);
+
+/* Consumer side, for subscribers multiplexing the mailbox with
+ * other fds. Becomes readable when a notification is posted to an
+ * empty mailbox : read it, then call notif_mailbox_drain() till it
+ * returns 0 before polling again */
+int
+notif_mailbox_fd(notif_mailbox_t *mailbox);
+
+/* Blocks till at least one notification is queued */
+void
+notif_mailbox_wait(notif_mailbox_t *mailbox);
+
+/* Runs app_cb on up to max_batch queued notifications,
+ * without blocking. Returns the no run */
+uint32_t
+notif_mailbox_drain(notif_mailbox_t *mailbox, uint32_t max_batch);
+
+#endif /* __NOTIF_MAILBOX_H__ */
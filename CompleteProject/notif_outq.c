@@ -0,0 +1,841 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  notif_outq.c
+ *
+ *    Description:  This file implements the bounded outbound queue of socket subscribers
+ *                  and its overflow policies
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026 11:40:17 PM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Er. Abhishek Sagar, Juniper Networks (https://csepracticals.wixsite.com/csepracticals), sachinites@gmail.com
+ *        Company:  Juniper Networks
+ *
+ *        This file is part of the NotificationChains distribution (https://github.com/sachinites)
+ *        Copynext (c) 2019 Abhishek Sagar.
+ *        This program is free software: you can redistribute it and/or modify it under the terms of the GNU General
+ *        Public License as published by the Free Software Foundation, version 3.
+ *
+ *        This program is distributed in the hope that it will be useful, but
+ *        WITHOUT ANY WARRANTY; without even the implied warranty of
+ *        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *        General Public License for more details.
+ *
+ *        visit website : https://csepracticals.wixsite.com/csepracticals for more courses and projects
+ *
+ * =====================================================================================
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <memory.h>
+#include <errno.h>
+#include <assert.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include "utils.h"
+#include "network_utils.h"
+#include "notif.h"
+#include "notif_hash.h"
+#include "notif_slab.h"
+#include "notif_outq.h"
+
+static notif_outq_policy_t notif_outq_default_policy = NOTIF_OUTQ_DROP_OLDEST;
+static uint32_t notif_outq_default_max_depth = NOTIF_OUTQ_DEFAULT_MAX_DEPTH;
+
+/* Queues with messages left, served by the sender thread. Lock
+ * order is notif_outq_backlog_mutex, then notif_outq_t->mutex */
+static pthread_mutex_t notif_outq_backlog_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t notif_outq_backlog_cond = PTHREAD_COND_INITIALIZER;
+static glthread_t notif_outq_backlog_head;
+static pthread_once_t notif_outq_sender_once = PTHREAD_ONCE_INIT;
+static pthread_t notif_outq_sender;
+
+static notif_slab_t notif_outq_msg_slab =
+	NOTIF_SLAB_INITIALIZER("notif_outq_msg_t", sizeof(notif_outq_msg_t));
+
+/* Queues a batch holds, each once per hold taken. Workers of the fan
+ * out pool add to the batch of the publisher they deliver for */
+struct notif_outq_batch_{
+
+	uint64_t id;
+	uint32_t nesting;
+	pthread_mutex_t mutex;
+	uint32_t n_outqs;
+	uint32_t size;
+	notif_outq_t **outqs;
+};
+
+static uint64_t notif_outq_batch_next_id = 1;
+static __thread notif_outq_batch_t notif_outq_batch = {
+	.mutex = PTHREAD_MUTEX_INITIALIZER
+};
+
+#define NOTIF_OUTQ_IS_EMPTY(outq_ptr)                               \
+	(!(outq_ptr)->wire_msg &&                                       \
+	 !(outq_ptr)->lanes[NOTIF_OUTQ_LANE_HIGH].head &&               \
+	 !(outq_ptr)->lanes[NOTIF_OUTQ_LANE_LOW].head)
+
+void
+notif_outq_set_default_policy(notif_outq_policy_t policy,
+		uint32_t max_depth){
+
+	if(!max_depth) return;
+	notif_outq_default_policy = policy;
+	notif_outq_default_max_depth = max_depth;
+}
+
+notif_outq_t *
+notif_outq_create(int sock_fd,
+		uint8_t protocol_no,
+		uint32_t ip_addr,
+		uint16_t port_no){
+
+	notif_outq_t *outq = calloc(1, sizeof(notif_outq_t));
+
+	pthread_mutex_init(&outq->mutex, NULL);
+	outq->policy = notif_outq_default_policy;
+	outq->max_depth = notif_outq_default_max_depth;
+	outq->sock_fd = sock_fd;
+	outq->protocol_no = protocol_no;
+
+	/* Addressed as send_udp_msg() does */
+	outq->dest.sin_family = AF_INET;
+	outq->dest.sin_port = port_no;
+	outq->dest.sin_addr.s_addr = htonl(ip_addr);
+
+	init_glthread(&outq->backlog_glue);
+	return outq;
+}
+
+notif_outq_body_t *
+notif_outq_body_alloc(uint32_t size){
+
+	notif_outq_body_t *body;
+
+	body = malloc(sizeof(notif_outq_body_t) + size);
+	body->ref_count = 1;
+	body->size = size;
+	return body;
+}
+
+void
+notif_outq_body_hold(notif_outq_body_t *body){
+
+	__atomic_add_fetch(&body->ref_count, 1, __ATOMIC_RELAXED);
+}
+
+void
+notif_outq_body_release(notif_outq_body_t *body){
+
+	if(__atomic_sub_fetch(&body->ref_count, 1, __ATOMIC_ACQ_REL)) return;
+	free(body);
+}
+
+static void
+notif_outq_free_msg(notif_outq_msg_t *outq_msg){
+
+	free(outq_msg->msg);
+	if(outq_msg->body) notif_outq_body_release(outq_msg->body);
+	free(outq_msg->key);
+	notif_slab_free(&notif_outq_msg_slab, outq_msg);
+}
+
+static void
+notif_outq_lane_append(notif_outq_lane_t *lane, notif_outq_msg_t *outq_msg){
+
+	outq_msg->next = NULL;
+	if(lane->tail){
+		lane->tail->next = outq_msg;
+	}
+	else {
+		lane->head = outq_msg;
+	}
+	lane->tail = outq_msg;
+}
+
+static notif_outq_msg_t *
+notif_outq_lane_pop(notif_outq_lane_t *lane){
+
+	notif_outq_msg_t *outq_msg = lane->head;
+
+	lane->head = outq_msg->next;
+	if(!lane->head) lane->tail = NULL;
+	return outq_msg;
+}
+
+static void
+notif_outq_purge(notif_outq_t *outq){
+
+	uint32_t lane;
+	notif_outq_msg_t *outq_msg;
+
+	for(lane = 0; lane < NOTIF_OUTQ_N_LANES; lane++){
+		while(outq->lanes[lane].head){
+			outq_msg = notif_outq_lane_pop(&outq->lanes[lane]);
+			notif_outq_free_msg(outq_msg);
+		}
+	}
+
+	while(outq->wire_msg){
+		outq_msg = outq->wire_msg;
+		outq->wire_msg = outq_msg->next;
+		notif_outq_free_msg(outq_msg);
+	}
+	outq->wire_offset = 0;
+	outq->depth = 0;
+}
+
+void
+notif_outq_destroy(notif_outq_t *outq){
+
+	if(!outq) return;
+
+	pthread_mutex_lock(&notif_outq_backlog_mutex);
+	if(outq->on_backlog){
+		remove_glthread(&outq->backlog_glue);
+		outq->on_backlog = false;
+	}
+	pthread_mutex_unlock(&notif_outq_backlog_mutex);
+
+	notif_outq_purge(outq);
+	pthread_mutex_destroy(&outq->mutex);
+	free(outq);
+}
+
+bool
+notif_outq_set_policy(notif_outq_t *outq,
+		notif_outq_policy_t policy,
+		uint32_t max_depth){
+
+	if(!max_depth){
+		printf("%s() : Error : Invalid queue depth %u\n",
+				__FUNCTION__, max_depth);
+		return false;
+	}
+
+	pthread_mutex_lock(&outq->mutex);
+	outq->policy = policy;
+	outq->max_depth = max_depth;
+	pthread_mutex_unlock(&outq->mutex);
+	return true;
+}
+
+void
+notif_outq_set_wide_tlv(notif_outq_t *outq, bool wide_tlv){
+
+	pthread_mutex_lock(&outq->mutex);
+	outq->wide_tlv = wide_tlv;
+	pthread_mutex_unlock(&outq->mutex);
+}
+
+bool
+notif_outq_drop_too_wide(notif_outq_t *outq){
+
+	bool first;
+
+	pthread_mutex_lock(&outq->mutex);
+	outq->n_dropped++;
+	first = !outq->narrow_drop_seen;
+	outq->narrow_drop_seen = true;
+	pthread_mutex_unlock(&outq->mutex);
+	return first;
+}
+
+/* The socket is the publisher's, it is shut down rather than closed.
+ * For TCP the server side then sees the connection go and cleans up
+ * as for any other disconnect. Called with outq->mutex held */
+static void
+notif_outq_disconnect(notif_outq_t *outq){
+
+	outq->n_dropped += outq->depth;
+	notif_outq_purge(outq);
+	outq->disconnected = true;
+
+	if(outq->protocol_no == IPPROTO_TCP && outq->sock_fd > 0){
+		shutdown(outq->sock_fd, SHUT_RDWR);
+	}
+}
+
+/* NOTIF_C_FRAME_TLV, the record count */
+#define NOTIF_OUTQ_FRAME_HDR_SIZE	(TLV_OVERHEAD_SIZE + sizeof(uint32_t))
+
+#define NOTIF_OUTQ_MSG_WIRE_SIZE(outq_msg_ptr)                      \
+	((outq_msg_ptr)->msg_size +                                     \
+	 ((outq_msg_ptr)->body ? (outq_msg_ptr)->body->size : 0))
+
+/* Appends what of base is past *offset to iov */
+static int
+notif_outq_add_iov(struct iovec *iov,
+		int n_iov,
+		char *base,
+		uint32_t len,
+		uint32_t *offset){
+
+	if(*offset >= len){
+		*offset -= len;
+		return n_iov;
+	}
+	iov[n_iov].iov_base = base + *offset;
+	iov[n_iov].iov_len = len - *offset;
+	*offset = 0;
+	return n_iov + 1;
+}
+
+/* Writes the wire messages from wire_offset on, gathered in one
+ * call, bodies are never copied */
+static int
+notif_outq_write(notif_outq_t *outq){
+
+	int n_iov = 0;
+	struct iovec iov[1 + 3 * NOTIF_OUTQ_FRAME_MAX_MSGS];
+	struct msghdr msg_hdr;
+	notif_outq_msg_t *outq_msg;
+	uint32_t offset = outq->wire_offset;
+
+	n_iov = notif_outq_add_iov(iov, n_iov,
+			outq->wire_hdr, outq->wire_hdr_size, &offset);
+
+	for(outq_msg = outq->wire_msg; outq_msg; outq_msg = outq_msg->next){
+
+		n_iov = notif_outq_add_iov(iov, n_iov,
+				outq_msg->rec_hdr, outq_msg->rec_hdr_size, &offset);
+		n_iov = notif_outq_add_iov(iov, n_iov,
+				outq_msg->msg, outq_msg->msg_size, &offset);
+		if(outq_msg->body){
+			n_iov = notif_outq_add_iov(iov, n_iov,
+					outq_msg->body->data, outq_msg->body->size, &offset);
+		}
+	}
+
+	memset(&msg_hdr, 0, sizeof(msg_hdr));
+	msg_hdr.msg_iov = iov;
+	msg_hdr.msg_iovlen = n_iov;
+
+	if(outq->protocol_no == IPPROTO_TCP){
+		return sendmsg(outq->sock_fd, &msg_hdr, MSG_DONTWAIT | MSG_NOSIGNAL);
+	}
+
+	msg_hdr.msg_name = &outq->dest;
+	msg_hdr.msg_namelen = sizeof(outq->dest);
+	return sendmsg(outq->sock_fd, &msg_hdr, MSG_DONTWAIT);
+}
+
+/* High lane first, but no more than NOTIF_OUTQ_HIGH_BURST messages
+ * in a row while the low lane waits. Called with outq->mutex held */
+static notif_outq_lane_t *
+notif_outq_next_lane(notif_outq_t *outq){
+
+	notif_outq_lane_t *high_lane = &outq->lanes[NOTIF_OUTQ_LANE_HIGH];
+	notif_outq_lane_t *low_lane = &outq->lanes[NOTIF_OUTQ_LANE_LOW];
+
+	if(high_lane->head &&
+		(!low_lane->head || outq->n_high_in_row < NOTIF_OUTQ_HIGH_BURST)){
+		return high_lane;
+	}
+	return low_lane->head ? low_lane : NULL;
+}
+
+static notif_outq_msg_t *
+notif_outq_next_msg(notif_outq_t *outq){
+
+	notif_outq_lane_t *lane = notif_outq_next_lane(outq);
+
+	if(lane == &outq->lanes[NOTIF_OUTQ_LANE_HIGH]){
+		outq->n_high_in_row++;
+	}
+	else {
+		outq->n_high_in_row = 0;
+	}
+	if(!lane) return NULL;
+	return notif_outq_lane_pop(lane);
+}
+
+/* Takes the next messages to write onto the wire. Whatever is queued
+ * behind the first message goes along, as long as the frame stays
+ * within NOTIF_OUTQ_FRAME_MAX_BYTES. A lone message is written as
+ * is. Called with outq->mutex held */
+static bool
+notif_outq_take_wire(notif_outq_t *outq){
+
+	char *frame_hdr;
+	uint32_t frame_size, rec_size, msg_len_prefix;
+	notif_outq_lane_t *lane;
+	notif_outq_msg_t *outq_msg, *last_outq_msg;
+
+	outq_msg = notif_outq_next_msg(outq);
+	if(!outq_msg) return false;
+
+	outq->wire_msg = last_outq_msg = outq_msg;
+	outq->wire_n_msgs = 1;
+	outq->wire_offset = 0;
+	frame_size = NOTIF_OUTQ_FRAME_HDR_SIZE +
+		TLV_ENCODED_SIZE(NOTIF_OUTQ_MSG_WIRE_SIZE(outq_msg));
+
+	while(outq->wire_n_msgs < NOTIF_OUTQ_FRAME_MAX_MSGS &&
+			(lane = notif_outq_next_lane(outq))){
+
+		/* Else the records go out one by one, a lone message
+		 * has no record header */
+		if(!outq->wide_tlv &&
+			(TLV_IS_WIDE(NOTIF_OUTQ_MSG_WIRE_SIZE(outq_msg)) ||
+			 TLV_IS_WIDE(NOTIF_OUTQ_MSG_WIRE_SIZE(lane->head)))){
+			break;
+		}
+
+		rec_size = TLV_ENCODED_SIZE(NOTIF_OUTQ_MSG_WIRE_SIZE(lane->head));
+		if(frame_size + rec_size > NOTIF_OUTQ_FRAME_MAX_BYTES) break;
+
+		frame_size += rec_size;
+		last_outq_msg->next = notif_outq_next_msg(outq);
+		last_outq_msg = last_outq_msg->next;
+		outq->wire_n_msgs++;
+	}
+	last_outq_msg->next = NULL;
+
+	/* Stream peers split messages along a length prefix */
+	frame_hdr = outq->wire_hdr;
+	if(outq->protocol_no == IPPROTO_TCP) frame_hdr += TCP_MSG_LEN_PREFIX_SIZE;
+
+	if(outq->wire_n_msgs == 1){
+		outq_msg->rec_hdr_size = 0;
+		frame_size = NOTIF_OUTQ_MSG_WIRE_SIZE(outq_msg);
+	}
+	else {
+		frame_hdr = tlv_buffer_insert_tlv(frame_hdr,
+				NOTIF_C_FRAME_TLV, sizeof(uint32_t),
+				(char *)&outq->wire_n_msgs);
+
+		for(; outq_msg; outq_msg = outq_msg->next){
+			outq_msg->rec_hdr_size = tlv_buffer_insert_tlv_header(
+					outq_msg->rec_hdr, NOTIF_C_FRAME_RECORD_TLV,
+					NOTIF_OUTQ_MSG_WIRE_SIZE(outq_msg)) - outq_msg->rec_hdr;
+		}
+		outq->n_frames++;
+	}
+
+	outq->wire_hdr_size = frame_hdr - outq->wire_hdr;
+	outq->wire_size = frame_size;
+
+	if(outq->protocol_no == IPPROTO_TCP){
+		msg_len_prefix = htonl(frame_size);
+		memcpy(outq->wire_hdr, &msg_len_prefix, TCP_MSG_LEN_PREFIX_SIZE);
+		outq->wire_size += TCP_MSG_LEN_PREFIX_SIZE;
+	}
+	return true;
+}
+
+/* Frees the wire messages, counted as sent unless dropped */
+static void
+notif_outq_wire_done(notif_outq_t *outq, bool dropped){
+
+	notif_outq_msg_t *outq_msg;
+
+	if(dropped){
+		outq->n_dropped += outq->wire_n_msgs;
+	}
+	else {
+		outq->n_sent += outq->wire_n_msgs;
+	}
+
+	while(outq->wire_msg){
+		outq_msg = outq->wire_msg;
+		outq->wire_msg = outq_msg->next;
+		notif_outq_free_msg(outq_msg);
+	}
+	outq->depth -= outq->wire_n_msgs;
+	outq->wire_n_msgs = 0;
+	outq->wire_offset = 0;
+}
+
+/* Writes queued messages until the socket would block.
+ * Called with outq->mutex held */
+static void
+notif_outq_flush(notif_outq_t *outq){
+
+	int rc;
+
+	outq->held_msgs = 0;
+	outq->held_bytes = 0;
+
+	while(1){
+
+		if(!outq->wire_msg && !notif_outq_take_wire(outq)) return;
+
+		rc = notif_outq_write(outq);
+
+		if(rc < 0){
+
+			if(errno == EINTR) continue;
+			if(errno == EAGAIN || errno == EWOULDBLOCK) return;
+
+			/* A TCP peer which is gone is not coming back, a UDP
+			 * error concerns this datagram only */
+			if(outq->protocol_no == IPPROTO_TCP){
+				printf("%s() : Error : send failed on fd %d, errno = %d\n",
+						__FUNCTION__, outq->sock_fd, errno);
+				notif_outq_disconnect(outq);
+				return;
+			}
+			notif_outq_wire_done(outq, true);
+			continue;
+		}
+
+		outq->wire_offset += rc;
+		if(outq->wire_offset < outq->wire_size) continue;
+
+		notif_outq_wire_done(outq, false);
+	}
+}
+
+/* A high priority message must not overtake what was queued before
+ * for the same key, say a DELETE the CREATE it withdraws. Such low
+ * lane messages move ahead of it, in order. Hash collisions only
+ * move a message earlier than needed */
+static void
+notif_outq_promote(notif_outq_t *outq, uint32_t key_hash){
+
+	notif_outq_msg_t *outq_msg, **outq_msg_slot;
+	notif_outq_lane_t *low_lane = &outq->lanes[NOTIF_OUTQ_LANE_LOW];
+
+	low_lane->tail = NULL;
+
+	for(outq_msg_slot = &low_lane->head; (outq_msg = *outq_msg_slot); ){
+
+		if(!outq_msg->key_size || outq_msg->key_hash != key_hash){
+			low_lane->tail = outq_msg;
+			outq_msg_slot = &outq_msg->next;
+			continue;
+		}
+		*outq_msg_slot = outq_msg->next;
+		notif_outq_lane_append(&outq->lanes[NOTIF_OUTQ_LANE_HIGH], outq_msg);
+	}
+}
+
+/* Replaces the message queued in the lane for the same key, if any */
+static bool
+notif_outq_conflate(notif_outq_t *outq,
+		notif_outq_lane_t *lane,
+		notif_outq_msg_t *new_outq_msg){
+
+	char *stale_msg;
+	notif_outq_body_t *stale_body;
+	notif_outq_msg_t *outq_msg;
+
+	for(outq_msg = lane->head; outq_msg; outq_msg = outq_msg->next){
+
+		if(!outq_msg->key ||
+			outq_msg->key_hash != new_outq_msg->key_hash ||
+			outq_msg->key_size != new_outq_msg->key_size ||
+			memcmp(outq_msg->key, new_outq_msg->key, outq_msg->key_size)){
+			continue;
+		}
+
+		/* The stale buffers go with new_outq_msg */
+		stale_msg = outq_msg->msg;
+		stale_body = outq_msg->body;
+		outq_msg->msg = new_outq_msg->msg;
+		outq_msg->msg_size = new_outq_msg->msg_size;
+		outq_msg->body = new_outq_msg->body;
+		new_outq_msg->msg = stale_msg;
+		new_outq_msg->body = stale_body;
+		notif_outq_free_msg(new_outq_msg);
+		outq->n_conflated++;
+		return true;
+	}
+	return false;
+}
+
+/* Makes room for one more message, false if the message
+ * must be dropped instead. Called with outq->mutex held */
+static bool
+notif_outq_make_room(notif_outq_t *outq){
+
+	notif_outq_lane_t *lane;
+
+	if(outq->depth < outq->max_depth) return true;
+
+	if(outq->policy == NOTIF_OUTQ_DISCONNECT){
+		printf("%s() : Error : fd %d backlog of %u messages, disconnecting\n",
+				__FUNCTION__, outq->sock_fd, outq->depth);
+		notif_outq_disconnect(outq);
+		return false;
+	}
+
+	/* Oldest low priority message goes first */
+	lane = &outq->lanes[NOTIF_OUTQ_LANE_LOW];
+	if(!lane->head) lane = &outq->lanes[NOTIF_OUTQ_LANE_HIGH];
+	if(!lane->head) return false;
+
+	notif_outq_free_msg(notif_outq_lane_pop(lane));
+	outq->depth--;
+	outq->n_dropped++;
+	return true;
+}
+
+static void *
+notif_outq_sender_fn(void *arg){
+
+	uint32_t n_fds;
+	glthread_t *curr;
+	notif_outq_t *outq;
+	struct pollfd poll_fds[NOTIF_OUTQ_MAX_POLL_FDS];
+
+	(void)arg;
+
+	while(1){
+
+		pthread_mutex_lock(&notif_outq_backlog_mutex);
+
+		while(IS_GLTHREAD_LIST_EMPTY(&notif_outq_backlog_head)){
+			pthread_cond_wait(&notif_outq_backlog_cond,
+					&notif_outq_backlog_mutex);
+		}
+
+		n_fds = 0;
+		ITERATE_GLTHREAD_BEGIN(&notif_outq_backlog_head, curr){
+
+			if(n_fds == NOTIF_OUTQ_MAX_POLL_FDS) break;
+			outq = glthread_glue_to_notif_outq(curr);
+			poll_fds[n_fds].fd = outq->sock_fd;
+			poll_fds[n_fds].events = POLLOUT;
+			poll_fds[n_fds].revents = 0;
+			n_fds++;
+		} ITERATE_GLTHREAD_END(&notif_outq_backlog_head, curr);
+
+		pthread_mutex_unlock(&notif_outq_backlog_mutex);
+
+		poll(poll_fds, n_fds, NOTIF_OUTQ_POLL_INTERVAL_MS);
+
+		/* Flushing a queue whose socket is still full costs one
+		 * failed send, simpler than mapping poll_fds back */
+		pthread_mutex_lock(&notif_outq_backlog_mutex);
+
+		ITERATE_GLTHREAD_BEGIN(&notif_outq_backlog_head, curr){
+
+			outq = glthread_glue_to_notif_outq(curr);
+
+			pthread_mutex_lock(&outq->mutex);
+			notif_outq_flush(outq);
+			if(NOTIF_OUTQ_IS_EMPTY(outq)){
+				remove_glthread(&outq->backlog_glue);
+				outq->on_backlog = false;
+			}
+			pthread_mutex_unlock(&outq->mutex);
+		} ITERATE_GLTHREAD_END(&notif_outq_backlog_head, curr);
+
+		pthread_mutex_unlock(&notif_outq_backlog_mutex);
+	}
+	return NULL;
+}
+
+static void
+notif_outq_start_sender(void){
+
+	init_glthread(&notif_outq_backlog_head);
+	pthread_create(&notif_outq_sender, NULL, notif_outq_sender_fn, NULL);
+	pthread_detach(notif_outq_sender);
+}
+
+static void
+notif_outq_add_to_backlog(notif_outq_t *outq){
+
+	pthread_once(&notif_outq_sender_once, notif_outq_start_sender);
+
+	pthread_mutex_lock(&notif_outq_backlog_mutex);
+	if(!outq->on_backlog){
+		glthread_add_next(&notif_outq_backlog_head, &outq->backlog_glue);
+		outq->on_backlog = true;
+		pthread_cond_signal(&notif_outq_backlog_cond);
+	}
+	pthread_mutex_unlock(&notif_outq_backlog_mutex);
+}
+
+/* Called with outq->mutex held */
+static void
+notif_outq_batch_hold(notif_outq_batch_t *batch, notif_outq_t *outq){
+
+	/* Queue may be held twice by the same batch when batches of
+	 * several threads alternate on it, and is released as often */
+	if(outq->hold_batch_id == batch->id) return;
+
+	outq->hold_batch_id = batch->id;
+	outq->n_holds++;
+
+	pthread_mutex_lock(&batch->mutex);
+	if(batch->n_outqs == batch->size){
+		batch->size = batch->size ? batch->size * 2 : 16;
+		batch->outqs = realloc(batch->outqs,
+				batch->size * sizeof(notif_outq_t *));
+	}
+	batch->outqs[batch->n_outqs++] = outq;
+	pthread_mutex_unlock(&batch->mutex);
+}
+
+void
+notif_outq_batch_begin(void){
+
+	if(notif_outq_batch.nesting++) return;
+
+	notif_outq_batch.id = __atomic_fetch_add(&notif_outq_batch_next_id, 1,
+			__ATOMIC_RELAXED);
+}
+
+void
+notif_outq_batch_end(void){
+
+	uint32_t i;
+	bool backlogged;
+	notif_outq_t *outq;
+	notif_outq_batch_t *batch = &notif_outq_batch;
+
+	assert(batch->nesting);
+
+	if(--batch->nesting) return;
+
+	/* Whoever sent on behalf of the batch is done */
+	for(i = 0; i < batch->n_outqs; i++){
+
+		outq = batch->outqs[i];
+
+		pthread_mutex_lock(&outq->mutex);
+		if(outq->hold_batch_id == batch->id) outq->hold_batch_id = 0;
+		if(--outq->n_holds || NOTIF_OUTQ_IS_EMPTY(outq)){
+			pthread_mutex_unlock(&outq->mutex);
+			continue;
+		}
+		notif_outq_flush(outq);
+		backlogged = !NOTIF_OUTQ_IS_EMPTY(outq);
+		pthread_mutex_unlock(&outq->mutex);
+
+		if(backlogged) notif_outq_add_to_backlog(outq);
+	}
+	batch->n_outqs = 0;
+}
+
+notif_outq_batch_t *
+notif_outq_batch_current(void){
+
+	return notif_outq_batch.nesting ? &notif_outq_batch : NULL;
+}
+
+void
+notif_outq_send(notif_outq_t *outq,
+		char *msg,
+		uint32_t msg_size,
+		notif_outq_body_t *body,
+		void *key,
+		uint32_t key_size,
+		bool high_prio,
+		notif_outq_batch_t *batch){
+
+	bool was_empty, backlogged;
+	uint32_t rec_size;
+	notif_outq_lane_t *lane;
+	notif_outq_msg_t *outq_msg;
+
+	pthread_mutex_lock(&outq->mutex);
+
+	if(outq->disconnected || outq->sock_fd <= 0){
+		outq->n_dropped++;
+		pthread_mutex_unlock(&outq->mutex);
+		free(msg);
+		if(body) notif_outq_body_release(body);
+		return;
+	}
+
+	outq_msg = notif_slab_alloc(&notif_outq_msg_slab);
+	outq_msg->msg = msg;
+	outq_msg->msg_size = msg_size;
+	outq_msg->body = body;
+
+	if(key && key_size){
+		outq_msg->key_size = key_size;
+		outq_msg->key_hash = notif_hash_bytes(key, key_size, NOTIF_HASH_SEED);
+		/* The key itself is only needed to conflate by */
+		if(outq->policy == NOTIF_OUTQ_CONFLATE_BY_KEY){
+			outq_msg->key = malloc(key_size);
+			memcpy(outq_msg->key, key, key_size);
+		}
+	}
+
+	lane = &outq->lanes[high_prio ? NOTIF_OUTQ_LANE_HIGH : NOTIF_OUTQ_LANE_LOW];
+
+	if(high_prio && outq_msg->key_size){
+		notif_outq_promote(outq, outq_msg->key_hash);
+	}
+
+	/* Only ever looks at what the socket has not taken yet */
+	if(outq_msg->key && notif_outq_conflate(outq, lane, outq_msg)){
+		pthread_mutex_unlock(&outq->mutex);
+		return;
+	}
+
+	if(!notif_outq_make_room(outq)){
+		outq->n_dropped++;
+		pthread_mutex_unlock(&outq->mutex);
+		notif_outq_free_msg(outq_msg);
+		return;
+	}
+
+	if(batch) notif_outq_batch_hold(batch, outq);
+
+	if(outq->n_holds){
+
+		rec_size = TLV_ENCODED_SIZE(NOTIF_OUTQ_MSG_WIRE_SIZE(outq_msg));
+
+		/* What is held back fills a frame, it goes out ahead */
+		if(outq->held_msgs == NOTIF_OUTQ_FRAME_MAX_MSGS ||
+			NOTIF_OUTQ_FRAME_HDR_SIZE + outq->held_bytes + rec_size >
+				NOTIF_OUTQ_FRAME_MAX_BYTES){
+			notif_outq_flush(outq);
+		}
+		outq->held_msgs++;
+		outq->held_bytes += rec_size;
+	}
+
+	was_empty = NOTIF_OUTQ_IS_EMPTY(outq);
+
+	notif_outq_lane_append(lane, outq_msg);
+	outq->depth++;
+	if(outq->depth > outq->depth_hwm) outq->depth_hwm = outq->depth;
+
+	/* Else the sender thread has the queue in hand, or the
+	 * batches holding it write it out as they end */
+	if(was_empty && !outq->n_holds) notif_outq_flush(outq);
+
+	/* Held messages are not for the sender thread, only what
+	 * the socket did not take */
+	backlogged = outq->n_holds ? outq->wire_msg != NULL :
+		!NOTIF_OUTQ_IS_EMPTY(outq);
+
+	pthread_mutex_unlock(&outq->mutex);
+
+	if(backlogged) notif_outq_add_to_backlog(outq);
+}
+
+int
+notif_outq_dump(notif_outq_t *outq,
+		char *buffer,
+		uint32_t buffer_size){
+
+	int rc;
+
+	pthread_mutex_lock(&outq->mutex);
+	rc = snprintf(buffer, buffer_size,
+			"outq : %s depth %u/%u hwm %u sent %llu dropped %llu "
+			"conflated %llu frames %llu%s",
+			notif_outq_get_str_policy(outq->policy),
+			outq->depth, outq->max_depth, outq->depth_hwm,
+			(unsigned long long)outq->n_sent,
+			(unsigned long long)outq->n_dropped,
+			(unsigned long long)outq->n_conflated,
+			(unsigned long long)outq->n_frames,
+			outq->disconnected ? " DISCONNECTED" : "");
+	pthread_mutex_unlock(&outq->mutex);
+	return rc;
+}
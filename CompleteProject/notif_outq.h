@@ -0,0 +1,251 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  notif_outq.h
+ *
+ *    Description:  This file defines the bounded outbound queue through which Notification
+ *                  Chains writes to socket subscribers
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026 11:26:52 PM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Er. Abhishek Sagar, Juniper Networks (https://csepracticals.wixsite.com/csepracticals), sachinites@gmail.com
+ *        Company:  Juniper Networks
+ *
+ *        This file is part of the NotificationChains distribution (https://github.com/sachinites)
+ *        Copynext (c) 2019 Abhishek Sagar.
+ *        This program is free software: you can redistribute it and/or modify it under the terms of the GNU General
+ *        Public License as published by the Free Software Foundation, version 3.
+ *
+ *        This program is distributed in the hope that it will be useful, but
+ *        WITHOUT ANY WARRANTY; without even the implied warranty of
+ *        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *        General Public License for more details.
+ *
+ *        visit website : https://csepracticals.wixsite.com/csepracticals for more courses and projects
+ *
+ * =====================================================================================
+ */
+
+#ifndef __NOTIF_OUTQ_H__
+#define __NOTIF_OUTQ_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <netinet/in.h>
+#include "gluethread/glthread.h"
+
+#define NOTIF_OUTQ_DEFAULT_MAX_DEPTH	1024
+/* Longest a backlogged queue waits for the sender thread to
+ * look at it again */
+#define NOTIF_OUTQ_POLL_INTERVAL_MS		10
+#define NOTIF_OUTQ_MAX_POLL_FDS			256
+
+/* Messages of high priority publishes are written first, but one
+ * low lane message goes after this many high ones in a row */
+#define NOTIF_OUTQ_LANE_HIGH			0
+#define NOTIF_OUTQ_LANE_LOW				1
+#define NOTIF_OUTQ_N_LANES				2
+#define NOTIF_OUTQ_HIGH_BURST			16
+
+/* Messages queued behind the one being written go out with it in
+ * one frame, see notif_chain_for_each_notification(). A batch holds
+ * back the writes of the queues it sends to until it ends, or until
+ * a queue has a frame's worth */
+#define NOTIF_OUTQ_FRAME_MAX_MSGS		64
+#define NOTIF_OUTQ_FRAME_MAX_BYTES		16384
+
+/* How a queue takes in a publish. All but NOTIF_OUTQ_CONFLATE_BY_KEY
+ * only come into play once the queue is full */
+typedef enum{
+
+	/* Full queue drops its oldest message */
+	NOTIF_OUTQ_DROP_OLDEST,
+	/* A publish replaces in place the queued, not yet written,
+	 * message for the same key, full queue or not. Else, as
+	 * NOTIF_OUTQ_DROP_OLDEST */
+	NOTIF_OUTQ_CONFLATE_BY_KEY,
+	/* Subscriber is disconnected, and sent nothing more */
+	NOTIF_OUTQ_DISCONNECT
+} notif_outq_policy_t;
+
+static inline char *
+notif_outq_get_str_policy(notif_outq_policy_t policy){
+
+	switch(policy){
+		case NOTIF_OUTQ_DROP_OLDEST:
+			return "DROP_OLDEST";
+		case NOTIF_OUTQ_CONFLATE_BY_KEY:
+			return "CONFLATE_BY_KEY";
+		case NOTIF_OUTQ_DISCONNECT:
+			return "DISCONNECT";
+		default:
+			return "UNKNOWN";
+	}
+}
+
+/* Bytes which the messages of many subscribers end with, say the
+ * encoding of a publish, written out by reference by every queue */
+typedef struct notif_outq_body_{
+
+	uint32_t ref_count;
+	uint32_t size;
+	char data[];
+} notif_outq_body_t;
+
+/* On the wire, msg followed by body->data if body. Within a
+ * frame, preceded by rec_hdr */
+typedef struct notif_outq_msg_{
+
+	char *msg;
+	uint32_t msg_size;
+	notif_outq_body_t *body;
+	/* TLV header, at most TLV_WIDE_OVERHEAD_SIZE bytes */
+	char rec_hdr[5];
+	uint8_t rec_hdr_size;
+	/* Hash of the published key, valid if key_size. The key
+	 * itself is kept only to conflate by */
+	uint32_t key_hash;
+	uint32_t key_size;
+	void *key;
+	struct notif_outq_msg_ *next;
+} notif_outq_msg_t;
+
+/* FIFO of messages */
+typedef struct notif_outq_lane_{
+
+	notif_outq_msg_t *head;
+	notif_outq_msg_t *tail;
+} notif_outq_lane_t;
+
+/* Messages to one socket subscriber. Publishers write without
+ * blocking and leave whatever the socket does not take queued, a
+ * sender thread writes it out as the socket drains */
+typedef struct notif_outq_{
+
+	/* Protects everything below but backlog_glue and on_backlog */
+	pthread_mutex_t mutex;
+	notif_outq_policy_t policy;
+	uint32_t max_depth;
+	int sock_fd;
+	uint8_t protocol_no;
+	struct sockaddr_in dest;	/* UDP only */
+	notif_outq_lane_t lanes[NOTIF_OUTQ_N_LANES];
+	uint32_t n_high_in_row;
+	/* Messages being written, linked through next, framed behind
+	 * wire_hdr when more than one. For TCP, wire_hdr starts with the
+	 * length prefix. wire_offset bytes are sent. Out of the lanes,
+	 * they are neither dropped nor conflated */
+	notif_outq_msg_t *wire_msg;
+	uint32_t wire_n_msgs;
+	uint32_t wire_size;
+	uint32_t wire_offset;
+	char wire_hdr[12];
+	uint32_t wire_hdr_size;
+	/* Batches holding back the writes, and what they held back */
+	uint32_t n_holds;
+	uint64_t hold_batch_id;
+	uint32_t held_msgs;
+	uint32_t held_bytes;
+	/* Messages in the lanes and on the wire */
+	uint32_t depth;
+	uint32_t depth_hwm;
+	bool disconnected;
+	/* Peer decodes wide TLVs, else records framed together must
+	 * each fit a short TLV */
+	bool wide_tlv;
+	/* A notification was dropped as too wide for the peer */
+	bool narrow_drop_seen;
+	uint64_t n_sent;
+	uint64_t n_dropped;
+	uint64_t n_conflated;
+	uint64_t n_frames;
+	/* On the sender thread's list while messages are queued,
+	 * protected by the sender's lock */
+	bool on_backlog;
+	glthread_t backlog_glue;
+} notif_outq_t;
+GLTHREAD_TO_STRUCT(glthread_glue_to_notif_outq,
+					notif_outq_t, backlog_glue);
+
+typedef struct notif_outq_batch_ notif_outq_batch_t;
+
+/* Policy and depth of the queues created from now on */
+void
+notif_outq_set_default_policy(notif_outq_policy_t policy,
+                uint32_t max_depth);
+
+/* ip_addr and port_no are used by UDP only */
+notif_outq_t *
+notif_outq_create(int sock_fd,
+                uint8_t protocol_no,
+                uint32_t ip_addr,
+                uint16_t port_no);
+
+void
+notif_outq_destroy(notif_outq_t *outq);
+
+bool
+notif_outq_set_policy(notif_outq_t *outq,
+                notif_outq_policy_t policy,
+                uint32_t max_depth);
+
+void
+notif_outq_set_wide_tlv(notif_outq_t *outq, bool wide_tlv);
+
+/* Counts a notification not sent as the peer does not decode wide
+ * TLVs. Returns true for the first one only, for the caller to
+ * report it once */
+bool
+notif_outq_drop_too_wide(notif_outq_t *outq);
+
+/* Returns a body of size bytes, holding one reference */
+notif_outq_body_t *
+notif_outq_body_alloc(uint32_t size);
+
+void
+notif_outq_body_hold(notif_outq_body_t *body);
+
+/* Frees the body with the last reference */
+void
+notif_outq_body_release(notif_outq_body_t *body);
+
+/* Takes ownership of msg, a malloc'd buffer, and of one reference
+ * on body, which may be NULL. Never blocks.
+ * key, if not NULL, is what the message is conflated by, and
+ * keeps it behind earlier messages for the same key even when
+ * high_prio.
+ * batch, if not NULL, holds back the write until it ends */
+void
+notif_outq_send(notif_outq_t *outq,
+                char *msg,
+                uint32_t msg_size,
+                notif_outq_body_t *body,
+                void *key,
+                uint32_t key_size,
+                bool high_prio,
+                notif_outq_batch_t *batch);
+
+/* Batches are per thread, and nest. Queues a batch sends to must
+ * outlive it */
+void
+notif_outq_batch_begin(void);
+
+void
+notif_outq_batch_end(void);
+
+/* Batch open on the calling thread, NULL if none. Other threads may
+ * send on behalf of it until it ends */
+notif_outq_batch_t *
+notif_outq_batch_current(void);
+
+/* Formats the counters into buffer, returns the length */
+int
+notif_outq_dump(notif_outq_t *outq,
+                char *buffer,
+                uint32_t buffer_size);
+
+#endif /* __NOTIF_OUTQ_H__ */
@@ -0,0 +1,351 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  notif_post.c
+ *
+ *    Description:  This file implements the lock free multi producer publish queue placed in
+ *                  front of a Notification Chain
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026 11:57:40 PM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Er. Abhishek Sagar, Juniper Networks (https://csepracticals.wixsite.com/csepracticals), sachinites@gmail.com
+ *        Company:  Juniper Networks
+ *
+ *        This file is part of the NotificationChains distribution (https://github.com/sachinites)
+ *        Copynext (c) 2019 Abhishek Sagar.
+ *        This program is free software: you can redistribute it and/or modify it under the terms of the GNU General
+ *        Public License as published by the Free Software Foundation, version 3.
+ *
+ *        This program is distributed in the hope that it will be useful, but
+ *        WITHOUT ANY WARRANTY; without even the implied warranty of
+ *        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *        General Public License for more details.
+ *
+ *        visit website : https://csepracticals.wixsite.com/csepracticals for more courses and projects
+ *
+ * =====================================================================================
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <memory.h>
+#include <errno.h>
+#include <sched.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/eventfd.h>
+#include "notif.h"
+#include "notif_rcu.h"
+#include "notif_async.h"
+#include "notif_post.h"
+
+typedef struct notif_post_node_{
+
+	struct notif_post_node_ *next;
+	bool has_notif_chain_elem;
+	notif_chain_elem_t notif_chain_elem;
+} notif_post_node_t;
+
+/* Intrusive MPSC queue : producers swap themselves in at head and
+ * then link the previous head to them, the dispatcher consumes
+ * from tail. The queue always holds at least one node, stub when
+ * nothing else is there, so neither side ever sees it empty */
+struct notif_chain_post_queue_{
+
+	notif_chain_t *notif_chain;
+	/* Written by producers only */
+	notif_post_node_t *head __attribute__((aligned(64)));
+	/* Written by the dispatcher only */
+	notif_post_node_t *tail __attribute__((aligned(64)));
+	notif_post_node_t stub;
+	/* Set while the dispatcher is about to sleep on event_fd */
+	uint32_t consumer_waiting;
+	int event_fd;
+	bool stop;
+	pthread_t dispatcher;
+	uint64_t n_dispatched;
+	uint64_t n_batches;
+	uint32_t max_batch;
+};
+
+/* seq_cst exchange : pairs with consumer_waiting, see
+ * notif_post_dispatcher_wait() */
+static void
+notif_post_queue_push(notif_chain_post_queue_t *post_queue,
+		notif_post_node_t *node){
+
+	notif_post_node_t *prev;
+
+	node->next = NULL;
+	prev = __atomic_exchange_n(&post_queue->head, node, __ATOMIC_SEQ_CST);
+	/* Until this store, the dispatcher sees the queue end at prev */
+	__atomic_store_n(&prev->next, node, __ATOMIC_RELEASE);
+}
+
+/* Returns NULL if the queue is empty, or if a producer is half way
+ * through its push. Dispatcher only */
+static notif_post_node_t *
+notif_post_queue_pop(notif_chain_post_queue_t *post_queue){
+
+	notif_post_node_t *tail = post_queue->tail;
+	notif_post_node_t *next = __atomic_load_n(&tail->next, __ATOMIC_ACQUIRE);
+
+	if(tail == &post_queue->stub){
+		if(!next) return NULL;
+		post_queue->tail = next;
+		tail = next;
+		next = __atomic_load_n(&next->next, __ATOMIC_ACQUIRE);
+	}
+
+	if(next){
+		post_queue->tail = next;
+		return tail;
+	}
+
+	if(tail != __atomic_load_n(&post_queue->head, __ATOMIC_ACQUIRE)){
+		return NULL;
+	}
+
+	/* tail is the last node, stub goes behind it to be left
+	 * in the queue in its place */
+	notif_post_queue_push(post_queue, &post_queue->stub);
+
+	next = __atomic_load_n(&tail->next, __ATOMIC_ACQUIRE);
+	if(next){
+		post_queue->tail = next;
+		return tail;
+	}
+	return NULL;
+}
+
+static bool
+notif_post_queue_is_empty(notif_chain_post_queue_t *post_queue){
+
+	return __atomic_load_n(&post_queue->head, __ATOMIC_SEQ_CST) ==
+		post_queue->tail;
+}
+
+static void
+notif_post_node_free(notif_post_node_t *node){
+
+	if(node->has_notif_chain_elem){
+		notif_chain_elem_free_publish(&node->notif_chain_elem);
+	}
+	free(node);
+}
+
+static void
+notif_post_dispatcher_wait(notif_chain_post_queue_t *post_queue){
+
+	uint64_t event;
+
+	__atomic_store_n(&post_queue->consumer_waiting, 1, __ATOMIC_SEQ_CST);
+
+	if(!notif_post_queue_is_empty(post_queue) ||
+			__atomic_load_n(&post_queue->stop, __ATOMIC_SEQ_CST)){
+		__atomic_store_n(&post_queue->consumer_waiting, 0, __ATOMIC_RELAXED);
+		return;
+	}
+
+	while(read(post_queue->event_fd, &event, sizeof(event)) < 0 &&
+			errno == EINTR);
+}
+
+static void
+notif_post_wake_dispatcher(notif_chain_post_queue_t *post_queue){
+
+	uint64_t event = 1;
+
+	if(write(post_queue->event_fd, &event, sizeof(event)) < 0){
+		printf("%s() : Error : eventfd write failed, errno = %d\n",
+				__FUNCTION__, errno);
+	}
+}
+
+static void *
+notif_post_dispatcher_fn(void *arg){
+
+	uint32_t i, n_batch;
+	notif_post_node_t *node;
+	notif_post_node_t *batch[NOTIF_POST_BATCH_MAX];
+	notif_chain_post_queue_t *post_queue = (notif_chain_post_queue_t *)arg;
+
+	while(1){
+
+		for(n_batch = 0; n_batch < NOTIF_POST_BATCH_MAX; n_batch++){
+			node = notif_post_queue_pop(post_queue);
+			if(!node) break;
+			batch[n_batch] = node;
+		}
+
+		if(!n_batch){
+
+			if(!notif_post_queue_is_empty(post_queue)){
+				/* A producer is between its two steps */
+				sched_yield();
+				continue;
+			}
+
+			/* stop is set once no post can be in progress */
+			if(__atomic_load_n(&post_queue->stop, __ATOMIC_ACQUIRE)) break;
+
+			notif_post_dispatcher_wait(post_queue);
+			continue;
+		}
+
+		/* Socket subscribers get the batch framed together */
+		notif_chain_batch_begin();
+
+		for(i = 0; i < n_batch; i++){
+
+			node = batch[i];
+			notif_chain_invoke_async(post_queue->notif_chain,
+					node->has_notif_chain_elem ?
+						&node->notif_chain_elem : NULL);
+			notif_post_node_free(node);
+		}
+
+		notif_chain_batch_end();
+
+		/* Atomic for notif_post_dump() alone, only this thread writes */
+		__atomic_add_fetch(&post_queue->n_dispatched, n_batch, __ATOMIC_RELAXED);
+		__atomic_add_fetch(&post_queue->n_batches, 1, __ATOMIC_RELAXED);
+		if(n_batch > post_queue->max_batch){
+			__atomic_store_n(&post_queue->max_batch, n_batch, __ATOMIC_RELAXED);
+		}
+	}
+	return NULL;
+}
+
+bool
+notif_chain_enable_post_queue(notif_chain_t *notif_chain){
+
+	notif_chain_post_queue_t *post_queue;
+
+	if(posix_memalign((void **)&post_queue, 64,
+				sizeof(notif_chain_post_queue_t))){
+		return false;
+	}
+	memset(post_queue, 0, sizeof(notif_chain_post_queue_t));
+
+	post_queue->event_fd = eventfd(0, EFD_CLOEXEC);
+	if(post_queue->event_fd < 0){
+		printf("%s() : Error : eventfd failed, errno = %d\n",
+				__FUNCTION__, errno);
+		free(post_queue);
+		return false;
+	}
+
+	post_queue->notif_chain = notif_chain;
+	post_queue->head = &post_queue->stub;
+	post_queue->tail = &post_queue->stub;
+
+	pthread_mutex_lock(&notif_chain->mutex);
+
+	if(notif_chain->post_queue){
+		pthread_mutex_unlock(&notif_chain->mutex);
+		printf("%s() : Error : Notif Chain %s has a post queue already\n",
+				__FUNCTION__, notif_chain->name);
+		close(post_queue->event_fd);
+		free(post_queue);
+		return false;
+	}
+
+	pthread_create(&post_queue->dispatcher, NULL,
+			notif_post_dispatcher_fn, (void *)post_queue);
+
+	NOTIF_RCU_ASSIGN_POINTER(notif_chain->post_queue, post_queue);
+
+	pthread_mutex_unlock(&notif_chain->mutex);
+	return true;
+}
+
+void
+notif_chain_disable_post_queue(notif_chain_t *notif_chain){
+
+	notif_chain_post_queue_t *post_queue;
+
+	pthread_mutex_lock(&notif_chain->mutex);
+	post_queue = notif_chain->post_queue;
+	NOTIF_RCU_ASSIGN_POINTER(notif_chain->post_queue, NULL);
+	pthread_mutex_unlock(&notif_chain->mutex);
+
+	if(!post_queue) return;
+
+	/* Posters are in read side critical sections, once they are
+	 * all out nothing more can be queued */
+	notif_rcu_synchronize();
+
+	__atomic_store_n(&post_queue->stop, true, __ATOMIC_SEQ_CST);
+	notif_post_wake_dispatcher(post_queue);
+
+	pthread_join(post_queue->dispatcher, NULL);
+
+	close(post_queue->event_fd);
+	free(post_queue);
+}
+
+void
+notif_chain_post(notif_chain_t *notif_chain,
+		notif_chain_elem_t *notif_chain_elem){
+
+	notif_post_node_t *node;
+	notif_chain_post_queue_t *post_queue;
+
+	notif_rcu_read_lock();
+
+	post_queue = NOTIF_RCU_DEREFERENCE(notif_chain->post_queue);
+
+	if(!post_queue){
+		notif_rcu_read_unlock();
+		notif_chain_invoke_async(notif_chain, notif_chain_elem);
+		return;
+	}
+
+	/* Not from a notif_slab_t, whose mutex all posters would
+	 * contend on */
+	node = calloc(1, sizeof(notif_post_node_t));
+
+	if(notif_chain_elem){
+		node->has_notif_chain_elem = true;
+		notif_chain_elem_copy_publish(&node->notif_chain_elem,
+				notif_chain_elem);
+	}
+
+	notif_post_queue_push(post_queue, node);
+
+	/* Plain load first, the exchange only when the dispatcher
+	 * sleeps, which a busy one never does */
+	if(__atomic_load_n(&post_queue->consumer_waiting, __ATOMIC_SEQ_CST) &&
+		__atomic_exchange_n(&post_queue->consumer_waiting, 0,
+			__ATOMIC_SEQ_CST)){
+		notif_post_wake_dispatcher(post_queue);
+	}
+
+	notif_rcu_read_unlock();
+}
+
+void
+notif_post_dump(notif_chain_t *notif_chain){
+
+	notif_chain_post_queue_t *post_queue;
+
+	notif_rcu_read_lock();
+
+	post_queue = NOTIF_RCU_DEREFERENCE(notif_chain->post_queue);
+
+	if(post_queue){
+		printf("\tPost queue : dispatched : %llu batches : %llu "
+				"max batch : %u\n",
+				(unsigned long long)__atomic_load_n(
+					&post_queue->n_dispatched, __ATOMIC_RELAXED),
+				(unsigned long long)__atomic_load_n(
+					&post_queue->n_batches, __ATOMIC_RELAXED),
+				__atomic_load_n(&post_queue->max_batch, __ATOMIC_RELAXED));
+	}
+
+	notif_rcu_read_unlock();
+}
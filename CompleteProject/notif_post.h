@@ -0,0 +1,64 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  notif_post.h
+ *
+ *    Description:  This file defines the lock free multi producer publish queue placed in
+ *                  front of a Notification Chain
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026 11:57:40 PM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Er. Abhishek Sagar, Juniper Networks (https://csepracticals.wixsite.com/csepracticals), sachinites@gmail.com
+ *        Company:  Juniper Networks
+ *
+ *        This file is part of the NotificationChains distribution (https://github.com/sachinites)
+ *        Copynext (c) 2019 Abhishek Sagar.
+ *        This program is free software: you can redistribute it and/or modify it under the terms of the GNU General
+ *        Public License as published by the Free Software Foundation, version 3.
+ *
+ *        This program is distributed in the hope that it will be useful, but
+ *        WITHOUT ANY WARRANTY; without even the implied warranty of
+ *        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *        General Public License for more details.
+ *
+ *        visit website : https://csepracticals.wixsite.com/csepracticals for more courses and projects
+ *
+ * =====================================================================================
+ */
+
+#ifndef __NOTIF_POST_H__
+#define __NOTIF_POST_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "notif.h"
+
+/* Max no of publishes the dispatcher takes off the queue at once */
+#define NOTIF_POST_BATCH_MAX	64
+
+/* Starts the chain's dispatcher thread, which takes what
+ * notif_chain_post() queues in batches and hands it to
+ * notif_chain_invoke_async() */
+bool
+notif_chain_enable_post_queue(notif_chain_t *notif_chain);
+
+/* Waits for the posts in progress, delivers everything queued,
+ * then stops the dispatcher */
+void
+notif_chain_disable_post_queue(notif_chain_t *notif_chain);
+
+/* Copies the publish and queues it with a single atomic exchange,
+ * lock free whatever the no of posting threads. Publishes posted
+ * by one thread are delivered in the order posted. Falls back to
+ * notif_chain_invoke_async() if the chain has no post queue */
+void
+notif_chain_post(notif_chain_t *notif_chain,
+                notif_chain_elem_t *notif_chain_elem);
+
+void
+notif_post_dump(notif_chain_t *notif_chain);
+
+#endif /* __NOTIF_POST_H__ */
@@ -0,0 +1,220 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  notif_rcu.c
+ *
+ *    Description:  This file implements the epoch based read-copy-update scheme used by
+ *                  Notification Chains
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026 04:20:51 PM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Er. Abhishek Sagar, Juniper Networks (https://csepracticals.wixsite.com/csepracticals), sachinites@gmail.com
+ *        Company:  Juniper Networks
+ *
+ *        This file is part of the NotificationChains distribution (https://github.com/sachinites)
+ *        Copynext (c) 2019 Abhishek Sagar.
+ *        This program is free software: you can redistribute it and/or modify it under the terms of the GNU General
+ *        Public License as published by the Free Software Foundation, version 3.
+ *
+ *        This program is distributed in the hope that it will be useful, but
+ *        WITHOUT ANY WARRANTY; without even the implied warranty of
+ *        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *        General Public License for more details.
+ *
+ *        visit website : https://csepracticals.wixsite.com/csepracticals for more courses and projects
+ *
+ * =====================================================================================
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <assert.h>
+#include <pthread.h>
+#include <sched.h>
+#include "gluethread/glthread.h"
+#include "notif_slab.h"
+#include "notif_rcu.h"
+
+/* Every thread which ever entered a read side critical section
+ * owns one record. ctr is 0 while the thread is outside, else the
+ * grace period counter sampled on entry */
+typedef struct notif_rcu_reader_{
+
+	uint64_t ctr;
+	uint32_t nesting;
+	glthread_t glue;
+} notif_rcu_reader_t;
+GLTHREAD_TO_STRUCT(glthread_glue_to_notif_rcu_reader,
+					notif_rcu_reader_t, glue);
+
+typedef struct notif_rcu_retired_{
+
+	void *ptr;
+	notif_rcu_free_cb free_cb;
+	struct notif_rcu_retired_ *next;
+} notif_rcu_retired_t;
+
+static uint64_t notif_rcu_gp_ctr = 1;
+
+/* Protects the reader records, and serializes grace periods */
+static pthread_mutex_t notif_rcu_registry_mutex = PTHREAD_MUTEX_INITIALIZER;
+static glthread_t notif_rcu_reader_head;
+
+static pthread_mutex_t notif_rcu_retired_mutex = PTHREAD_MUTEX_INITIALIZER;
+static notif_rcu_retired_t *notif_rcu_retired_head;
+
+static notif_slab_t notif_rcu_retired_slab =
+	NOTIF_SLAB_INITIALIZER("notif_rcu_retired_t", sizeof(notif_rcu_retired_t));
+
+static __thread notif_rcu_reader_t *notif_rcu_reader;
+
+static pthread_once_t notif_rcu_key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t notif_rcu_key;
+
+static void
+notif_rcu_unregister_reader(void *arg){
+
+	notif_rcu_reader_t *reader = (notif_rcu_reader_t *)arg;
+
+	pthread_mutex_lock(&notif_rcu_registry_mutex);
+	remove_glthread(&reader->glue);
+	pthread_mutex_unlock(&notif_rcu_registry_mutex);
+	free(reader);
+}
+
+static void
+notif_rcu_create_key(void){
+
+	pthread_key_create(&notif_rcu_key, notif_rcu_unregister_reader);
+}
+
+static notif_rcu_reader_t *
+notif_rcu_register_reader(void){
+
+	notif_rcu_reader_t *reader = calloc(1, sizeof(notif_rcu_reader_t));
+
+	init_glthread(&reader->glue);
+
+	pthread_once(&notif_rcu_key_once, notif_rcu_create_key);
+	/* Record is dropped when the thread exits */
+	pthread_setspecific(notif_rcu_key, reader);
+
+	pthread_mutex_lock(&notif_rcu_registry_mutex);
+	glthread_add_next(&notif_rcu_reader_head, &reader->glue);
+	pthread_mutex_unlock(&notif_rcu_registry_mutex);
+
+	notif_rcu_reader = reader;
+	return reader;
+}
+
+void
+notif_rcu_read_lock(void){
+
+	notif_rcu_reader_t *reader = notif_rcu_reader;
+
+	if(!reader) reader = notif_rcu_register_reader();
+
+	if(reader->nesting++) return;
+
+	__atomic_store_n(&reader->ctr,
+		__atomic_load_n(&notif_rcu_gp_ctr, __ATOMIC_RELAXED),
+		__ATOMIC_RELAXED);
+	/* Pairs with the fence in notif_rcu_synchronize() : either the
+	 * writer sees ctr, or this reader sees the writer's unlink */
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+void
+notif_rcu_read_unlock(void){
+
+	notif_rcu_reader_t *reader = notif_rcu_reader;
+
+	assert(reader && reader->nesting);
+
+	if(--reader->nesting) return;
+
+	__atomic_store_n(&reader->ctr, 0, __ATOMIC_RELEASE);
+}
+
+bool
+notif_rcu_is_reader(void){
+
+	return notif_rcu_reader && notif_rcu_reader->nesting;
+}
+
+void
+notif_rcu_retire(void *ptr, notif_rcu_free_cb free_cb){
+
+	notif_rcu_retired_t *retired;
+
+	if(!ptr) return;
+
+	retired = notif_slab_alloc(&notif_rcu_retired_slab);
+	retired->ptr = ptr;
+	retired->free_cb = free_cb;
+
+	pthread_mutex_lock(&notif_rcu_retired_mutex);
+	retired->next = notif_rcu_retired_head;
+	notif_rcu_retired_head = retired;
+	pthread_mutex_unlock(&notif_rcu_retired_mutex);
+}
+
+void
+notif_rcu_synchronize(void){
+
+	glthread_t *curr;
+	uint64_t gp_ctr, reader_ctr;
+	notif_rcu_reader_t *reader;
+
+	assert(!notif_rcu_is_reader());
+
+	pthread_mutex_lock(&notif_rcu_registry_mutex);
+
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+	/* Readers entering from now on sample gp_ctr and can not
+	 * reach what was unlinked before */
+	gp_ctr = __atomic_add_fetch(&notif_rcu_gp_ctr, 1, __ATOMIC_SEQ_CST);
+
+	ITERATE_GLTHREAD_BEGIN(&notif_rcu_reader_head, curr){
+
+		reader = glthread_glue_to_notif_rcu_reader(curr);
+
+		for(;;){
+			reader_ctr = __atomic_load_n(&reader->ctr, __ATOMIC_ACQUIRE);
+			if(!reader_ctr || reader_ctr >= gp_ctr) break;
+			sched_yield();
+		}
+	} ITERATE_GLTHREAD_END(&notif_rcu_reader_head, curr);
+
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+	pthread_mutex_unlock(&notif_rcu_registry_mutex);
+}
+
+void
+notif_rcu_reclaim(void){
+
+	notif_rcu_retired_t *retired, *next_retired;
+
+	if(notif_rcu_is_reader()) return;
+
+	pthread_mutex_lock(&notif_rcu_retired_mutex);
+	retired = notif_rcu_retired_head;
+	notif_rcu_retired_head = NULL;
+	pthread_mutex_unlock(&notif_rcu_retired_mutex);
+
+	if(!retired) return;
+
+	notif_rcu_synchronize();
+
+	for(; retired; retired = next_retired){
+
+		next_retired = retired->next;
+		retired->free_cb(retired->ptr);
+		notif_slab_free(&notif_rcu_retired_slab, retired);
+	}
+}
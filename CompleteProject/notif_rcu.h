@@ -0,0 +1,87 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  notif_rcu.h
+ *
+ *    Description:  This file defines the epoch based read-copy-update scheme which lets
+ *                  Notification Chains publishers walk subscriptions without locks
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026 04:12:25 PM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Er. Abhishek Sagar, Juniper Networks (https://csepracticals.wixsite.com/csepracticals), sachinites@gmail.com
+ *        Company:  Juniper Networks
+ *
+ *        This file is part of the NotificationChains distribution (https://github.com/sachinites)
+ *        Copynext (c) 2019 Abhishek Sagar.
+ *        This program is free software: you can redistribute it and/or modify it under the terms of the GNU General
+ *        Public License as published by the Free Software Foundation, version 3.
+ *
+ *        This program is distributed in the hope that it will be useful, but
+ *        WITHOUT ANY WARRANTY; without even the implied warranty of
+ *        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *        General Public License for more details.
+ *
+ *        visit website : https://csepracticals.wixsite.com/csepracticals for more courses and projects
+ *
+ * =====================================================================================
+ */
+
+#ifndef __NOTIF_RCU_H__
+#define __NOTIF_RCU_H__
+
+#include <stdbool.h>
+
+/* Readers :
+ *   notif_rcu_read_lock();
+ *   p = NOTIF_RCU_DEREFERENCE(shared_ptr);
+ *   ... p stays valid till ...
+ *   notif_rcu_read_unlock();
+ *
+ * Writers (serialized among themselves by their own locks) :
+ *   NOTIF_RCU_ASSIGN_POINTER(shared_ptr, new_p) / unlink old_p;
+ *   notif_rcu_retire(old_p, free_fn);
+ *   ... drop writer locks ...
+ *   notif_rcu_reclaim();
+ * */
+
+/* Publish a fully initialized object to readers */
+#define NOTIF_RCU_ASSIGN_POINTER(ptr, val)	\
+	__atomic_store_n(&(ptr), (val), __ATOMIC_RELEASE)
+
+/* Read a pointer published by NOTIF_RCU_ASSIGN_POINTER */
+#define NOTIF_RCU_DEREFERENCE(ptr)			\
+	__atomic_load_n(&(ptr), __ATOMIC_ACQUIRE)
+
+typedef void (*notif_rcu_free_cb)(void *ptr);
+
+/* Read side critical sections nest and never block */
+void
+notif_rcu_read_lock(void);
+
+void
+notif_rcu_read_unlock(void);
+
+bool
+notif_rcu_is_reader(void);
+
+/* Object is freed by free_cb once the readers which could
+ * have seen it are done */
+void
+notif_rcu_retire(void *ptr, notif_rcu_free_cb free_cb);
+
+/* Waits until all read side critical sections in progress
+ * at the time of call have ended */
+void
+notif_rcu_synchronize(void);
+
+/* Frees the objects retired so far, waiting for a grace period.
+ * Must be called without holding writer locks. From within a read
+ * side critical section (eg. a subscriber callback) it does nothing,
+ * the objects are left to the next reclaim */
+void
+notif_rcu_reclaim(void);
+
+#endif /* __NOTIF_RCU_H__ */
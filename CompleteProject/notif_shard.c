@@ -0,0 +1,181 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  notif_shard.c
+ *
+ *    Description:  This file implements the key sharding of Notification Chains
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026 11:02:47 PM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Er. Abhishek Sagar, Juniper Networks (https://csepracticals.wixsite.com/csepracticals), sachinites@gmail.com
+ *        Company:  Juniper Networks
+ *
+ *        This file is part of the NotificationChains distribution (https://github.com/sachinites)
+ *        Copynext (c) 2019 Abhishek Sagar.
+ *        This program is free software: you can redistribute it and/or modify it under the terms of the GNU General
+ *        Public License as published by the Free Software Foundation, version 3.
+ *
+ *        This program is distributed in the hope that it will be useful, but
+ *        WITHOUT ANY WARRANTY; without even the implied warranty of
+ *        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *        General Public License for more details.
+ *
+ *        visit website : https://csepracticals.wixsite.com/csepracticals for more courses and projects
+ *
+ * =====================================================================================
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "notif.h"
+#include "notif_async.h"
+#include "notif_shard.h"
+
+/* Dispatcher shard_index delivers the publish to the subscribers of
+ * its shard, and to the wildcard subscribers of the sharded chain.
+ * A keyless publish reaches every dispatcher, each then takes only
+ * its share of the wildcard subscribers */
+static void
+notif_shard_deliver(notif_chain_t *notif_chain,
+		notif_chain_elem_t *notif_chain_elem,
+		uint32_t shard_index,
+		uint32_t n_shards){
+
+	notif_chain_shards_t *shards = notif_chain->shards;
+
+	notif_chain_invoke_partition(&shards->shards[shard_index],
+			notif_chain_elem, 0, 1);
+
+	if(notif_chain_elem && !NOTIF_CHAIN_ELEM_IS_WILDCARD(notif_chain_elem)){
+		notif_chain_invoke_partition(notif_chain, notif_chain_elem, 0, 1);
+	}
+	else {
+		notif_chain_invoke_partition(notif_chain, notif_chain_elem,
+				shard_index, n_shards);
+	}
+}
+
+static uint32_t
+notif_shard_index(notif_chain_shards_t *shards,
+		notif_chain_t *notif_chain,
+		void *app_key_data,
+		uint32_t app_key_data_size){
+
+	uint32_t key_hash;
+
+	key_hash = notif_chain->key_hash_cb(app_key_data, app_key_data_size);
+
+	/* Rehashed, the shard's own key_index buckets by the low bits
+	 * of key_hash, which would otherwise be the same in a shard */
+	return notif_hash_bytes(&key_hash, sizeof(key_hash),
+				NOTIF_HASH_SEED) % shards->n_shards;
+}
+
+bool
+notif_chain_enable_sharding(notif_chain_t *notif_chain,
+		uint32_t n_shards){
+
+	uint32_t i;
+	/* notif_chain_init_internals() truncates to NOTIF_NAME_SIZE */
+	char shard_name[NOTIF_NAME_SIZE + 16];
+	notif_chain_shards_t *shards;
+
+	if(!n_shards || n_shards > NOTIF_SHARD_MAX_SHARDS){
+		printf("%s() : Error : Invalid no of shards %u\n",
+				__FUNCTION__, n_shards);
+		return false;
+	}
+
+	pthread_mutex_lock(&notif_chain->mutex);
+
+	if(!IS_GLTHREAD_LIST_EMPTY(&notif_chain->notif_chain_elem_head)){
+		pthread_mutex_unlock(&notif_chain->mutex);
+		printf("%s() : Error : Notif Chain %s already has subscribers\n",
+				__FUNCTION__, notif_chain->name);
+		return false;
+	}
+
+	/* Key hash picks the shard, and a prefix can cover keys
+	 * of several shards. Without comp_cb a publish is for the
+	 * subscribers of every key */
+	if(!notif_chain->key_hash_cb || !notif_chain->comp_cb ||
+			notif_chain->key_prefix_cb || notif_chain->shards){
+		pthread_mutex_unlock(&notif_chain->mutex);
+		printf("%s() : Error : Notif Chain %s is not hash indexed, "
+				"or is sharded already\n",
+				__FUNCTION__, notif_chain->name);
+		return false;
+	}
+
+	shards = calloc(1, sizeof(notif_chain_shards_t));
+	shards->n_shards = n_shards;
+	shards->shards = calloc(n_shards, sizeof(notif_chain_t));
+
+	for(i = 0; i < n_shards; i++){
+
+		snprintf(shard_name, sizeof(shard_name), "%s/%u",
+				notif_chain->name, i);
+		notif_chain_init_internals(&shards->shards[i], shard_name,
+				notif_chain->comp_cb, notif_chain->print_cb,
+				notif_chain->key_hash_cb);
+	}
+
+	shards->dispatchers = notif_async_pool_create(n_shards,
+				notif_shard_deliver, true);
+
+	notif_chain->shards = shards;
+
+	pthread_mutex_unlock(&notif_chain->mutex);
+	return true;
+}
+
+notif_chain_t *
+notif_shard_lookup(notif_chain_t *notif_chain,
+		void *app_key_data,
+		uint32_t app_key_data_size){
+
+	notif_chain_shards_t *shards = notif_chain->shards;
+
+	return &shards->shards[notif_shard_index(shards, notif_chain,
+				app_key_data, app_key_data_size)];
+}
+
+void
+notif_shard_dispatch(notif_chain_t *notif_chain,
+		notif_chain_elem_t *notif_chain_elem){
+
+	uint32_t shard_index = NOTIF_ASYNC_ALL_WORKERS;
+	notif_chain_shards_t *shards = notif_chain->shards;
+
+	if(notif_chain_elem && !NOTIF_CHAIN_ELEM_IS_WILDCARD(notif_chain_elem)){
+		shard_index = notif_shard_index(shards, notif_chain,
+				notif_chain_elem->data.app_key_data,
+				notif_chain_elem->data.app_key_data_size);
+	}
+
+	notif_async_pool_enqueue(shards->dispatchers, notif_chain,
+			notif_chain_elem, shard_index);
+}
+
+void
+notif_shard_destroy(notif_chain_t *notif_chain){
+
+	uint32_t i;
+	notif_chain_shards_t *shards = notif_chain->shards;
+
+	if(!shards) return;
+
+	notif_async_pool_destroy(shards->dispatchers);
+
+	for(i = 0; i < shards->n_shards; i++){
+		notif_chain_delete(&shards->shards[i]);
+	}
+
+	notif_chain->shards = NULL;
+	free(shards->shards);
+	free(shards);
+}
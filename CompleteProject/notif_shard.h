@@ -0,0 +1,84 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  notif_shard.h
+ *
+ *    Description:  This file defines the key sharding of Notification Chains, which spreads
+ *                  the subscriptions of a chain over per core dispatcher threads
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026 11:02:47 PM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Er. Abhishek Sagar, Juniper Networks (https://csepracticals.wixsite.com/csepracticals), sachinites@gmail.com
+ *        Company:  Juniper Networks
+ *
+ *        This file is part of the NotificationChains distribution (https://github.com/sachinites)
+ *        Copynext (c) 2019 Abhishek Sagar.
+ *        This program is free software: you can redistribute it and/or modify it under the terms of the GNU General
+ *        Public License as published by the Free Software Foundation, version 3.
+ *
+ *        This program is distributed in the hope that it will be useful, but
+ *        WITHOUT ANY WARRANTY; without even the implied warranty of
+ *        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *        General Public License for more details.
+ *
+ *        visit website : https://csepracticals.wixsite.com/csepracticals for more courses and projects
+ *
+ * =====================================================================================
+ */
+
+#ifndef __NOTIF_SHARD_H__
+#define __NOTIF_SHARD_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "notif.h"
+#include "notif_async.h"
+
+#define NOTIF_SHARD_DEFAULT_SHARDS	4
+#define NOTIF_SHARD_MAX_SHARDS		NOTIF_ASYNC_MAX_WORKERS
+
+/* Keyed subscriptions of a sharded chain live in shards[key hash %
+ * n_shards], each shard a chain of its own with its own indexes.
+ * Wildcard subscriptions stay in the sharded chain itself */
+struct notif_chain_shards_{
+
+	uint32_t n_shards;
+	notif_chain_t *shards;
+	/* Worker i, pinned to a core, is the dispatcher of shards[i] */
+	notif_async_pool_t *dispatchers;
+};
+
+/* Splits the chain into n_shards shards. Must be invoked before any
+ * subscriber registers with the chain, which must be indexed by
+ * key_hash_cb, not by prefix, and have a comp_cb.
+ *
+ * Publishes to a sharded chain are always asynchronous : a keyed
+ * publish is queued to the dispatcher of its key's shard only, so
+ * publishes of different keys are delivered in parallel, while
+ * those of one key keep their order. A keyless publish is queued
+ * to every dispatcher. Wildcard subscribers are served by all the
+ * dispatchers, their callbacks may run concurrently */
+bool
+notif_chain_enable_sharding(notif_chain_t *notif_chain,
+                uint32_t n_shards);
+
+/* Shard holding the subscriptions to the key */
+notif_chain_t *
+notif_shard_lookup(notif_chain_t *notif_chain,
+                void *app_key_data,
+                uint32_t app_key_data_size);
+
+/* Queues the publish to the dispatchers, never conflated */
+void
+notif_shard_dispatch(notif_chain_t *notif_chain,
+                notif_chain_elem_t *notif_chain_elem);
+
+/* Delivers what is queued, stops the dispatchers and deletes the
+ * shards. Called by notif_chain_delete() */
+void
+notif_shard_destroy(notif_chain_t *notif_chain);
+
+#endif /* __NOTIF_SHARD_H__ */
@@ -0,0 +1,120 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  notif_slab.c
+ *
+ *    Description:  This file implements the fixed size object allocator used by Notification
+ *                  Chains
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026 02:48:33 PM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Er. Abhishek Sagar, Juniper Networks (https://csepracticals.wixsite.com/csepracticals), sachinites@gmail.com
+ *        Company:  Juniper Networks
+ *
+ *        This file is part of the NotificationChains distribution (https://github.com/sachinites)
+ *        Copynext (c) 2019 Abhishek Sagar.
+ *        This program is free software: you can redistribute it and/or modify it under the terms of the GNU General
+ *        Public License as published by the Free Software Foundation, version 3.
+ *
+ *        This program is distributed in the hope that it will be useful, but
+ *        WITHOUT ANY WARRANTY; without even the implied warranty of
+ *        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *        General Public License for more details.
+ *
+ *        visit website : https://csepracticals.wixsite.com/csepracticals for more courses and projects
+ *
+ * =====================================================================================
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <memory.h>
+#include <assert.h>
+#include "notif_slab.h"
+
+/* Slab layout : link to next slab followed by objs_per_slab objects */
+#define NOTIF_SLAB_HDR_SIZE		sizeof(void *)
+
+#define NOTIF_SLAB_NEXT(ptr)	(*(void **)(ptr))
+
+static void
+notif_slab_grow(notif_slab_t *slab){
+
+	uint32_t i;
+	char *obj;
+	void *new_slab;
+
+	new_slab = malloc(NOTIF_SLAB_HDR_SIZE +
+				(size_t)slab->obj_size * slab->objs_per_slab);
+	assert(new_slab);
+
+	NOTIF_SLAB_NEXT(new_slab) = slab->slab_list;
+	slab->slab_list = new_slab;
+	slab->n_slabs++;
+
+	/* Thread the objects on the free list, lowest address first out */
+	obj = (char *)new_slab + NOTIF_SLAB_HDR_SIZE +
+			(size_t)slab->obj_size * (slab->objs_per_slab - 1);
+
+	for(i = 0; i < slab->objs_per_slab; i++, obj -= slab->obj_size){
+		NOTIF_SLAB_NEXT(obj) = slab->free_list;
+		slab->free_list = obj;
+	}
+}
+
+void *
+notif_slab_alloc(notif_slab_t *slab){
+
+	void *obj;
+
+	pthread_mutex_lock(&slab->mutex);
+
+	if(!slab->free_list){
+		notif_slab_grow(slab);
+	}
+
+	obj = slab->free_list;
+	slab->free_list = NOTIF_SLAB_NEXT(obj);
+	slab->n_objs_in_use++;
+
+	pthread_mutex_unlock(&slab->mutex);
+
+	memset(obj, 0, slab->obj_size);
+	return obj;
+}
+
+void
+notif_slab_free(notif_slab_t *slab, void *obj){
+
+	if(!obj) return;
+
+	pthread_mutex_lock(&slab->mutex);
+
+	assert(slab->n_objs_in_use);
+	NOTIF_SLAB_NEXT(obj) = slab->free_list;
+	slab->free_list = obj;
+	slab->n_objs_in_use--;
+
+	pthread_mutex_unlock(&slab->mutex);
+}
+
+void
+notif_slab_dump(notif_slab_t *slab){
+
+	uint32_t n_objs_total;
+
+	pthread_mutex_lock(&slab->mutex);
+
+	n_objs_total = slab->n_slabs * slab->objs_per_slab;
+
+	printf("\t%-32s : obj size %-4u in use %-8u free %-8u slabs %u\n",
+			slab->name, slab->obj_size,
+			slab->n_objs_in_use,
+			n_objs_total - slab->n_objs_in_use,
+			slab->n_slabs);
+
+	pthread_mutex_unlock(&slab->mutex);
+}
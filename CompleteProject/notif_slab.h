@@ -0,0 +1,77 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  notif_slab.h
+ *
+ *    Description:  This file defines the fixed size object allocator used by Notification
+ *                  Chains for its subscription bookkeeping objects
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026 02:41:07 PM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Er. Abhishek Sagar, Juniper Networks (https://csepracticals.wixsite.com/csepracticals), sachinites@gmail.com
+ *        Company:  Juniper Networks
+ *
+ *        This file is part of the NotificationChains distribution (https://github.com/sachinites)
+ *        Copynext (c) 2019 Abhishek Sagar.
+ *        This program is free software: you can redistribute it and/or modify it under the terms of the GNU General
+ *        Public License as published by the Free Software Foundation, version 3.
+ *
+ *        This program is distributed in the hope that it will be useful, but
+ *        WITHOUT ANY WARRANTY; without even the implied warranty of
+ *        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *        General Public License for more details.
+ *
+ *        visit website : https://csepracticals.wixsite.com/csepracticals for more courses and projects
+ *
+ * =====================================================================================
+ */
+
+#ifndef __NOTIF_SLAB_H__
+#define __NOTIF_SLAB_H__
+
+#include <stdint.h>
+#include <pthread.h>
+
+/* No of objects carved out of one slab */
+#define NOTIF_SLAB_DEFAULT_OBJS_PER_SLAB	64
+
+/* Object size rounded up so that every object in a slab
+ * stays pointer aligned and can hold the free list link */
+#define NOTIF_SLAB_OBJ_SIZE(size)                                   \
+	((((size) + sizeof(void *) - 1) / sizeof(void *)) * sizeof(void *))
+
+/* Slabs are allocated from malloc as objects are demanded and are
+ * never given back, freed objects are recycled through free_list */
+typedef struct notif_slab_{
+
+	const char *name;
+	uint32_t obj_size;
+	uint32_t objs_per_slab;
+	/* Free objects, linked through their first word */
+	void *free_list;
+	/* Slabs, linked through their first word */
+	void *slab_list;
+	uint32_t n_slabs;
+	uint32_t n_objs_in_use;
+	pthread_mutex_t mutex;
+} notif_slab_t;
+
+#define NOTIF_SLAB_INITIALIZER(type_name, type_size)                \
+	{ (type_name), NOTIF_SLAB_OBJ_SIZE(type_size),                  \
+	  NOTIF_SLAB_DEFAULT_OBJS_PER_SLAB, NULL, NULL, 0, 0,           \
+	  PTHREAD_MUTEX_INITIALIZER }
+
+/* Returns zeroed object */
+void *
+notif_slab_alloc(notif_slab_t *slab);
+
+void
+notif_slab_free(notif_slab_t *slab, void *obj);
+
+void
+notif_slab_dump(notif_slab_t *slab);
+
+#endif /* __NOTIF_SLAB_H__ */
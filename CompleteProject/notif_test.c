@@ -0,0 +1,1125 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  notif_test.c
+ *
+ *    Description:  Tests of the Notification Chain library : key hash and prefix lookups,
+ *                  RCU reclamation, wide TLVs, TCP reassembly, outbound queue conflation,
+ *                  mailboxes, asynchronous delivery and its lanes, conflation window,
+ *                  shards, fan-out and post queue
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026 11:48:26 PM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Er. Abhishek Sagar, Juniper Networks (https://csepracticals.wixsite.com/csepracticals), sachinites@gmail.com
+ *        Company:  Juniper Networks
+ *
+ *        This file is part of the NotificationChains distribution (https://github.com/sachinites)
+ *        Copyright (c) 2019 Abhishek Sagar.
+ *        This program is free software: you can redistribute it and/or modify it under the terms of the GNU General
+ *        Public License as published by the Free Software Foundation, version 3.
+ *
+ *        This program is distributed in the hope that it will be useful, but
+ *        WITHOUT ANY WARRANTY; without even the implied warranty of
+ *        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *        General Public License for more details.
+ *
+ *        visit website : https://csepracticals.wixsite.com/csepracticals for more courses and projects
+ *
+ * =====================================================================================
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <memory.h>
+#include <assert.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "notif.h"
+#include "notif_rcu.h"
+#include "notif_mailbox.h"
+#include "notif_async.h"
+#include "notif_conflate.h"
+#include "notif_shard.h"
+#include "notif_fanout.h"
+#include "notif_post.h"
+#include "utils.h"
+#include "network_utils.h"
+
+static uint32_t hits[8];
+
+static void
+test_app_cb(notif_chain_elem_t *notif_chain_elem){
+
+	hits[notif_chain_elem->client_id]++;
+}
+
+static int
+test_int_comp_fn(void *key_data1, uint32_t key_data1_size,
+		void *key_data2, uint32_t key_data2_size){
+
+	if(key_data1_size != key_data2_size) return -1;
+	return memcmp(key_data1, key_data2, key_data1_size) ? -1 : 0;
+}
+
+static uint32_t
+test_int_hash_fn(void *key_data, uint32_t key_data_size){
+
+	return notif_hash_bytes(key_data, key_data_size, NOTIF_HASH_SEED);
+}
+
+/* Key of the prefix matched chain */
+typedef struct test_prefix_{
+
+	uint32_t addr;	/* host byte order */
+	uint8_t len;
+} test_prefix_t;
+
+static bool
+test_prefix_fn(void *key_data, uint32_t key_data_size,
+		uint32_t *prefix, uint8_t *prefix_len){
+
+	test_prefix_t *test_prefix = (test_prefix_t *)key_data;
+
+	if(key_data_size != sizeof(test_prefix_t)) return false;
+
+	*prefix_len = test_prefix->len;
+	*prefix = test_prefix->len ?
+		test_prefix->addr & (0xFFFFFFFFU << (32 - test_prefix->len)) : 0;
+	return true;
+}
+
+static void
+test_publish(notif_chain_t *notif_chain, void *key, uint32_t key_size){
+
+	notif_chain_elem_t notif_chain_elem;
+
+	memset(&notif_chain_elem, 0, sizeof(notif_chain_elem_t));
+	notif_chain_elem.notif_code = PUB_TO_SUBS_NOTIF_C_UPDATE;
+	notif_chain_elem.data.app_key_data = key;
+	notif_chain_elem.data.app_key_data_size = key_size;
+	notif_chain_invoke(notif_chain, &notif_chain_elem);
+}
+
+static void
+test_key_hash_lookup(){
+
+	int key;
+	static notif_chain_t notif_chain;
+
+	memset(hits, 0, sizeof(hits));
+	notif_chain_init(&notif_chain, "test_hash",
+			test_int_comp_fn, NULL, test_int_hash_fn);
+
+	key = 5;
+	assert(notif_chain_subscribe_by_callback("test_hash",
+				&key, sizeof(key), 1, test_app_cb));
+	key = 6;
+	assert(notif_chain_subscribe_by_callback("test_hash",
+				&key, sizeof(key), 2, test_app_cb));
+	assert(notif_chain_subscribe_by_callback("test_hash",
+				NULL, 0, 3, test_app_cb));
+
+	key = 5;
+	assert(notif_chain_lookup_notif_chain_element(&notif_chain,
+				1, &key, sizeof(key)));
+	assert(!notif_chain_lookup_notif_chain_element(&notif_chain,
+				2, &key, sizeof(key)));
+
+	test_publish(&notif_chain, &key, sizeof(key));
+	assert(hits[1] == 1 && hits[2] == 0 && hits[3] == 1);
+
+	key = 7;
+	test_publish(&notif_chain, &key, sizeof(key));
+	assert(hits[1] == 1 && hits[2] == 0 && hits[3] == 2);
+
+	notif_chain_delete(&notif_chain);
+	printf("%s() : PASS\n", __FUNCTION__);
+}
+
+/* Keys are not compared without comp_cb, an index changes nothing */
+static void
+test_key_hash_no_comp(){
+
+	int key;
+	static notif_chain_t notif_chain;
+
+	memset(hits, 0, sizeof(hits));
+	notif_chain_init(&notif_chain, "test_hash_no_comp",
+			NULL, NULL, test_int_hash_fn);
+
+	key = 5;
+	assert(notif_chain_subscribe_by_callback("test_hash_no_comp",
+				&key, sizeof(key), 1, test_app_cb));
+	key = 6;
+	assert(notif_chain_subscribe_by_callback("test_hash_no_comp",
+				&key, sizeof(key), 2, test_app_cb));
+
+	key = 7;
+	test_publish(&notif_chain, &key, sizeof(key));
+	assert(hits[1] == 1 && hits[2] == 1);
+
+	notif_chain_delete(&notif_chain);
+	printf("%s() : PASS\n", __FUNCTION__);
+}
+
+static void
+test_prefix_trie_lookup(){
+
+	test_prefix_t test_prefix;
+	static notif_chain_t notif_chain;
+
+	memset(hits, 0, sizeof(hits));
+	notif_chain_init(&notif_chain, "test_trie", NULL, NULL, NULL);
+	assert(notif_chain_enable_prefix_match(&notif_chain, test_prefix_fn));
+
+	memset(&test_prefix, 0, sizeof(test_prefix_t));
+
+	/* 10.1.0.0/16, 10.1.1.1/32, 0.0.0.0/0 and 20.0.0.0/8 */
+	test_prefix.addr = 0x0A010000; test_prefix.len = 16;
+	assert(notif_chain_subscribe_by_callback("test_trie",
+				&test_prefix, sizeof(test_prefix), 1, test_app_cb));
+	test_prefix.addr = 0x0A010101; test_prefix.len = 32;
+	assert(notif_chain_subscribe_by_callback("test_trie",
+				&test_prefix, sizeof(test_prefix), 2, test_app_cb));
+	test_prefix.addr = 0; test_prefix.len = 0;
+	assert(notif_chain_subscribe_by_callback("test_trie",
+				&test_prefix, sizeof(test_prefix), 3, test_app_cb));
+	test_prefix.addr = 0x14000000; test_prefix.len = 8;
+	assert(notif_chain_subscribe_by_callback("test_trie",
+				&test_prefix, sizeof(test_prefix), 4, test_app_cb));
+
+	test_prefix.addr = 0x0A010101; test_prefix.len = 32;
+	test_publish(&notif_chain, &test_prefix, sizeof(test_prefix));
+	assert(hits[1] == 1 && hits[2] == 1 && hits[3] == 1 && hits[4] == 0);
+
+	test_prefix.addr = 0x0A010200; test_prefix.len = 24;
+	test_publish(&notif_chain, &test_prefix, sizeof(test_prefix));
+	assert(hits[1] == 2 && hits[2] == 1 && hits[3] == 2 && hits[4] == 0);
+
+	/* Covers none but the default route */
+	test_prefix.addr = 0x0A000000; test_prefix.len = 8;
+	test_publish(&notif_chain, &test_prefix, sizeof(test_prefix));
+	assert(hits[1] == 2 && hits[2] == 1 && hits[3] == 3 && hits[4] == 0);
+
+	notif_chain_delete(&notif_chain);
+	printf("%s() : PASS\n", __FUNCTION__);
+}
+
+static uint32_t rcu_n_freed;
+static bool rcu_reader_in;
+static bool rcu_reader_leave;
+
+static void
+test_rcu_free_cb(void *ptr){
+
+	__atomic_add_fetch(&rcu_n_freed, 1, __ATOMIC_SEQ_CST);
+	free(ptr);
+}
+
+static void *
+test_rcu_reader_fn(void *arg){
+
+	notif_rcu_read_lock();
+	__atomic_store_n(&rcu_reader_in, true, __ATOMIC_SEQ_CST);
+
+	while(!__atomic_load_n(&rcu_reader_leave, __ATOMIC_SEQ_CST)){
+		usleep(1000);
+	}
+
+	notif_rcu_read_unlock();
+	return NULL;
+}
+
+static void *
+test_rcu_reclaim_fn(void *arg){
+
+	notif_rcu_reclaim();
+	return NULL;
+}
+
+static void
+test_rcu_retire_reclaim(){
+
+	pthread_t reader, reclaimer;
+
+	/* Reclaim from within a read side section leaves it to the next */
+	notif_rcu_read_lock();
+	notif_rcu_retire(malloc(16), test_rcu_free_cb);
+	notif_rcu_reclaim();
+	assert(__atomic_load_n(&rcu_n_freed, __ATOMIC_SEQ_CST) == 0);
+	notif_rcu_read_unlock();
+	notif_rcu_reclaim();
+	assert(__atomic_load_n(&rcu_n_freed, __ATOMIC_SEQ_CST) == 1);
+
+	/* An object retired while a reader is in outlives the reader */
+	pthread_create(&reader, NULL, test_rcu_reader_fn, NULL);
+	while(!__atomic_load_n(&rcu_reader_in, __ATOMIC_SEQ_CST)) usleep(1000);
+
+	notif_rcu_retire(malloc(16), test_rcu_free_cb);
+	pthread_create(&reclaimer, NULL, test_rcu_reclaim_fn, NULL);
+
+	usleep(100000);
+	assert(__atomic_load_n(&rcu_n_freed, __ATOMIC_SEQ_CST) == 1);
+
+	__atomic_store_n(&rcu_reader_leave, true, __ATOMIC_SEQ_CST);
+	pthread_join(reader, NULL);
+	pthread_join(reclaimer, NULL);
+	assert(__atomic_load_n(&rcu_n_freed, __ATOMIC_SEQ_CST) == 2);
+
+	printf("%s() : PASS\n", __FUNCTION__);
+}
+
+static void
+test_wide_tlv_round_trip(){
+
+	uint32_t i, tlv_buff_size;
+	char *tlv_buffer = NULL;
+	char notif_chain_name[NOTIF_NAME_SIZE];
+	static char key[300], data[70000];
+	notif_chain_elem_t notif_chain_elem, *decoded;
+	notif_chain_comm_channel_t notif_chain_comm_channel;
+
+	for(i = 0; i < sizeof(key); i++) key[i] = (char)i;
+	for(i = 0; i < sizeof(data); i++) data[i] = (char)(i * 7);
+
+	memset(&notif_chain_elem, 0, sizeof(notif_chain_elem_t));
+	memset(&notif_chain_comm_channel, 0, sizeof(notif_chain_comm_channel_t));
+	notif_chain_elem.notif_chain_comm_channel = &notif_chain_comm_channel;
+	notif_chain_elem.client_id = 9;
+	notif_chain_elem.notif_code = PUB_TO_SUBS_NOTIF_C_UPDATE;
+	notif_chain_elem.data.app_key_data = key;
+	notif_chain_elem.data.app_key_data_size = sizeof(key);
+	notif_chain_elem.data.app_data_to_notify = data;
+	notif_chain_elem.data.app_data_to_notify_size = sizeof(data);
+
+	memset(notif_chain_name, 0, sizeof(notif_chain_name));
+	strncpy(notif_chain_name, "test_wide", sizeof(notif_chain_name));
+
+	tlv_buff_size = notif_chain_serialize_notif_chain_elem(notif_chain_name,
+			&notif_chain_elem, NULL, 0, &tlv_buffer);
+	assert(tlv_buff_size > sizeof(key) + sizeof(data));
+
+	decoded = notif_chain_deserialize_notif_chain_elem(tlv_buffer,
+			tlv_buff_size, notif_chain_name);
+	assert(decoded);
+	assert(strcmp(notif_chain_name, "test_wide") == 0);
+	assert(decoded->client_id == 9);
+	assert(decoded->notif_code == PUB_TO_SUBS_NOTIF_C_UPDATE);
+	assert(decoded->data.app_key_data_size == sizeof(key));
+	assert(memcmp(decoded->data.app_key_data, key, sizeof(key)) == 0);
+	assert(decoded->data.app_data_to_notify_size == sizeof(data));
+	assert(memcmp(decoded->data.app_data_to_notify, data, sizeof(data)) == 0);
+	assert(decoded->notif_chain_comm_channel->peer_caps & NOTIF_C_CAP_WIDE_TLV);
+	notif_chain_free_deserialized_notif_chain_elem(decoded);
+
+	/* Short values keep the short form */
+	assert(tlv_buffer_insert_tlv(tlv_buffer, NOTIF_C_APP_KEY_DATA_TLV,
+				UINT8_MAX, key) - tlv_buffer == TLV_OVERHEAD_SIZE + UINT8_MAX);
+	assert(tlv_buffer_insert_tlv(tlv_buffer, NOTIF_C_APP_KEY_DATA_TLV,
+				UINT8_MAX + 1, key) - tlv_buffer ==
+			TLV_WIDE_OVERHEAD_SIZE + UINT8_MAX + 1);
+
+	free(tlv_buffer);
+	printf("%s() : PASS\n", __FUNCTION__);
+}
+
+/* A peer which did not advertise wide TLVs gets none, each one
+ * counted as dropped by its outq */
+static void
+test_narrow_peer_drop(){
+
+	int sv[2], key = 1;
+	static char data[UINT8_MAX + 1];
+	static notif_chain_t notif_chain;
+	notif_chain_elem_t notif_chain_elem, publish, *registered;
+	notif_chain_comm_channel_t notif_chain_comm_channel;
+
+	assert(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == 0);
+	notif_chain_init(&notif_chain, "test_narrow",
+			test_int_comp_fn, NULL, test_int_hash_fn);
+
+	memset(&notif_chain_comm_channel, 0, sizeof(notif_chain_comm_channel_t));
+	notif_chain_comm_channel.notif_ch_type = NOTIF_C_INET_SOCKETS;
+	NOTIF_CHAIN_ELEM_PROTO(&notif_chain_comm_channel) = IPPROTO_TCP;
+	NOTIF_CHAIN_ELEM_SKT_FD(&notif_chain_comm_channel) = sv[0];
+
+	memset(&notif_chain_elem, 0, sizeof(notif_chain_elem_t));
+	notif_chain_elem.client_id = 7;
+	notif_chain_elem.data.app_key_data = &key;
+	notif_chain_elem.data.app_key_data_size = sizeof(key);
+	notif_chain_elem.notif_chain_comm_channel = &notif_chain_comm_channel;
+	assert(notif_chain_register_chain_element(&notif_chain, &notif_chain_elem));
+
+	registered = notif_chain_lookup_notif_chain_element(&notif_chain,
+			7, &key, sizeof(key));
+	assert(registered);
+
+	memset(&publish, 0, sizeof(notif_chain_elem_t));
+	publish.notif_code = PUB_TO_SUBS_NOTIF_C_UPDATE;
+	publish.data.app_key_data = &key;
+	publish.data.app_key_data_size = sizeof(key);
+	publish.data.app_data_to_notify = data;
+	publish.data.app_data_to_notify_size = sizeof(data);
+	notif_chain_invoke(&notif_chain, &publish);
+	notif_chain_invoke(&notif_chain, &publish);
+
+	assert(registered->notif_chain_comm_channel->outq->n_dropped == 2);
+	assert(registered->notif_chain_comm_channel->outq->n_sent == 0);
+
+	notif_chain_delete(&notif_chain);
+	close(sv[1]);
+	printf("%s() : PASS\n", __FUNCTION__);
+}
+
+static uint32_t n_reassembled;
+static uint32_t reassembled_sizes[4];
+
+static void
+test_tcp_recv_fn(char *msg, uint32_t msg_size,
+		char *sender_ip_addr, uint32_t sender_port_no,
+		uint32_t sender_skt_fd){
+
+	uint32_t i;
+
+	for(i = 0; i < msg_size; i++){
+		assert(msg[i] == (char)(msg_size + i));
+	}
+	reassembled_sizes[n_reassembled++] = msg_size;
+}
+
+static uint32_t
+test_tcp_frame_msg(char *buff, uint32_t msg_size){
+
+	uint32_t i, msg_len_prefix = htonl(msg_size);
+
+	memcpy(buff, &msg_len_prefix, TCP_MSG_LEN_PREFIX_SIZE);
+	for(i = 0; i < msg_size; i++){
+		buff[TCP_MSG_LEN_PREFIX_SIZE + i] = (char)(msg_size + i);
+	}
+	return TCP_MSG_LEN_PREFIX_SIZE + msg_size;
+}
+
+static void
+test_tcp_reassembly(){
+
+	int sv[2];
+	uint32_t len = 0;
+	static char stream[2 * TCP_MSG_LEN_PREFIX_SIZE + 5000 + 40];
+	tcp_reassembly_buffer_t reassembly_buffer;
+
+	memset(&reassembly_buffer, 0, sizeof(tcp_reassembly_buffer_t));
+	assert(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == 0);
+
+	len += test_tcp_frame_msg(stream, 5000);
+	len += test_tcp_frame_msg(stream + len, 40);
+
+	/* Half a length prefix */
+	assert(write(sv[1], stream, 2) == 2);
+	assert(tcp_reassembly_recv(sv[0], &reassembly_buffer,
+				test_tcp_recv_fn, "127.0.0.1", 0) == 2);
+	assert(n_reassembled == 0);
+
+	/* Rest of the prefix and part of the first message */
+	assert(write(sv[1], stream + 2, 1000) == 1000);
+	assert(tcp_reassembly_recv(sv[0], &reassembly_buffer,
+				test_tcp_recv_fn, "127.0.0.1", 0) == 1000);
+	assert(n_reassembled == 0);
+
+	/* End of the first message and the whole second one */
+	assert(write(sv[1], stream + 1002, len - 1002) == len - 1002);
+	assert(tcp_reassembly_recv(sv[0], &reassembly_buffer,
+				test_tcp_recv_fn, "127.0.0.1", 0) == len - 1002);
+	assert(n_reassembled == 2);
+	assert(reassembled_sizes[0] == 5000 && reassembled_sizes[1] == 40);
+	assert(reassembly_buffer.len == 0);
+
+	tcp_reassembly_buffer_free(&reassembly_buffer);
+	close(sv[0]);
+	close(sv[1]);
+	printf("%s() : PASS\n", __FUNCTION__);
+}
+
+#define TEST_OUTQ_N_KEYS	3
+#define TEST_OUTQ_N_ROUNDS	5
+
+static uint32_t n_outq_notifs;
+static int outq_last_value[TEST_OUTQ_N_KEYS];
+
+static void
+test_outq_record_cb(char *tlv_buffer, uint32_t tlv_buff_size, void *arg){
+
+	int key, value;
+	char notif_chain_name[NOTIF_C_NOTIF_CHAIN_NAME_VALUE_LEN];
+	notif_chain_elem_t notif_chain_elem;
+	notif_chain_comm_channel_t notif_chain_comm_channel;
+
+	assert(notif_chain_deserialize_notif_chain_elem_view(tlv_buffer,
+				tlv_buff_size, notif_chain_name,
+				&notif_chain_elem, &notif_chain_comm_channel));
+	assert(notif_chain_elem.data.app_key_data_size == sizeof(int));
+	assert(notif_chain_elem.data.app_data_to_notify_size == sizeof(int));
+
+	memcpy(&key, notif_chain_elem.data.app_key_data, sizeof(int));
+	memcpy(&value, notif_chain_elem.data.app_data_to_notify, sizeof(int));
+	outq_last_value[key] = value;
+	n_outq_notifs++;
+}
+
+static void
+test_outq_recv_fn(char *msg, uint32_t msg_size,
+		char *sender_ip_addr, uint32_t sender_port_no,
+		uint32_t sender_skt_fd){
+
+	notif_chain_for_each_notification(msg, msg_size,
+			test_outq_record_cb, NULL);
+}
+
+static void
+test_bulk_outq_conflation(){
+
+	int sv[2];
+	fd_set read_fds;
+	struct timeval timeout;
+	int i, round, keys[TEST_OUTQ_N_KEYS], value;
+	bool registered[TEST_OUTQ_N_KEYS];
+	static notif_chain_t notif_chain;
+	notif_chain_elem_t notif_chain_elems[TEST_OUTQ_N_KEYS], publish;
+	notif_chain_comm_channel_t notif_chain_comm_channel;
+	tcp_reassembly_buffer_t reassembly_buffer;
+
+	assert(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == 0);
+	memset(&reassembly_buffer, 0, sizeof(tcp_reassembly_buffer_t));
+
+	notif_chain_init(&notif_chain, "test_outq",
+			test_int_comp_fn, NULL, test_int_hash_fn);
+
+	/* One socket subscriber of every key, registered at once */
+	memset(&notif_chain_comm_channel, 0, sizeof(notif_chain_comm_channel_t));
+	notif_chain_comm_channel.notif_ch_type = NOTIF_C_INET_SOCKETS;
+	NOTIF_CHAIN_ELEM_PROTO(&notif_chain_comm_channel) = IPPROTO_TCP;
+	NOTIF_CHAIN_ELEM_SKT_FD(&notif_chain_comm_channel) = sv[0];
+
+	memset(notif_chain_elems, 0, sizeof(notif_chain_elems));
+	for(i = 0; i < TEST_OUTQ_N_KEYS; i++){
+		keys[i] = i;
+		notif_chain_elems[i].client_id = 6;
+		notif_chain_elems[i].data.app_key_data = &keys[i];
+		notif_chain_elems[i].data.app_key_data_size = sizeof(int);
+		notif_chain_elems[i].notif_chain_comm_channel = &notif_chain_comm_channel;
+	}
+
+	assert(notif_chain_register_chain_elements(&notif_chain,
+				notif_chain_elems, TEST_OUTQ_N_KEYS,
+				registered) == TEST_OUTQ_N_KEYS);
+	for(i = 0; i < TEST_OUTQ_N_KEYS; i++) assert(registered[i]);
+
+	assert(notif_chain_set_client_outq_policy(6,
+				NOTIF_OUTQ_CONFLATE_BY_KEY, NOTIF_OUTQ_DEFAULT_MAX_DEPTH) == 1);
+
+	/* The batch holds back the writes, every key's updates
+	 * conflate into its latest */
+	notif_chain_batch_begin();
+
+	for(round = 0; round < TEST_OUTQ_N_ROUNDS; round++){
+		for(i = 0; i < TEST_OUTQ_N_KEYS; i++){
+
+			value = round * TEST_OUTQ_N_KEYS + i;
+
+			memset(&publish, 0, sizeof(notif_chain_elem_t));
+			publish.notif_code = PUB_TO_SUBS_NOTIF_C_UPDATE;
+			publish.data.app_key_data = &keys[i];
+			publish.data.app_key_data_size = sizeof(int);
+			publish.data.app_data_to_notify = &value;
+			publish.data.app_data_to_notify_size = sizeof(int);
+			notif_chain_invoke(&notif_chain, &publish);
+		}
+	}
+
+	notif_chain_batch_end();
+
+	while(1){
+		FD_ZERO(&read_fds);
+		FD_SET(sv[1], &read_fds);
+		timeout.tv_sec = 0;
+		timeout.tv_usec = 200000;
+		if(select(sv[1] + 1, &read_fds, NULL, NULL, &timeout) <= 0) break;
+		assert(tcp_reassembly_recv(sv[1], &reassembly_buffer,
+					test_outq_recv_fn, "127.0.0.1", 0) > 0);
+	}
+
+	assert(n_outq_notifs == TEST_OUTQ_N_KEYS);
+	for(i = 0; i < TEST_OUTQ_N_KEYS; i++){
+		assert(outq_last_value[i] ==
+				(TEST_OUTQ_N_ROUNDS - 1) * TEST_OUTQ_N_KEYS + i);
+	}
+
+	notif_chain_delete(&notif_chain);
+	tcp_reassembly_buffer_free(&reassembly_buffer);
+	close(sv[1]);
+	printf("%s() : PASS\n", __FUNCTION__);
+}
+
+#define TEST_MAILBOX_N_POSTS	2000
+
+static uint32_t mailbox_n_got;
+static bool mailbox_in_order = true;
+
+static void
+test_mailbox_app_cb(notif_chain_elem_t *notif_chain_elem){
+
+	uint32_t seq;
+
+	memcpy(&seq, notif_chain_elem->data.app_data_to_notify, sizeof(seq));
+	if(seq != mailbox_n_got) mailbox_in_order = false;
+	mailbox_n_got++;
+}
+
+/* Subscriber multiplexing its mailbox, must never sleep while
+ * notifications are queued */
+static void *
+test_mailbox_poll_fn(void *arg){
+
+	int fd;
+	uint64_t event;
+	fd_set read_fds;
+	struct timeval timeout;
+	notif_mailbox_t *mailbox = (notif_mailbox_t *)arg;
+
+	fd = notif_mailbox_fd(mailbox);
+
+	while(mailbox_n_got < TEST_MAILBOX_N_POSTS){
+
+		FD_ZERO(&read_fds);
+		FD_SET(fd, &read_fds);
+		timeout.tv_sec = 2;
+		timeout.tv_usec = 0;
+		if(select(fd + 1, &read_fds, NULL, NULL, &timeout) <= 0) break;
+
+		assert(read(fd, &event, sizeof(event)) == sizeof(event));
+		while(notif_mailbox_drain(mailbox, NOTIF_MAILBOX_DEFAULT_BATCH));
+	}
+	return NULL;
+}
+
+static void
+test_mailbox_poll(){
+
+	uint32_t seq;
+	pthread_t consumer;
+	notif_mailbox_t *mailbox;
+	notif_chain_elem_t publish;
+	static notif_chain_t notif_chain;
+
+	notif_chain_init(&notif_chain, "test_mailbox", NULL, NULL, NULL);
+
+	mailbox = notif_mailbox_create(NOTIF_MAILBOX_DEFAULT_SIZE,
+				test_mailbox_app_cb);
+	assert(mailbox);
+	assert(notif_chain_subscribe_by_mailbox("test_mailbox",
+				NULL, 0, 1, mailbox));
+
+	pthread_create(&consumer, NULL, test_mailbox_poll_fn, (void *)mailbox);
+
+	/* Paced, so that the mailbox goes empty time and again */
+	for(seq = 0; seq < TEST_MAILBOX_N_POSTS; seq++){
+
+		memset(&publish, 0, sizeof(notif_chain_elem_t));
+		publish.notif_code = PUB_TO_SUBS_NOTIF_C_UPDATE;
+		publish.data.app_data_to_notify = &seq;
+		publish.data.app_data_to_notify_size = sizeof(seq);
+		notif_chain_invoke(&notif_chain, &publish);
+		if(seq % 16 == 0) usleep(100);
+	}
+
+	pthread_join(consumer, NULL);
+	assert(mailbox_n_got == TEST_MAILBOX_N_POSTS);
+	assert(mailbox_in_order);
+	assert(mailbox->n_dropped == 0);
+
+	notif_chain_delete(&notif_chain);
+	notif_mailbox_destroy(mailbox);
+	printf("%s() : PASS\n", __FUNCTION__);
+}
+
+/* Publishes seq, through the workers if async */
+static void
+test_publish_seq(notif_chain_t *notif_chain, void *key, uint32_t key_size,
+		uint32_t seq, bool async){
+
+	notif_chain_elem_t notif_chain_elem;
+
+	memset(&notif_chain_elem, 0, sizeof(notif_chain_elem_t));
+	notif_chain_elem.notif_code = PUB_TO_SUBS_NOTIF_C_UPDATE;
+	notif_chain_elem.data.app_key_data = key;
+	notif_chain_elem.data.app_key_data_size = key_size;
+	notif_chain_elem.data.app_data_to_notify = &seq;
+	notif_chain_elem.data.app_data_to_notify_size = sizeof(seq);
+
+	if(async){
+		notif_chain_invoke_async(notif_chain, &notif_chain_elem);
+	}
+	else {
+		notif_chain_invoke(notif_chain, &notif_chain_elem);
+	}
+}
+
+#define TEST_ASYNC_N_SUBS	16
+#define TEST_ASYNC_N_PUBS	5000
+
+/* Written by the one worker serving the client only */
+static uint32_t async_next_seq[TEST_ASYNC_N_SUBS];
+static bool async_out_of_order;
+
+static void
+test_async_app_cb(notif_chain_elem_t *notif_chain_elem){
+
+	uint32_t seq;
+
+	memcpy(&seq, notif_chain_elem->data.app_data_to_notify, sizeof(seq));
+	if(seq != async_next_seq[notif_chain_elem->client_id]){
+		__atomic_store_n(&async_out_of_order, true, __ATOMIC_RELAXED);
+	}
+	async_next_seq[notif_chain_elem->client_id]++;
+}
+
+/* Spread over the workers, every subscriber still sees the
+ * publishes in the order made */
+static void
+test_async_order(){
+
+	int key = 1;
+	uint32_t i, seq;
+	static notif_chain_t notif_chain;
+
+	notif_chain_init(&notif_chain, "test_async",
+			test_int_comp_fn, NULL, test_int_hash_fn);
+
+	for(i = 0; i < TEST_ASYNC_N_SUBS; i++){
+		assert(notif_chain_subscribe_by_callback("test_async",
+					i % 2 ? &key : NULL, i % 2 ? sizeof(key) : 0,
+					i, test_async_app_cb));
+	}
+
+	assert(notif_async_start(NOTIF_ASYNC_DEFAULT_WORKERS));
+
+	for(seq = 0; seq < TEST_ASYNC_N_PUBS; seq++){
+		test_publish_seq(&notif_chain, &key, sizeof(key), seq, true);
+	}
+
+	notif_async_stop();
+
+	for(i = 0; i < TEST_ASYNC_N_SUBS; i++){
+		assert(async_next_seq[i] == TEST_ASYNC_N_PUBS);
+	}
+	assert(!async_out_of_order);
+
+	notif_chain_delete(&notif_chain);
+	printf("%s() : PASS\n", __FUNCTION__);
+}
+
+#define TEST_LANE_N_LOW		10
+#define TEST_LANE_N_HIGH	40
+#define TEST_LANE_DELETE_KEY	5
+#define TEST_LANE_HIGH_BASE	1000
+
+static bool lane_gate_open;
+static uint32_t lane_n_got;
+static int lane_order[1 + TEST_LANE_N_LOW + 1 + TEST_LANE_N_HIGH];
+
+/* Holds the worker till everything is queued behind it */
+static void
+test_lane_app_cb(notif_chain_elem_t *notif_chain_elem){
+
+	while(!__atomic_load_n(&lane_gate_open, __ATOMIC_ACQUIRE)){
+		usleep(1000);
+	}
+	memcpy(&lane_order[lane_n_got++],
+			notif_chain_elem->data.app_data_to_notify, sizeof(int));
+}
+
+static void
+test_lane_publish(notif_chain_t *notif_chain, int key, int value,
+		notif_ch_notify_opcode_t notif_code, notif_chain_prio_t prio){
+
+	notif_chain_elem_t notif_chain_elem;
+
+	memset(&notif_chain_elem, 0, sizeof(notif_chain_elem_t));
+	notif_chain_elem.notif_code = notif_code;
+	notif_chain_elem.prio = prio;
+	notif_chain_elem.data.app_key_data = &key;
+	notif_chain_elem.data.app_key_data_size = sizeof(key);
+	notif_chain_elem.data.app_data_to_notify = &value;
+	notif_chain_elem.data.app_data_to_notify_size = sizeof(value);
+	notif_chain_invoke_async(notif_chain, &notif_chain_elem);
+}
+
+static uint32_t
+test_lane_position(int value){
+
+	uint32_t i;
+
+	for(i = 0; i < lane_n_got; i++){
+		if(lane_order[i] == value) return i;
+	}
+	assert(0);
+	return 0;
+}
+
+/* High lane publishes overtake the queued low lane ones, but not
+ * those of their own key, and do not starve them */
+static void
+test_lane_order(){
+
+	int i;
+	static notif_chain_t notif_chain;
+
+	notif_chain_init(&notif_chain, "test_lane",
+			test_int_comp_fn, NULL, NULL);
+	assert(notif_chain_subscribe_by_callback("test_lane",
+				NULL, 0, 1, test_lane_app_cb));
+
+	assert(notif_async_start(1));
+
+	/* Keeps the only worker busy */
+	test_lane_publish(&notif_chain, -1, -1,
+			PUB_TO_SUBS_NOTIF_C_CREATE, NOTIF_C_PRIO_DEFAULT);
+	usleep(50000);
+
+	for(i = 0; i < TEST_LANE_N_LOW; i++){
+		test_lane_publish(&notif_chain, i, i,
+				PUB_TO_SUBS_NOTIF_C_CREATE, NOTIF_C_PRIO_DEFAULT);
+	}
+	/* High lane by default */
+	test_lane_publish(&notif_chain, TEST_LANE_DELETE_KEY, -2,
+			PUB_TO_SUBS_NOTIF_C_DELETE, NOTIF_C_PRIO_DEFAULT);
+	for(i = 0; i < TEST_LANE_N_HIGH; i++){
+		test_lane_publish(&notif_chain, TEST_LANE_HIGH_BASE + i,
+				TEST_LANE_HIGH_BASE + i,
+				PUB_TO_SUBS_NOTIF_C_UPDATE, NOTIF_C_PRIO_HIGH);
+	}
+
+	__atomic_store_n(&lane_gate_open, true, __ATOMIC_RELEASE);
+	notif_async_stop();
+
+	assert(lane_n_got == 1 + TEST_LANE_N_LOW + 1 + TEST_LANE_N_HIGH);
+	assert(lane_order[0] == -1);
+
+	/* The CREATE the DELETE withdraws is moved ahead with it */
+	assert(lane_order[1] == TEST_LANE_DELETE_KEY);
+	assert(lane_order[2] == -2);
+
+	/* Each lane keeps its own order */
+	for(i = 1; i < TEST_LANE_N_HIGH; i++){
+		assert(test_lane_position(TEST_LANE_HIGH_BASE + i - 1) <
+				test_lane_position(TEST_LANE_HIGH_BASE + i));
+	}
+	for(i = 1; i < TEST_LANE_N_LOW; i++){
+		if(i == TEST_LANE_DELETE_KEY || i - 1 == TEST_LANE_DELETE_KEY) continue;
+		assert(test_lane_position(i - 1) < test_lane_position(i));
+	}
+
+	/* High lane went first, yet a low lane publish got through
+	 * before the high lane ran dry */
+	assert(test_lane_position(TEST_LANE_HIGH_BASE) < test_lane_position(0));
+	assert(test_lane_position(0) <
+			test_lane_position(TEST_LANE_HIGH_BASE + TEST_LANE_N_HIGH - 1));
+
+	notif_chain_delete(&notif_chain);
+	printf("%s() : PASS\n", __FUNCTION__);
+}
+
+#define TEST_CONFLATE_WINDOW_MS	500
+
+/* Published seq is key * TEST_CONFLATE_SEQS_PER_KEY + n, the
+ * wildcard subscriber does not get the key itself. Key 0 is for
+ * the keyless publishes */
+#define TEST_CONFLATE_SEQS_PER_KEY	100
+
+static uint32_t conflate_n_got[3];
+static uint32_t conflate_last_seq[3];
+
+static void
+test_conflate_app_cb(notif_chain_elem_t *notif_chain_elem){
+
+	uint32_t seq, key;
+
+	memcpy(&seq, notif_chain_elem->data.app_data_to_notify, sizeof(seq));
+	key = seq / TEST_CONFLATE_SEQS_PER_KEY;
+	conflate_last_seq[key] = seq % TEST_CONFLATE_SEQS_PER_KEY;
+	__atomic_add_fetch(&conflate_n_got[key], 1, __ATOMIC_RELEASE);
+}
+
+/* A burst for a key within the window is delivered once, with
+ * its latest data, once the window expires */
+static void
+test_conflation_window(){
+
+	int key;
+	uint32_t seq, n_waits;
+	static notif_chain_t notif_chain;
+
+	notif_chain_init(&notif_chain, "test_conflate",
+			test_int_comp_fn, NULL, test_int_hash_fn);
+	assert(notif_chain_subscribe_by_callback("test_conflate",
+				NULL, 0, 1, test_conflate_app_cb));
+	assert(notif_chain_enable_conflation(&notif_chain,
+				TEST_CONFLATE_WINDOW_MS));
+
+	for(seq = 1; seq <= 10; seq++){
+		key = 1;
+		test_publish_seq(&notif_chain, &key, sizeof(key),
+				key * TEST_CONFLATE_SEQS_PER_KEY + seq, true);
+		if(seq > 5) continue;
+		key = 2;
+		test_publish_seq(&notif_chain, &key, sizeof(key),
+				key * TEST_CONFLATE_SEQS_PER_KEY + seq, true);
+	}
+
+	/* Not held, delivered on this thread as no workers run */
+	test_publish_seq(&notif_chain, NULL, 0, 1, true);
+	assert(conflate_n_got[0] == 1);
+	assert(__atomic_load_n(&conflate_n_got[1], __ATOMIC_ACQUIRE) == 0);
+	assert(__atomic_load_n(&conflate_n_got[2], __ATOMIC_ACQUIRE) == 0);
+
+	for(n_waits = 0; n_waits < 100; n_waits++){
+		if(__atomic_load_n(&conflate_n_got[1], __ATOMIC_ACQUIRE) &&
+				__atomic_load_n(&conflate_n_got[2], __ATOMIC_ACQUIRE)){
+			break;
+		}
+		usleep(TEST_CONFLATE_WINDOW_MS * 1000 / 10);
+	}
+	/* Flushed by the window expiring, not by the disable */
+	assert(n_waits < 100);
+
+	notif_chain_disable_conflation(&notif_chain);
+
+	assert(conflate_n_got[1] == 1 && conflate_last_seq[1] == 10);
+	assert(conflate_n_got[2] == 1 && conflate_last_seq[2] == 5);
+
+	notif_chain_delete(&notif_chain);
+	printf("%s() : PASS\n", __FUNCTION__);
+}
+
+#define TEST_SHARD_N_SHARDS	4
+#define TEST_SHARD_N_KEYS	8
+#define TEST_SHARD_N_SUBS	(2 * TEST_SHARD_N_KEYS)
+#define TEST_SHARD_N_PUBS	4000
+
+/* Publish seq is for key seq % TEST_SHARD_N_KEYS. Client i is
+ * subscribed to key i % TEST_SHARD_N_KEYS, client TEST_SHARD_N_SUBS
+ * to every key */
+static uint32_t shard_n_got[TEST_SHARD_N_SUBS + 1];
+static uint32_t shard_next_seq[TEST_SHARD_N_SUBS + 1][TEST_SHARD_N_KEYS];
+static bool shard_out_of_order;
+
+/* A key's publishes are delivered by its shard's dispatcher only */
+static void
+test_shard_app_cb(notif_chain_elem_t *notif_chain_elem){
+
+	uint32_t seq, key;
+	uint32_t client_id = notif_chain_elem->client_id;
+
+	memcpy(&seq, notif_chain_elem->data.app_data_to_notify, sizeof(seq));
+	key = seq % TEST_SHARD_N_KEYS;
+
+	if(seq != shard_next_seq[client_id][key]){
+		__atomic_store_n(&shard_out_of_order, true, __ATOMIC_RELAXED);
+	}
+	shard_next_seq[client_id][key] = seq + TEST_SHARD_N_KEYS;
+	__atomic_add_fetch(&shard_n_got[client_id], 1, __ATOMIC_RELAXED);
+}
+
+/* Keys are delivered in parallel, yet each in the order published */
+static void
+test_shard_order(){
+
+	int key;
+	uint32_t i, seq;
+	static notif_chain_t notif_chain;
+
+	notif_chain_init(&notif_chain, "test_shard",
+			test_int_comp_fn, NULL, test_int_hash_fn);
+	assert(notif_chain_enable_sharding(&notif_chain, TEST_SHARD_N_SHARDS));
+
+	for(i = 0; i < TEST_SHARD_N_SUBS; i++){
+		key = i % TEST_SHARD_N_KEYS;
+		shard_next_seq[i][key] = key;
+		assert(notif_chain_subscribe_by_callback("test_shard",
+					&key, sizeof(key), i, test_shard_app_cb));
+	}
+	for(key = 0; key < TEST_SHARD_N_KEYS; key++){
+		shard_next_seq[TEST_SHARD_N_SUBS][key] = key;
+	}
+	assert(notif_chain_subscribe_by_callback("test_shard",
+				NULL, 0, TEST_SHARD_N_SUBS, test_shard_app_cb));
+
+	for(seq = 0; seq < TEST_SHARD_N_PUBS; seq++){
+		key = seq % TEST_SHARD_N_KEYS;
+		test_publish_seq(&notif_chain, &key, sizeof(key), seq, false);
+	}
+
+	/* Delivers what the dispatchers have queued */
+	notif_chain_delete(&notif_chain);
+
+	for(i = 0; i < TEST_SHARD_N_SUBS; i++){
+		assert(shard_n_got[i] == TEST_SHARD_N_PUBS / TEST_SHARD_N_KEYS);
+	}
+	assert(shard_n_got[TEST_SHARD_N_SUBS] == TEST_SHARD_N_PUBS);
+	assert(!shard_out_of_order);
+
+	printf("%s() : PASS\n", __FUNCTION__);
+}
+
+#define TEST_FANOUT_N_SUBS	(4 * NOTIF_FANOUT_THRESHOLD)
+#define TEST_FANOUT_N_PUBS	10
+
+static uint32_t fanout_n_got[TEST_FANOUT_N_SUBS];
+
+static void
+test_fanout_app_cb(notif_chain_elem_t *notif_chain_elem){
+
+	__atomic_add_fetch(&fanout_n_got[notif_chain_elem->client_id], 1,
+			__ATOMIC_RELAXED);
+}
+
+/* Split over the fan-out workers, a publish still reaches every
+ * subscriber exactly once, and before notif_chain_invoke() returns */
+static void
+test_fanout_delivery(){
+
+	int key = 1;
+	uint32_t i, seq;
+	static notif_chain_t notif_chain;
+
+	notif_chain_init(&notif_chain, "test_fanout",
+			test_int_comp_fn, NULL, test_int_hash_fn);
+
+	for(i = 0; i < TEST_FANOUT_N_SUBS; i++){
+		assert(notif_chain_subscribe_by_callback("test_fanout",
+					i % 2 ? &key : NULL, i % 2 ? sizeof(key) : 0,
+					i, test_fanout_app_cb));
+	}
+
+	assert(notif_fanout_start(NOTIF_FANOUT_DEFAULT_WORKERS));
+	assert(notif_fanout_is_active());
+
+	for(seq = 0; seq < TEST_FANOUT_N_PUBS; seq++){
+
+		test_publish_seq(&notif_chain, &key, sizeof(key), seq, false);
+
+		for(i = 0; i < TEST_FANOUT_N_SUBS; i++){
+			assert(__atomic_load_n(&fanout_n_got[i], __ATOMIC_RELAXED) ==
+					seq + 1);
+		}
+	}
+
+	notif_fanout_stop();
+	notif_chain_delete(&notif_chain);
+	printf("%s() : PASS\n", __FUNCTION__);
+}
+
+#define TEST_POST_N_POSTERS	4
+#define TEST_POST_N_POSTS	2000
+
+/* Posted seq is poster * TEST_POST_N_POSTS + n */
+static uint32_t post_n_got[TEST_POST_N_POSTERS];
+static bool post_out_of_order;
+static notif_chain_t post_notif_chain;
+
+/* Delivered by the chain's dispatcher thread only */
+static void
+test_post_app_cb(notif_chain_elem_t *notif_chain_elem){
+
+	uint32_t seq, poster;
+
+	memcpy(&seq, notif_chain_elem->data.app_data_to_notify, sizeof(seq));
+	poster = seq / TEST_POST_N_POSTS;
+
+	if(seq % TEST_POST_N_POSTS != post_n_got[poster]){
+		post_out_of_order = true;
+	}
+	post_n_got[poster]++;
+}
+
+static void *
+test_post_poster_fn(void *arg){
+
+	uint32_t n, seq;
+	notif_chain_elem_t notif_chain_elem;
+	uint32_t poster = (uint32_t)(uintptr_t)arg;
+
+	for(n = 0; n < TEST_POST_N_POSTS; n++){
+
+		seq = poster * TEST_POST_N_POSTS + n;
+
+		memset(&notif_chain_elem, 0, sizeof(notif_chain_elem_t));
+		notif_chain_elem.notif_code = PUB_TO_SUBS_NOTIF_C_UPDATE;
+		notif_chain_elem.data.app_data_to_notify = &seq;
+		notif_chain_elem.data.app_data_to_notify_size = sizeof(seq);
+		notif_chain_post(&post_notif_chain, &notif_chain_elem);
+	}
+	return NULL;
+}
+
+/* Threads posting at once each see their posts delivered, all of
+ * them and in the order posted */
+static void
+test_post_queue(){
+
+	uint32_t i;
+	pthread_t posters[TEST_POST_N_POSTERS];
+
+	notif_chain_init(&post_notif_chain, "test_post",
+			test_int_comp_fn, NULL, NULL);
+	assert(notif_chain_subscribe_by_callback("test_post",
+				NULL, 0, 1, test_post_app_cb));
+	assert(notif_chain_enable_post_queue(&post_notif_chain));
+
+	for(i = 0; i < TEST_POST_N_POSTERS; i++){
+		pthread_create(&posters[i], NULL, test_post_poster_fn,
+				(void *)(uintptr_t)i);
+	}
+	for(i = 0; i < TEST_POST_N_POSTERS; i++){
+		pthread_join(posters[i], NULL);
+	}
+
+	/* Delivers everything still queued */
+	notif_chain_disable_post_queue(&post_notif_chain);
+
+	for(i = 0; i < TEST_POST_N_POSTERS; i++){
+		assert(post_n_got[i] == TEST_POST_N_POSTS);
+	}
+	assert(!post_out_of_order);
+
+	notif_chain_delete(&post_notif_chain);
+	printf("%s() : PASS\n", __FUNCTION__);
+}
+
+int
+main(int argc, char **argv){
+
+	test_key_hash_lookup();
+	test_key_hash_no_comp();
+	test_prefix_trie_lookup();
+	test_rcu_retire_reclaim();
+	test_wide_tlv_round_trip();
+	test_narrow_peer_drop();
+	test_tcp_reassembly();
+	test_bulk_outq_conflation();
+	test_mailbox_poll();
+	test_async_order();
+	test_lane_order();
+	test_conflation_window();
+	test_shard_order();
+	test_fanout_delivery();
+	test_post_queue();
+	printf("All tests passed\n");
+	return 0;
+}
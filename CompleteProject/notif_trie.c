@@ -0,0 +1,172 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  notif_trie.c
+ *
+ *    Description:  This file implements the binary prefix trie used by Notification Chains
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026 11:09:52 AM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Er. Abhishek Sagar, Juniper Networks (https://csepracticals.wixsite.com/csepracticals), sachinites@gmail.com
+ *        Company:  Juniper Networks
+ *
+ *        This file is part of the NotificationChains distribution (https://github.com/sachinites)
+ *        Copynext (c) 2019 Abhishek Sagar.
+ *        This program is free software: you can redistribute it and/or modify it under the terms of the GNU General
+ *        Public License as published by the Free Software Foundation, version 3.
+ *
+ *        This program is distributed in the hope that it will be useful, but
+ *        WITHOUT ANY WARRANTY; without even the implied warranty of
+ *        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *        General Public License for more details.
+ *
+ *        visit website : https://csepracticals.wixsite.com/csepracticals for more courses and projects
+ *
+ * =====================================================================================
+ */
+
+#include <stdlib.h>
+#include <assert.h>
+#include "notif_rcu.h"
+#include "notif_trie.h"
+
+notif_trie_node_t *
+notif_trie_lookup(notif_trie_t *trie,
+				  uint32_t prefix,
+				  uint8_t prefix_len){
+
+	uint8_t depth;
+	notif_trie_node_t *node = NOTIF_RCU_DEREFERENCE(trie->root);
+
+	assert(prefix_len <= NOTIF_TRIE_MAX_PREFIX_LEN);
+
+	for(depth = 0; node && depth < prefix_len; depth++){
+		node = NOTIF_RCU_DEREFERENCE(
+				node->child[NOTIF_TRIE_PREFIX_BIT(prefix, depth)]);
+	}
+	return node;
+}
+
+notif_trie_node_t *
+notif_trie_insert(notif_trie_t *trie,
+				  uint32_t prefix,
+				  uint8_t prefix_len){
+
+	uint8_t depth;
+	notif_trie_node_t **node_slot = &trie->root;
+
+	assert(prefix_len <= NOTIF_TRIE_MAX_PREFIX_LEN);
+
+	for(depth = 0; ; depth++){
+
+		if(!*node_slot){
+			NOTIF_RCU_ASSIGN_POINTER(*node_slot,
+				(notif_trie_node_t *)calloc(1, sizeof(notif_trie_node_t)));
+			trie->n_nodes++;
+		}
+
+		if(depth == prefix_len) break;
+
+		node_slot = &(*node_slot)->child[NOTIF_TRIE_PREFIX_BIT(prefix, depth)];
+	}
+	return *node_slot;
+}
+
+void
+notif_trie_prune(notif_trie_t *trie,
+				 uint32_t prefix,
+				 uint8_t prefix_len){
+
+	int depth;
+	notif_trie_node_t *node;
+	notif_trie_node_t **path[NOTIF_TRIE_MAX_PREFIX_LEN + 1];
+
+	assert(prefix_len <= NOTIF_TRIE_MAX_PREFIX_LEN);
+
+	/* Record the slot holding each node on the path */
+	path[0] = &trie->root;
+
+	for(depth = 0; depth < prefix_len; depth++){
+
+		node = *path[depth];
+		if(!node) return;
+		path[depth + 1] = &node->child[NOTIF_TRIE_PREFIX_BIT(prefix, depth)];
+	}
+
+	for(depth = prefix_len; depth >= 0; depth--){
+
+		node = *path[depth];
+
+		if(!node) continue;
+
+		if(node->data || node->child[0] || node->child[1]) break;
+
+		NOTIF_RCU_ASSIGN_POINTER(*path[depth], NULL);
+		notif_rcu_retire(node, free);
+		trie->n_nodes--;
+	}
+}
+
+void
+notif_trie_walk_covering(notif_trie_t *trie,
+						 uint32_t prefix,
+						 uint8_t prefix_len,
+						 notif_trie_walk_cb cb,
+						 void *arg){
+
+	uint8_t depth;
+	notif_trie_node_t *node = NOTIF_RCU_DEREFERENCE(trie->root);
+
+	assert(prefix_len <= NOTIF_TRIE_MAX_PREFIX_LEN);
+
+	for(depth = 0; node; depth++){
+
+		if(NOTIF_RCU_DEREFERENCE(node->data)) cb(node, arg);
+
+		if(depth == prefix_len) break;
+
+		node = NOTIF_RCU_DEREFERENCE(
+				node->child[NOTIF_TRIE_PREFIX_BIT(prefix, depth)]);
+	}
+}
+
+static void
+notif_trie_walk_subtree(notif_trie_node_t *node,
+						notif_trie_walk_cb cb,
+						void *arg){
+
+	if(!node) return;
+	if(NOTIF_RCU_DEREFERENCE(node->data)) cb(node, arg);
+	notif_trie_walk_subtree(NOTIF_RCU_DEREFERENCE(node->child[0]), cb, arg);
+	notif_trie_walk_subtree(NOTIF_RCU_DEREFERENCE(node->child[1]), cb, arg);
+}
+
+void
+notif_trie_walk_all(notif_trie_t *trie,
+					notif_trie_walk_cb cb,
+					void *arg){
+
+	notif_trie_walk_subtree(NOTIF_RCU_DEREFERENCE(trie->root), cb, arg);
+}
+
+static void
+notif_trie_retire_subtree(notif_trie_node_t *node){
+
+	if(!node) return;
+	notif_trie_retire_subtree(node->child[0]);
+	notif_trie_retire_subtree(node->child[1]);
+	notif_rcu_retire(node, free);
+}
+
+void
+notif_trie_destroy(notif_trie_t *trie){
+
+	notif_trie_node_t *root = trie->root;
+
+	NOTIF_RCU_ASSIGN_POINTER(trie->root, NULL);
+	notif_trie_retire_subtree(root);
+	trie->n_nodes = 0;
+}
@@ -0,0 +1,103 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  notif_trie.h
+ *
+ *    Description:  This file defines the binary prefix trie used by Notification Chains
+ *                  to match published keys against covering prefix subscriptions
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026 11:02:18 AM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Er. Abhishek Sagar, Juniper Networks (https://csepracticals.wixsite.com/csepracticals), sachinites@gmail.com
+ *        Company:  Juniper Networks
+ *
+ *        This file is part of the NotificationChains distribution (https://github.com/sachinites)
+ *        Copynext (c) 2019 Abhishek Sagar.
+ *        This program is free software: you can redistribute it and/or modify it under the terms of the GNU General
+ *        Public License as published by the Free Software Foundation, version 3.
+ *
+ *        This program is distributed in the hope that it will be useful, but
+ *        WITHOUT ANY WARRANTY; without even the implied warranty of
+ *        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *        General Public License for more details.
+ *
+ *        visit website : https://csepracticals.wixsite.com/csepracticals for more courses and projects
+ *
+ * =====================================================================================
+ */
+
+#ifndef __NOTIF_TRIE_H__
+#define __NOTIF_TRIE_H__
+
+#include <stdint.h>
+
+#define NOTIF_TRIE_MAX_PREFIX_LEN	32
+
+/* Bit of prefix examined at depth 'depth', MSB first */
+#define NOTIF_TRIE_PREFIX_BIT(prefix, depth)	\
+	(((prefix) >> (NOTIF_TRIE_MAX_PREFIX_LEN - 1 - (depth))) & 1)
+
+typedef struct notif_trie_node_{
+
+	struct notif_trie_node_ *child[2];
+	/* Application data attached to this exact prefix,
+	 * node is pruned once it has no data and no children */
+	void *data;
+} notif_trie_node_t;
+
+/* A zeroed notif_trie_t is a valid empty trie.
+ * Lookups and walks are safe against one concurrent writer when done
+ * within notif_rcu_read_lock(), pruned nodes are freed through
+ * notif_rcu_retire() */
+typedef struct notif_trie_{
+
+	/* Represents the prefix of length 0 */
+	notif_trie_node_t *root;
+	uint32_t n_nodes;
+} notif_trie_t;
+
+typedef void (*notif_trie_walk_cb)(notif_trie_node_t *node,
+								   void *arg);
+
+/* Returns the node of the exact prefix, NULL if not present */
+notif_trie_node_t *
+notif_trie_lookup(notif_trie_t *trie,
+				  uint32_t prefix,
+				  uint8_t prefix_len);
+
+/* Returns the node of the exact prefix, creating the
+ * nodes on the path as required */
+notif_trie_node_t *
+notif_trie_insert(notif_trie_t *trie,
+				  uint32_t prefix,
+				  uint8_t prefix_len);
+
+/* Frees the nodes on the path of the prefix which are
+ * left with no data and no children, deepest first */
+void
+notif_trie_prune(notif_trie_t *trie,
+				 uint32_t prefix,
+				 uint8_t prefix_len);
+
+/* Invokes cb on every node carrying data whose prefix covers
+ * prefix/prefix_len, shortest prefix first. O(prefix_len) */
+void
+notif_trie_walk_covering(notif_trie_t *trie,
+						 uint32_t prefix,
+						 uint8_t prefix_len,
+						 notif_trie_walk_cb cb,
+						 void *arg);
+
+/* Invokes cb on every node carrying data */
+void
+notif_trie_walk_all(notif_trie_t *trie,
+					notif_trie_walk_cb cb,
+					void *arg);
+
+void
+notif_trie_destroy(notif_trie_t *trie);
+
+#endif /* __NOTIF_TRIE_H__ */
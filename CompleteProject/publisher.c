@@ -35,6 +35,10 @@
 #include <unistd.h>    /*for getpid()*/
 #include <pthread.h>
 #include "notif.h"
+#include "notif_async.h"
+#include "notif_conflate.h"
+#include "notif_fanout.h"
+#include "notif_post.h"
 #include "rt.h"
 #include <sys/socket.h>
 #include <netinet/in.h>
@@ -48,6 +52,10 @@ static notif_chain_t notif_chain;
 static tcp_connections_db_t tcp_connections_db;
 static int choice;
 
+/* Delivery modes, all off by default, see usage() */
+static bool use_async;
+static bool use_post_queue;
+
 void 
 main_menu(rt_table_t *rt){
 
@@ -110,7 +118,18 @@ main_menu(rt_table_t *rt){
                     rc += sizeof(gw);
                     notif_chain_elem.data.app_data_to_notify = data;
                     notif_chain_elem.data.app_data_to_notify_size = rc;
-                    notif_chain_invoke(&notif_chain, &notif_chain_elem);
+                    /* With a post queue, one atomic op, delivery is left
+                     * to the chain's dispatcher and workers, whichever
+                     * thread updates the table */
+                    if(use_post_queue){
+                        notif_chain_post(&notif_chain, &notif_chain_elem);
+                    }
+                    else if(use_async){
+                        notif_chain_invoke_async(&notif_chain, &notif_chain_elem);
+                    }
+                    else {
+                        notif_chain_invoke(&notif_chain, &notif_chain_elem);
+                    }
                 }  
             break;
             case 2:
@@ -164,6 +183,48 @@ rt_entry_comp_fn(void *key_data1,
     return -1;
 }
 
+static uint32_t
+rt_entry_keys_hash_fn(void *key_data,
+                      uint32_t key_data_size){
+
+    rt_entry_keys_t *rt_entry_keys = (rt_entry_keys_t *)key_data;
+
+    /* Not a route's key, all such go to one bucket */
+    if(key_data_size < sizeof(rt_entry_keys_t)) return 0;
+
+    /* Hash only what rt_entry_comp_fn compares */
+    uint32_t hash = notif_hash_bytes(rt_entry_keys->dest,
+                        strnlen(rt_entry_keys->dest, sizeof(rt_entry_keys->dest)),
+                        NOTIF_HASH_SEED);
+    return notif_hash_bytes(&rt_entry_keys->mask,
+                        sizeof(rt_entry_keys->mask), hash);
+}
+
+static bool
+rt_entry_keys_prefix_fn(void *key_data,
+                        uint32_t key_data_size,
+                        uint32_t *prefix,
+                        uint8_t *prefix_len){
+
+    uint32_t addr;
+    char dest[sizeof(((rt_entry_keys_t *)0)->dest) + 1];
+    rt_entry_keys_t *rt_entry_keys = (rt_entry_keys_t *)key_data;
+
+    if(key_data_size < sizeof(rt_entry_keys_t)) return false;
+
+    if(rt_entry_keys->mask < 0 || rt_entry_keys->mask > 32) return false;
+
+    memset(dest, 0, sizeof(dest));
+    strncpy(dest, rt_entry_keys->dest, sizeof(rt_entry_keys->dest));
+
+    if(inet_pton(AF_INET, dest, &addr) != 1) return false;
+
+    *prefix_len = (uint8_t)rt_entry_keys->mask;
+    *prefix = *prefix_len ?
+        ntohl(addr) & (0xFFFFFFFFU << (32 - *prefix_len)) : 0;
+    return true;
+}
+
 static char *
 rt_entry_keys_print_fn(void *keys, uint32_t key_size,
                       char *output_buff, uint32_t buff_size){
@@ -193,9 +254,56 @@ tcp_subscriber_killed_notification(char *ip_addr,
 		 __FUNCTION__, ip_addr, tcp_port_no);
 }
 
+static void
+usage(char *prog_name){
+
+    printf("Usage : %s [-p] [-a] [-f] [-q] [-c] [-o]\n", prog_name);
+    printf("\t-p : Prefix match, keyed publishes go through the prefix\n"
+           "\t     trie in place of the key hash index\n");
+    printf("\t-a : Deliver through the async worker pool\n");
+    printf("\t-f : Fan large subscriber sets out over several threads\n");
+    printf("\t-q : Post updates to the chain's queue\n");
+    printf("\t-c : Conflate updates of a route within %d ms\n",
+            NOTIF_CONFLATE_DEFAULT_WINDOW_MS);
+    printf("\t-o : Conflate by route the socket subscribers' queues\n");
+    printf("Without options, every update is delivered synchronously\n");
+}
+
 int
 main(int argc, char **argv){
 
+    int opt;
+    bool use_prefix_match = false;
+    bool use_fanout = false;
+    bool use_conflation = false;
+    bool use_outq_conflation = false;
+
+    while((opt = getopt(argc, argv, "pafqcoh")) != -1){
+        switch(opt){
+            case 'p':
+                use_prefix_match = true;
+                break;
+            case 'a':
+                use_async = true;
+                break;
+            case 'f':
+                use_fanout = true;
+                break;
+            case 'q':
+                use_post_queue = true;
+                break;
+            case 'c':
+                use_conflation = true;
+                break;
+            case 'o':
+                use_outq_conflation = true;
+                break;
+            default:
+                usage(argv[0]);
+                exit(opt == 'h' ? 0 : 1);
+        }
+    }
+
     /*Published is in-charge of the Data source
      * i.e. Routing Table in this example*/
     rt_table_t rt;
@@ -207,7 +315,47 @@ main(int argc, char **argv){
     notif_chain_init(&notif_chain,
         "notif_chain_rt_table",
         rt_entry_comp_fn,
-        rt_entry_keys_print_fn);
+        rt_entry_keys_print_fn,
+        rt_entry_keys_hash_fn);
+
+    /* Subscribers may register for a covering prefix, say
+     * 122.1.0.0/16, and get notified for every route under it */
+    if(use_prefix_match){
+        notif_chain_enable_prefix_match(&notif_chain,
+            rt_entry_keys_prefix_fn);
+    }
+
+    /* Workers which deliver the routing table updates to
+     * subscribers on behalf of the publisher */
+    if(use_async){
+        notif_async_start(NOTIF_ASYNC_DEFAULT_WORKERS);
+    }
+
+    /* A route with a great many subscribers is delivered
+     * by several threads at once */
+    if(use_fanout){
+        notif_fanout_start(NOTIF_FANOUT_DEFAULT_WORKERS);
+    }
+
+    /* Table writers post their updates to the chain's queue
+     * and move on */
+    if(use_post_queue){
+        notif_chain_enable_post_queue(&notif_chain);
+    }
+
+    /* A route flapping within the window reaches the
+     * subscribers once, in its latest state */
+    if(use_conflation){
+        notif_chain_enable_conflation(&notif_chain,
+            NOTIF_CONFLATE_DEFAULT_WINDOW_MS);
+    }
+
+    /* Socket subscribers which fall behind get the latest
+     * state of each route rather than every change */
+    if(use_outq_conflation){
+        notif_outq_set_default_policy(NOTIF_OUTQ_CONFLATE_BY_KEY,
+            NOTIF_OUTQ_DEFAULT_MAX_DEPTH);
+    }
 
     /* We will create a thread which will be act 
      * as a subscriber to publisher to allow 
@@ -48,7 +48,12 @@ process_remote_msgs(char *recv_msg_buffer,
         			uint32_t sender_port_number,
         			uint32_t udp_sock_fd){
 
-	printf("%s() called\n", __FUNCTION__);
+	uint32_t n_notifs;
+
+	n_notifs = notif_chain_for_each_notification(recv_msg_buffer,
+			recv_msg_buffer_size, notif_chain_print_notification, NULL);
+
+	printf("%s() : %u notifications\n", __FUNCTION__, n_notifs);
 }
 
 int udp_sock_fd = -1;
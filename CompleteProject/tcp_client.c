@@ -96,10 +96,16 @@ PROMPT_USER:
 		exit(0);
 	}
     
-    /*step 5 : send the data to server*/
+    /*step 5 : send the data to server, behind its length as the
+     * server splits the stream into messages along it*/
+    uint32_t msg_len_prefix = htonl(sizeof(test_struct_t));
+    char msg[sizeof(msg_len_prefix) + sizeof(test_struct_t)];
+    memcpy(msg, &msg_len_prefix, sizeof(msg_len_prefix));
+    memcpy(msg + sizeof(msg_len_prefix), &client_data, sizeof(test_struct_t));
+
     sent_recv_bytes = sendto(sockfd, 
-           &client_data,
-           sizeof(test_struct_t), 
+           msg,
+           sizeof(msg), 
            0, 
            (struct sockaddr *)&dest, 
            sizeof(struct sockaddr));
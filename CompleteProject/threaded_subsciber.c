@@ -36,6 +36,7 @@
 #include <pthread.h>
 #include <stdbool.h>
 #include "notif.h"
+#include "notif_mailbox.h"
 #include "rt.h"
 
 void
@@ -50,35 +51,73 @@ test_cb(notif_chain_elem_t *notif_chain_elem){
         (char *)notif_chain_elem->data.app_data_to_notify);
 }
 
+/* Notifications are run here, on the subscriber's thread,
+ * rather than on the publisher's */
+static void
+subscriber_process_notifications(notif_mailbox_t *mailbox){
+
+    while(1){
+        notif_mailbox_wait(mailbox);
+        while(notif_mailbox_drain(mailbox, NOTIF_MAILBOX_DEFAULT_BATCH));
+    }
+}
+
 static void *
 subscriber_thread_fn(void *arg){
 
    
     uint32_t client_id = (uint32_t)arg;
+    notif_mailbox_t *mailbox;
+
+    mailbox = notif_mailbox_create(NOTIF_MAILBOX_DEFAULT_SIZE, test_cb);
 
     if(client_id == 1){
         
-        notif_chain_subscribe_by_callback("notif_chain_rt_table", 0, 0, client_id, test_cb);
-        pause();
+        notif_chain_subscribe_by_mailbox("notif_chain_rt_table", 0, 0, client_id, mailbox);
+        subscriber_process_notifications(mailbox);
     }
     /* Do registration with Notification Chain.
-     * This code acts as a client/subscriber code*/
-    rt_entry_keys_t rt_entry_keys;
-    memset(&rt_entry_keys, 0, sizeof(rt_entry_keys_t));
+     * This code acts as a client/subscriber code.
+     * All routes are registered in one go*/
+    int i;
+    char *dests[] = {"122.1.1.1", "122.1.1.2", "122.1.1.3"};
+    rt_entry_keys_t rt_entry_keys[3];
+    notif_chain_elem_t notif_chain_elems[3];
+    bool subscribed[3];
+    notif_chain_comm_channel_t notif_chain_comm_channel;
 
-    strncpy(rt_entry_keys.dest, "122.1.1.1", 16);
-    rt_entry_keys.mask = 32;
-    notif_chain_subscribe_by_callback("notif_chain_rt_table", &rt_entry_keys, sizeof(rt_entry_keys_t), client_id, test_cb);
-    
-	strncpy(rt_entry_keys.dest, "122.1.1.2", 16);
-    rt_entry_keys.mask = 32;
-    notif_chain_subscribe_by_callback("notif_chain_rt_table", &rt_entry_keys, sizeof(rt_entry_keys_t), client_id, test_cb);
+    memset(&notif_chain_comm_channel, 0, sizeof(notif_chain_comm_channel_t));
+    notif_chain_comm_channel.notif_ch_type = NOTIF_C_CALLBACKS;
+    NOTIF_CHAIN_ELEM_APP_CB(&notif_chain_comm_channel) = test_cb;
+    NOTIF_CHAIN_ELEM_MAILBOX(&notif_chain_comm_channel) = mailbox;
 
-    strncpy(rt_entry_keys.dest, "122.1.1.3", 16);
-    rt_entry_keys.mask = 32;
-    notif_chain_subscribe_by_callback("notif_chain_rt_table", &rt_entry_keys, sizeof(rt_entry_keys_t), client_id, test_cb);
+    memset(rt_entry_keys, 0, sizeof(rt_entry_keys));
+    memset(notif_chain_elems, 0, sizeof(notif_chain_elems));
+
+    for(i = 0; i < 3; i++){
+
+        strncpy(rt_entry_keys[i].dest, dests[i], 16);
+        rt_entry_keys[i].mask = 32;
+
+        notif_chain_elems[i].client_id = client_id;
+        notif_chain_elems[i].notif_code = SUBS_TO_PUB_NOTIF_C_SUBSCRIBE;
+        notif_chain_elems[i].data.app_key_data = &rt_entry_keys[i];
+        notif_chain_elems[i].data.app_key_data_size = sizeof(rt_entry_keys_t);
+        notif_chain_elems[i].notif_chain_comm_channel = &notif_chain_comm_channel;
+    }
+    if(notif_chain_subscribe_bulk("notif_chain_rt_table",
+            notif_chain_elems, 3, subscribed) != 3){
+
+        for(i = 0; i < 3; i++){
+            if(!subscribed[i]){
+                printf("Client %u : subscription to %s/32 rejected\n",
+                    client_id, dests[i]);
+            }
+        }
+    }
     
-	pause();
+    subscriber_process_notifications(mailbox);
+    return NULL;
 }
 
 void
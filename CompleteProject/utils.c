@@ -60,22 +60,41 @@ tcp_ip_covert_ip_p_to_n(char *ip_addr){
 }
 
 char *
-tlv_buffer_insert_tlv(char *buff, uint8_t tlv_no,
-                     uint8_t data_len, char *data){
+tlv_buffer_insert_tlv_header(char *buff, uint8_t tlv_no,
+                     uint32_t data_len){
+
+    if(TLV_IS_WIDE(data_len)){
+        /* Wide form, see TLV_WIDE_FLAG */
+        *buff = tlv_no | TLV_WIDE_FLAG;
+        *(buff + 1) = (char)(data_len >> 24);
+        *(buff + 2) = (char)(data_len >> 16);
+        *(buff + 3) = (char)(data_len >> 8);
+        *(buff + 4) = (char)data_len;
+        return buff + TLV_WIDE_OVERHEAD_SIZE;
+    }
 
     *buff = tlv_no;
     *(buff+ sizeof(tlv_no)) = data_len;
-    memcpy(buff + TLV_OVERHEAD_SIZE, data, data_len);
-    return buff + TLV_OVERHEAD_SIZE + data_len;
+    return buff + TLV_OVERHEAD_SIZE;
+}
+
+char *
+tlv_buffer_insert_tlv(char *buff, uint8_t tlv_no,
+                     uint32_t data_len, char *data){
+
+    buff = tlv_buffer_insert_tlv_header(buff, tlv_no, data_len);
+    memcpy(buff, data, data_len);
+    return buff + data_len;
 }
 
 char *
 tlv_buffer_get_particular_tlv(char *tlv_buff, /*Input TLV Buffer*/
                       uint32_t tlv_buff_size, /*Input TLV Buffer Total Size*/
                       uint8_t tlv_no,         /*Input TLV Number*/
-                      uint8_t *tlv_data_len){ /*Output TLV Data len*/
+                      uint32_t *tlv_data_len){ /*Output TLV Data len*/
 
-    uint8_t tlv_type, tlv_len, *tlv_value = NULL;
+    uint8_t tlv_type, *tlv_value = NULL;
+    uint32_t tlv_len;
     
     ITERATE_TLV_BEGIN(tlv_buff, tlv_type, tlv_len, tlv_value, tlv_buff_size){
         
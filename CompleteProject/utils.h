@@ -40,6 +40,22 @@
 
 #define TLV_OVERHEAD_SIZE  2 /* 1 Bytes for TYPE, 1 Byte for value len*/
 
+/* Values longer than UINT8_MAX are carried in the wide form : the
+ * TYPE byte has TLV_WIDE_FLAG set, and is followed by a 4 Bytes value
+ * len in network byte order. Short values keep the 2 Bytes header, so
+ * peers which only know the short form decode them unchanged. TLV
+ * types must therefore stay below TLV_WIDE_FLAG */
+#define TLV_WIDE_FLAG           0x80
+#define TLV_WIDE_OVERHEAD_SIZE  5 /* 1 Bytes for TYPE, 4 Bytes for value len*/
+
+/* A peer may only be sent wide TLVs once it told it can take them,
+ * see NOTIF_C_CAP_WIDE_TLV */
+#define TLV_IS_WIDE(data_len)   ((data_len) > UINT8_MAX)
+
+#define TLV_ENCODED_SIZE(data_len)                                              \
+    (TLV_IS_WIDE(data_len) ?                                                    \
+        TLV_WIDE_OVERHEAD_SIZE + (data_len) : TLV_OVERHEAD_SIZE + (data_len))
+
 #define FIELD_SIZE(struct_name, field_name) \
     (sizeof(((struct_name *)0)->field_name))
 
@@ -51,21 +67,34 @@
 /*Macro to Type Length Value reply
  * uint8_t * - start_ptr, IN
  * uint8_t - type, OUT
- * uint8_t - length, OUT
+ * uint32_t - length, OUT
  * uint8_t * - tlv_ptr, OUT
  * unsigned int - total_size(excluding first 8 bytes), IN
+ * Iteration stops at the first TLV overrunning total_size
  * */
 #define ITERATE_TLV_BEGIN(start_ptr, type, length, tlv_ptr, tlv_size)           \
 {                                                                               \
-    unsigned int _len = 0; uint8_t _tlv_value_size = 0;                         \
+    unsigned int _len = 0; uint32_t _tlv_hdr_size = 0;                          \
+    uint8_t *_tlv_start = (uint8_t *)(start_ptr);                               \
     type = 0; length = 0; tlv_ptr = NULL;                                       \
-    for(tlv_ptr = (uint8_t *)start_ptr +                                        \
-             TLV_OVERHEAD_SIZE; _len < tlv_size;                                \
-            _len += _tlv_value_size + TLV_OVERHEAD_SIZE,                        \
-             tlv_ptr = (tlv_ptr + TLV_OVERHEAD_SIZE + length)){                 \
-        type = *(uint8_t *)(tlv_ptr - TLV_OVERHEAD_SIZE);                       \
-        _tlv_value_size = (uint8_t)(*(tlv_ptr - sizeof(uint8_t)));              \
-        length = _tlv_value_size;
+    for(; _len + TLV_OVERHEAD_SIZE <= (tlv_size);                               \
+            _len += _tlv_hdr_size + length){                                    \
+        type = _tlv_start[_len];                                                \
+        if(type & TLV_WIDE_FLAG){                                               \
+            if(_len + TLV_WIDE_OVERHEAD_SIZE > (tlv_size)) break;               \
+            type &= ~TLV_WIDE_FLAG;                                             \
+            length = ((uint32_t)_tlv_start[_len + 1] << 24) |                   \
+                     ((uint32_t)_tlv_start[_len + 2] << 16) |                   \
+                     ((uint32_t)_tlv_start[_len + 3] << 8)  |                   \
+                      (uint32_t)_tlv_start[_len + 4];                           \
+            _tlv_hdr_size = TLV_WIDE_OVERHEAD_SIZE;                             \
+        }                                                                       \
+        else{                                                                   \
+            length = _tlv_start[_len + 1];                                      \
+            _tlv_hdr_size = TLV_OVERHEAD_SIZE;                                  \
+        }                                                                       \
+        if(length > (tlv_size) - _len - _tlv_hdr_size) break;                   \
+        tlv_ptr = _tlv_start + _len + _tlv_hdr_size;
 
 #define ITERATE_TLV_END(start_ptr, type, length, tlv_ptr, tlv_size)             \
     }}
@@ -74,11 +103,16 @@ char *
 tlv_buffer_get_particular_tlv(char *tlv_buff, /*Input TLV Buffer*/
                               uint32_t tlv_buff_size, /*Input TLV Buffer Total Size*/
                               uint8_t tlv_no, /*Input TLV Number*/
-                              uint8_t *tlv_data_len); /*Output TLV Data len*/
+                              uint32_t *tlv_data_len); /*Output TLV Data len*/
 
 char *
 tlv_buffer_insert_tlv(char *tlv_buff, uint8_t tlv_no, 
-                     uint8_t data_len, char *data);
+                     uint32_t data_len, char *data);
+
+/* Writes TYPE and value len only, the value is the caller's to write */
+char *
+tlv_buffer_insert_tlv_header(char *tlv_buff, uint8_t tlv_no,
+                     uint32_t data_len);
 
 char *
 tcp_ip_covert_ip_n_to_p(uint32_t ip_addr, 